@@ -0,0 +1,90 @@
+#!/usr/bin/python3 -OO
+"""
+Replay a captured NNTP stream through the Decoder, plain and under COMPRESS DEFLATE.
+
+Without a capture, a synthetic one is built from the test articles and a block of
+overview lines, which is the traffic compression actually helps with. The stream is
+deflated once up front, sync flushed per write the way a server does, so the timings
+cover inflate and decode only.
+
+    python benchmarks/compression.py [capture] [--read-size N] [--rounds N]
+"""
+
+import argparse
+import glob
+import os
+import time
+import zlib
+
+import sabctools
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+
+def synthetic_stream() -> bytes:
+    articles = b""
+    for path in sorted(glob.glob(os.path.join(HERE, "..", "tests", "yencfiles", "test_regular*.yenc"))):
+        with open(path, "rb") as f:
+            articles += f.read()
+    overview = b"".join(
+        b"%d\t[%d/50] - \"file.part%02d.rar\" yEnc (1/100)\tposter <p@example.com>\t"
+        b"Sat, 01 Jan 2022 00:00:00 GMT\t<%d.part@example.com>\t\t740059\t5768\r\n" % (n, n % 50, n % 50, n)
+        for n in range(50000)
+    )
+    return (b"224 overview follows\r\n" + overview + b".\r\n" + articles) * 4
+
+
+def deflate(payload: bytes, write_size: int) -> bytes:
+    compressor = zlib.compressobj(wbits=-15)
+    out = bytearray()
+    for start in range(0, len(payload), write_size):
+        out += compressor.compress(payload[start : start + write_size])
+        out += compressor.flush(zlib.Z_SYNC_FLUSH)
+    return bytes(out)
+
+
+def replay(wire: bytes, read_size: int, compressed: bool) -> float:
+    decoder = sabctools.Decoder(1024 * 1024)
+    if compressed:
+        decoder.enable_compression()
+    source = memoryview(wire)
+    start = time.perf_counter()
+    position = 0
+    while position < len(source):
+        view = memoryview(decoder)
+        n = min(len(view), read_size, len(source) - position)
+        view[:n] = source[position : position + n]
+        view.release()
+        decoder.process(n)
+        position += n
+        for _ in decoder:
+            pass
+    return time.perf_counter() - start
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("capture", nargs="?", help="raw server-to-client bytes, uncompressed")
+    parser.add_argument("--read-size", type=int, default=64 * 1024)
+    parser.add_argument("--rounds", type=int, default=5)
+    args = parser.parse_args()
+
+    if args.capture:
+        with open(args.capture, "rb") as f:
+            plain = f.read()
+    else:
+        plain = synthetic_stream()
+    wire = deflate(plain, 16 * 1024)
+
+    print(f"stream {len(plain) / 1e6:.1f} MB, deflated {len(wire) / 1e6:.1f} MB, ratio {len(plain) / len(wire):.2f}")
+    for compressed, payload in ((False, plain), (True, wire)):
+        best = min(replay(payload, args.read_size, compressed) for _ in range(args.rounds))
+        label = "deflate" if compressed else "plain"
+        print(
+            f"{label:8} {len(plain) / best / 1e6:8.1f} MB/s decoded"
+            f" {len(payload) / best / 1e6:8.1f} MB/s off the wire"
+        )
+
+
+if __name__ == "__main__":
+    main()
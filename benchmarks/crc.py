@@ -0,0 +1,70 @@
+#!/usr/bin/python3 -OO
+"""
+CRC32 throughput, over many small buffers and over one large buffer or file.
+
+For each buffer size, --total bytes are split into buffers of that size and hashed
+three ways: crc32_many over the whole list, the same kernel called once per buffer
+from Python, and zlib.crc32 in a loop for reference.
+
+Then a --large buffer, and a file of the same size, are hashed by crc32 on each of
+--threads threads, against zlib.crc32 over the buffer.
+
+    python benchmarks/crc.py [--sizes BYTES ...] [--total BYTES] [--large BYTES]
+                             [--threads N ...] [--rounds N]
+"""
+
+import argparse
+import os
+import tempfile
+import time
+import zlib
+
+import sabctools
+
+
+def best_of(rounds: int, function) -> float:
+    best = float("inf")
+    for _ in range(rounds):
+        start = time.perf_counter()
+        function()
+        best = min(best, time.perf_counter() - start)
+    return best
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--sizes", type=int, nargs="+", default=[1024, 4096, 16384, 65536])
+    parser.add_argument("--total", type=int, default=64 << 20)
+    parser.add_argument("--large", type=int, default=512 << 20)
+    parser.add_argument("--threads", type=int, nargs="+", default=[1, 2, 4, os.cpu_count() or 1])
+    parser.add_argument("--rounds", type=int, default=5)
+    args = parser.parse_args()
+
+    data = os.urandom(args.total)
+    print(f"{args.total / 1e6:.0f} MB per run, crc {sabctools.crc_simd}")
+    print(f"  {'size':>8} {'crc32_many':>12} {'per buffer':>12} {'zlib':>12}  MB/s")
+    for size in args.sizes:
+        buffers = [data[start : start + size] for start in range(0, len(data), size)]
+        many = best_of(args.rounds, lambda: sabctools.crc32_many(buffers))
+        single = best_of(args.rounds, lambda: [sabctools.crc32(buffer) for buffer in buffers])
+        reference = best_of(args.rounds, lambda: [zlib.crc32(buffer) for buffer in buffers])
+        rates = [len(data) / 1e6 / elapsed for elapsed in (many, single, reference)]
+        print(f"  {size:>8} {rates[0]:>12.1f} {rates[1]:>12.1f} {rates[2]:>12.1f}")
+
+    large = os.urandom(args.large)
+    print(f"{args.large / 1e6:.0f} MB in one piece")
+    elapsed = best_of(args.rounds, lambda: zlib.crc32(large))
+    print(f"  zlib.crc32            {args.large / 1e6 / elapsed:8.1f} MB/s")
+    with tempfile.TemporaryDirectory() as workdir:
+        path = os.path.join(workdir, "large.bin")
+        with open(path, "wb") as f:
+            f.write(large)
+        for threads in sorted(set(args.threads)):
+            memory = best_of(args.rounds, lambda: sabctools.crc32(large, threads=threads))
+            file = best_of(args.rounds, lambda: sabctools.crc32(path, threads=threads))
+            print(f"  crc32 {threads:3d} threads  buffer {args.large / 1e6 / memory:8.1f} MB/s"
+                  f"  file {args.large / 1e6 / file:8.1f} MB/s")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,81 @@
+#!/usr/bin/python3 -OO
+"""
+yEnc decode throughput with the CRC folded in, across many connections at once.
+
+--connections Decoders are fed --read-size pieces of their own articles round robin,
+as an event loop serving that many sockets would, so each one's data has left the
+cache by the time it is next touched. The decoder hashes each block of output while it
+is still in L1; to compare with the earlier decode-then-hash path, build the previous
+commit into a directory and pass it as --baseline, which runs the same measurement
+against that build in a child process.
+
+    python benchmarks/decode_crc.py [--connections N] [--size BYTES] [--baseline DIR]
+"""
+
+import argparse
+import os
+import subprocess
+import sys
+import time
+
+import sabctools
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+sys.path.insert(0, os.path.dirname(HERE))
+
+from tests.nntpserver import dot_stuff, yenc_article
+
+
+def measure(args) -> float:
+    payload = os.urandom(args.size)
+    wire = b"222 0 <bench@test>\r\n" + dot_stuff(yenc_article(payload, "bench.bin")) + b".\r\n"
+    decoders = [sabctools.Decoder(args.read_size) for _ in range(args.connections)]
+    source = memoryview(wire)
+
+    best = float("inf")
+    for _ in range(args.rounds):
+        start = time.perf_counter()
+        for _ in range(args.articles):
+            position = 0
+            while position < len(source):
+                n = min(args.read_size, len(source) - position)
+                piece = source[position : position + n]
+                for decoder in decoders:
+                    memoryview(decoder)[:n] = piece
+                    decoder.process(n)
+                    for response in decoder:
+                        assert response.crc == response.crc_expected
+                position += n
+        best = min(best, time.perf_counter() - start)
+    return len(wire) * args.articles * args.connections / 1e6 / best
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--connections", type=int, default=200)
+    parser.add_argument("--size", type=int, default=716800, help="decoded bytes per article")
+    parser.add_argument("--articles", type=int, default=5, help="articles per connection")
+    parser.add_argument("--read-size", type=int, default=256 * 1024)
+    parser.add_argument("--rounds", type=int, default=3)
+    parser.add_argument("--baseline", help="directory holding another sabctools build to compare with")
+    parser.add_argument("--quiet", action="store_true", help=argparse.SUPPRESS)
+    args = parser.parse_args()
+
+    throughput = measure(args)
+    if args.quiet:
+        print(throughput)
+        return
+    print(f"{args.connections} connections, {args.size}-byte articles, simd {sabctools.simd}, crc {sabctools.crc_simd}")
+    print(f"  this build  {throughput:8.1f} MB/s")
+    if args.baseline:
+        command = [sys.executable, __file__, "--quiet"] + [
+            "--%s=%s" % (name.replace("_", "-"), getattr(args, name))
+            for name in ("connections", "size", "articles", "read_size", "rounds")
+        ]
+        environment = dict(os.environ, PYTHONPATH=args.baseline)
+        baseline = float(subprocess.run(command, env=environment, capture_output=True, check=True).stdout)
+        print(f"  baseline    {baseline:8.1f} MB/s")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,80 @@
+#!/usr/bin/python3 -OO
+"""
+Posting throughput: a file turned into articles with encode_file on 1..N threads,
+against build_article over an mmap of the same file on the calling thread.
+
+The file is random data, written once to a temporary directory and read back from
+the page cache, so what is measured is encoding and CRC rather than the disk. With
+--baseline, the same file is also run through another sabctools build, in a child
+process, for before and after numbers.
+
+    python benchmarks/encode.py [--size BYTES] [--part-size BYTES] [--threads N ...]
+                                [--baseline DIR]
+"""
+
+import argparse
+import mmap
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+import sabctools
+
+
+def build_articles(path: str, part_size: int) -> float:
+    start = time.perf_counter()
+    with open(path, "rb") as f, mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ) as source:
+        total = (len(source) + part_size - 1) // part_size
+        crc = 0
+        for part, begin in enumerate(range(0, len(source), part_size), start=1):
+            end = min(begin + part_size, len(source))
+            _, _, crc = sabctools.build_article(source, part, total, begin, end, "file.bin", crc=crc)
+    return time.perf_counter() - start
+
+
+def encode_file(path: str, part_size: int, threads: int) -> float:
+    start = time.perf_counter()
+    with sabctools.encode_file(path, part_size=part_size, threads=threads) as articles:
+        for _ in articles:
+            pass
+    return time.perf_counter() - start
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--size", type=int, default=500_000_000)
+    parser.add_argument("--part-size", type=int, default=716800)
+    parser.add_argument("--threads", type=int, nargs="+", default=[1, 2, 4, os.cpu_count() or 1])
+    parser.add_argument("--rounds", type=int, default=3)
+    parser.add_argument("--baseline", help="directory holding another sabctools build to compare with")
+    args = parser.parse_args()
+
+    with tempfile.TemporaryDirectory() as workdir:
+        path = os.path.join(workdir, "file.bin")
+        with open(path, "wb") as f:
+            for _ in range(0, args.size, 1 << 24):
+                f.write(os.urandom(min(1 << 24, args.size - f.tell())))
+
+        print(f"{args.size / 1e6:.0f} MB in {args.part_size}-byte parts, simd {sabctools.simd}", flush=True)
+        run(args, path)
+
+    if args.baseline:
+        # A file of its own, written by the child, so both runs start from the same state
+        print(f"baseline {args.baseline}:", flush=True)
+        command = [sys.executable, __file__, "--size", str(args.size), "--part-size", str(args.part_size),
+                   "--rounds", str(args.rounds), "--threads"] + [str(threads) for threads in args.threads]
+        subprocess.run(command, env=dict(os.environ, PYTHONPATH=args.baseline), check=True)
+
+
+def run(args, path: str):
+    best = min(build_articles(path, args.part_size) for _ in range(args.rounds))
+    print(f"  build_article           {args.size / 1e6 / best:8.1f} MB/s", flush=True)
+    for threads in sorted(set(args.threads)):
+        best = min(encode_file(path, args.part_size, threads) for _ in range(args.rounds))
+        print(f"  encode_file {threads:3d} threads {args.size / 1e6 / best:8.1f} MB/s", flush=True)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,169 @@
+#!/usr/bin/python3 -OO
+"""
+Streaming into a FileWriter with pwrite, io_uring, direct I/O and a writeback window.
+
+--connections Decoders are fed --read-size pieces of their articles round robin, as an
+event loop serving that many sockets would, each decoding into one shared FileWriter
+at the article's offset. With pwrite every flush of a connection's staging buffer
+waits for the write; with io_uring it is submitted and settled on the next flush or
+when the response is collected, so the decode thread carries on meanwhile. Direct
+writes send the aligned middle of each flush around the page cache. A writeback
+window of --writeback bytes pushes data out as the download moves on and drops it from
+the cache once it is on disk.
+
+Reports throughput, the slowest process() calls, which is where a write that blocks
+shows up, and on Linux how much the page cache grew. Write to a real disk with --dir:
+on tmpfs a write never blocks and direct I/O is refused.
+
+Then an article cache flushing a burst of decoded articles to one file: write() per
+article against one write_many(), at --flush-size bytes per article, since the cache
+also holds small articles and the last part of every file.
+
+    python benchmarks/filewriter.py [--connections N] [--articles N] [--size BYTES] [--dir PATH]
+                                    [--writeback BYTES] [--flush-size BYTES]
+"""
+
+import argparse
+import os
+import sys
+import tempfile
+import time
+
+import sabctools
+
+
+def build_wire(payload: bytes, number: int, total: int) -> bytes:
+    encoded, crc = sabctools.yenc_encode(payload)
+    begin = number * len(payload)
+    head = b"=ybegin part=%d line=128 size=%d name=bench.bin\r\n" % (number + 1, total)
+    head += b"=ypart begin=%d end=%d\r\n" % (begin + 1, begin + len(payload))
+    tail = b"=yend size=%d part=%d pcrc32=%08x\r\n" % (len(payload), number + 1, crc)
+    return b"222 0 <%d@bench>\r\n" % number + head + encoded + b"\r\n" + tail + b".\r\n"
+
+
+def cached_bytes() -> int:
+    """The page cache's size from /proc/meminfo, 0 where there is none"""
+    try:
+        with open("/proc/meminfo") as meminfo:
+            for line in meminfo:
+                if line.startswith("Cached:"):
+                    return int(line.split()[1]) * 1024
+    except OSError:
+        pass
+    return 0
+
+
+def stream(args, wires: list, path: str, **options):
+    writer = sabctools.FileWriter(path, **options)
+    writer.preallocate(args.articles * args.size)
+    decoders = [sabctools.Decoder(args.read_size) for _ in range(args.connections)]
+    # Each connection takes every connections-th article
+    queues = [list(range(index, args.articles, args.connections)) for index in range(args.connections)]
+    positions = [0] * args.connections
+    stalls = []
+    decoded = 0
+
+    cached = cached_bytes()
+    start = time.perf_counter()
+    active = True
+    while active:
+        active = False
+        for index, decoder in enumerate(decoders):
+            queue = queues[index]
+            if not queue:
+                continue
+            active = True
+            if positions[index] == 0:
+                decoder.expect(queue[0], writer)
+            source = wires[queue[0]]
+            view = memoryview(decoder)
+            count = min(len(view), len(source) - positions[index])
+            view[:count] = source[positions[index] : positions[index] + count]
+            view.release()
+
+            began = time.perf_counter()
+            decoder.process(count)
+            for response in decoder:
+                assert not response.sink_failed, response.sink_error
+                decoded += response.bytes_decoded
+            stalls.append(time.perf_counter() - began)
+
+            positions[index] += count
+            if positions[index] == len(source):
+                positions[index] = 0
+                queue.pop(0)
+    writer.close()
+    elapsed = time.perf_counter() - start
+    cached = cached_bytes() - cached
+
+    stalls.sort()
+    if options.get("direct"):
+        used = writer.direct
+    elif options.get("writeback"):
+        used = writer.writeback != 0
+    else:
+        used = writer.io_uring if options.get("io_uring") else True
+    return decoded / elapsed / 1e6, stalls[len(stalls) * 99 // 100] * 1e3, stalls[-1] * 1e3, cached / 1e6, used
+
+
+def flush_burst(args, path: str, batched: bool) -> float:
+    articles = [os.urandom(args.flush_size) for _ in range(args.articles)]
+    items = [(data, index * args.flush_size) for index, data in enumerate(articles)]
+    # Shuffled the way a cache keyed by article would hand them over
+    items = items[1::2] + items[::2]
+    best = float("inf")
+    for _ in range(5):
+        with sabctools.FileWriter(path) as writer:
+            start = time.perf_counter()
+            if batched:
+                assert all(writer.write_many(items))
+            else:
+                for data, offset in items:
+                    writer.write(data, offset)
+            best = min(best, time.perf_counter() - start)
+        os.unlink(path)
+    return best
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--connections", type=int, default=50)
+    parser.add_argument("--articles", type=int, default=1000)
+    parser.add_argument("--size", type=int, default=716800, help="decoded bytes per article")
+    parser.add_argument("--read-size", type=int, default=256 * 1024)
+    parser.add_argument("--dir", default=None, help="where to write, by default the temporary directory")
+    parser.add_argument("--writeback", type=int, default=16 << 20, help="bytes per writeback window")
+    parser.add_argument("--flush-size", type=int, default=16384, help="bytes per article in the cache flush")
+    args = parser.parse_args()
+
+    # Distinct articles so the file is really written, but only a few encodings of data
+    payloads = [os.urandom(args.size) for _ in range(4)]
+    total = args.articles * args.size
+    wires = [build_wire(payloads[number % 4], number, total) for number in range(args.articles)]
+    print(f"{args.articles} articles of {args.size} bytes over {args.connections} connections")
+
+    with tempfile.TemporaryDirectory(dir=args.dir) as workdir:
+        modes = (
+            ("pwrite", {}),
+            ("io_uring", {"io_uring": True}),
+            ("direct", {"direct": True}),
+            ("writeback", {"writeback": args.writeback}),
+        )
+        for name, options in modes:
+            path = os.path.join(workdir, "bench.bin")
+            rate, p99, worst, cached, used = stream(args, wires, path, **options)
+            os.unlink(path)
+            if not used:
+                name += " (unavailable, so pwrite)"
+            print(f"  {name:10} {rate:8.1f} MB/s   process() p99 {p99:6.2f} ms, worst {worst:7.2f} ms   "
+                  f"page cache {cached:+8.1f} MB")
+
+        print(f"cache flush of {args.articles} articles of {args.flush_size} bytes")
+        path = os.path.join(workdir, "flush.bin")
+        for name, batched in (("write", False), ("write_many", True)):
+            elapsed = flush_burst(args, path, batched)
+            print(f"  {name:10} {args.articles / elapsed:10.0f} articles/s")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,113 @@
+#!/usr/bin/python3 -OO
+"""
+Many threads writing small pieces into one FileWriter.
+
+Each of --threads threads writes --writes pieces of --write-size bytes into a region of
+its own in one shared file, and every --size-every writes asks for the writer's size,
+the way decode threads finishing articles into the same download would. The bytes are
+only copied into the page cache, so what this measures is the cost of getting in and out
+of the writer for every call, and how that scales with the number of threads on it.
+With --size-only the threads do nothing but ask for the size, a single fstat, so getting
+in and out is most of each call.
+
+The difference between a shared lock and a counter only shows when threads really run at
+once: with the GIL dropped around each call, on as many cores as there are threads. On a
+single core the threads take turns and both come out the same.
+
+Build an earlier commit into a directory and pass it as --baseline to run the same
+measurement against that build in a child process.
+
+    python benchmarks/filewriter_contention.py [--threads N] [--writes N] [--write-size BYTES]
+                                               [--size-only] [--baseline DIR]
+"""
+
+import argparse
+import os
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+import sabctools
+
+
+def hammer(writer, index: int, args, barrier):
+    data = os.urandom(args.write_size)
+    base = index * args.writes * args.write_size
+    barrier.wait()
+    if args.size_only:
+        for _ in range(args.writes):
+            writer.size
+        return
+    for number in range(args.writes):
+        writer.write(data, base + number * args.write_size)
+        if args.size_every and number % args.size_every == 0:
+            writer.size
+
+
+def measure(args) -> float:
+    """Best of --rounds, in calls per second"""
+    best = float("inf")
+    with tempfile.TemporaryDirectory(dir=args.dir) as workdir:
+        path = os.path.join(workdir, "contention.bin")
+        for _ in range(args.rounds):
+            writer = sabctools.FileWriter(path)
+            writer.preallocate(args.threads * args.writes * args.write_size)
+            barrier = threading.Barrier(args.threads + 1)
+            threads = [
+                threading.Thread(target=hammer, args=(writer, index, args, barrier)) for index in range(args.threads)
+            ]
+            for thread in threads:
+                thread.start()
+            barrier.wait()
+            start = time.perf_counter()
+            for thread in threads:
+                thread.join()
+            best = min(best, time.perf_counter() - start)
+            writer.close()
+            os.unlink(path)
+    if args.size_only:
+        return args.threads * args.writes / best
+    calls = args.threads * args.writes * (1 + (1 / args.size_every if args.size_every else 0))
+    return calls / best
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--threads", type=int, default=8)
+    parser.add_argument("--writes", type=int, default=20000, help="writes per thread")
+    parser.add_argument("--write-size", type=int, default=512)
+    parser.add_argument("--size-every", type=int, default=16, help="query size every this many writes, 0 for never")
+    parser.add_argument("--size-only", action="store_true", help="only query size, with no writes")
+    parser.add_argument("--rounds", type=int, default=5)
+    parser.add_argument("--dir", default=None, help="where to write, by default the temporary directory")
+    parser.add_argument("--baseline", help="directory holding another sabctools build to compare with")
+    parser.add_argument("--quiet", action="store_true", help=argparse.SUPPRESS)
+    args = parser.parse_args()
+
+    rate = measure(args)
+    if args.quiet:
+        print(rate)
+        return
+    if args.size_only:
+        print(f"{args.threads} threads, {args.writes} size queries each, {os.cpu_count()} cpus")
+    else:
+        print(f"{args.threads} threads, {args.writes} writes of {args.write_size} bytes each, {os.cpu_count()} cpus")
+    print(f"  this build  {rate:10.0f} calls/s")
+    if args.baseline:
+        command = [sys.executable, __file__, "--quiet"] + [
+            "--%s=%s" % (name.replace("_", "-"), getattr(args, name))
+            for name in ("threads", "writes", "write_size", "size_every", "rounds")
+        ]
+        if args.dir:
+            command.append("--dir=%s" % args.dir)
+        if args.size_only:
+            command.append("--size-only")
+        environment = dict(os.environ, PYTHONPATH=args.baseline)
+        baseline = float(subprocess.run(command, env=environment, capture_output=True, check=True).stdout)
+        print(f"  baseline    {baseline:10.0f} calls/s")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,122 @@
+#!/usr/bin/python3 -OO
+"""
+Reconnect storm against a local `openssl s_server`, with and without a SessionCache.
+
+Opens --connections TLS connections at once from a thread pool, each doing the
+handshake and one request, and reports wall time, time to first byte and the CPU the
+client process used. The cached run is warmed by a single connection first, as the
+cache would be by the connections that were just dropped.
+
+    python benchmarks/reconnect.py [--connections N] [--tls 1.2|1.3]
+"""
+
+import argparse
+import os
+import shutil
+import socket
+import ssl
+import statistics
+import subprocess
+import tempfile
+import time
+from concurrent.futures import ThreadPoolExecutor
+
+import sabctools
+
+HOST = "127.0.0.1"
+
+
+def free_port() -> int:
+    with socket.socket() as sock:
+        sock.bind((HOST, 0))
+        return sock.getsockname()[1]
+
+
+def start_server(workdir: str, port: int) -> subprocess.Popen:
+    cert = os.path.join(workdir, "cert.pem")
+    key = os.path.join(workdir, "key.pem")
+    subprocess.run(
+        ["openssl", "req", "-x509", "-newkey", "rsa:2048", "-nodes", "-subj", "/CN=localhost", "-days", "1",
+         "-keyout", key, "-out", cert],
+        check=True,
+        capture_output=True,
+    )
+    server = subprocess.Popen(
+        ["openssl", "s_server", "-accept", str(port), "-cert", cert, "-key", key, "-www", "-quiet"],
+        stdout=subprocess.DEVNULL,
+        stderr=subprocess.DEVNULL,
+    )
+    deadline = time.monotonic() + 10
+    while time.monotonic() < deadline:
+        try:
+            socket.create_connection((HOST, port), timeout=0.2).close()
+            return server
+        except OSError:
+            time.sleep(0.05)
+    server.kill()
+    raise RuntimeError("openssl s_server did not start")
+
+
+def one_connection(context: ssl.SSLContext, port: int, cache) -> float:
+    start = time.perf_counter()
+    sock = socket.create_connection((HOST, port))
+    ssock = context.wrap_socket(sock, server_hostname="localhost", do_handshake_on_connect=False)
+    if cache is not None:
+        cache.apply(ssock, HOST, port)
+    ssock.do_handshake()
+    ssock.sendall(b"GET / HTTP/1.0\r\n\r\n")
+    ssock.recv(1)
+    ttfb = time.perf_counter() - start
+    if cache is not None:
+        cache.store(ssock, HOST, port)
+    ssock.close()
+    return ttfb
+
+
+def storm(context: ssl.SSLContext, port: int, connections: int, cache) -> None:
+    if cache is not None:
+        one_connection(context, port, cache)
+    cpu = time.process_time()
+    wall = time.perf_counter()
+    with ThreadPoolExecutor(connections) as pool:
+        ttfbs = list(pool.map(lambda _: one_connection(context, port, cache), range(connections)))
+    wall = time.perf_counter() - wall
+    cpu = time.process_time() - cpu
+
+    label = "full" if cache is None else "cached"
+    print(
+        f"{label:7} wall {wall * 1000:7.1f} ms  cpu {cpu * 1000:7.1f} ms"
+        f"  ttfb median {statistics.median(ttfbs) * 1000:6.1f} ms  p95 {sorted(ttfbs)[int(len(ttfbs) * 0.95)] * 1000:6.1f} ms"
+    )
+    if cache is not None:
+        print(f"        {cache!r}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--connections", type=int, default=100)
+    parser.add_argument("--tls", choices=["1.2", "1.3"], default="1.3")
+    args = parser.parse_args()
+
+    if not shutil.which("openssl"):
+        raise SystemExit("the openssl command line tool is needed for the server")
+
+    context = ssl.create_default_context()
+    context.check_hostname = False
+    context.verify_mode = ssl.CERT_NONE
+    version = ssl.TLSVersion.TLSv1_3 if args.tls == "1.3" else ssl.TLSVersion.TLSv1_2
+    context.minimum_version = context.maximum_version = version
+
+    with tempfile.TemporaryDirectory() as workdir:
+        port = free_port()
+        server = start_server(workdir, port)
+        try:
+            storm(context, port, args.connections, None)
+            storm(context, port, args.connections, sabctools.SessionCache())
+        finally:
+            server.kill()
+            server.wait()
+
+
+if __name__ == "__main__":
+    main()
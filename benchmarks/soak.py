@@ -0,0 +1,273 @@
+#!/usr/bin/python3 -OO
+"""
+Soak test: N connections downloading from the local stand-in server into one file.
+
+The server (tests/nntpserver.py) runs in a process of its own, serving synthetic
+multipart yEnc (or UU) articles, so the CPU and memory reported here are the client's
+alone. Each connection keeps --pipeline requests in flight and decodes straight into a
+FileWriter, at the offsets in the yEnc headers or, for UU, at the offset each request
+is queued with. Articles lost to a 430 are counted;
+those lost to a truncated body are requeued on a fresh connection, as a downloader
+would.
+
+Reports throughput, client CPU per decoded GB and peak RSS.
+
+    python benchmarks/soak.py [--connections N] [--articles N] [--size BYTES]
+                              [--engine decoder|connection] [--tls] [--latency S]
+                              [--bandwidth BYTES] [--missing-rate F] [--truncate-rate F]
+"""
+
+import argparse
+import collections
+import os
+import selectors
+import socket
+import ssl
+import subprocess
+import sys
+import tempfile
+import time
+
+import sabctools
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+ROOT = os.path.dirname(HERE)
+HOST = "127.0.0.1"
+
+try:
+    import resource
+except ImportError:  # Windows
+    resource = None
+
+
+def start_server(args, workdir: str):
+    command = [sys.executable, "-m", "tests.nntpserver", "--articles", str(args.articles), "--size", str(args.size),
+               "--kind", args.kind, "--latency", str(args.latency), "--bandwidth", str(args.bandwidth),
+               "--missing-rate", str(args.missing_rate), "--truncate-rate", str(args.truncate_rate)]
+    if args.tls:
+        cert = os.path.join(workdir, "cert.pem")
+        key = os.path.join(workdir, "key.pem")
+        subprocess.run(
+            ["openssl", "req", "-x509", "-newkey", "rsa:2048", "-nodes", "-subj", "/CN=localhost", "-days", "1",
+             "-keyout", key, "-out", cert],
+            check=True,
+            capture_output=True,
+        )
+        command += ["--tls", cert, key]
+    server = subprocess.Popen(command, cwd=ROOT, stdin=subprocess.PIPE, stdout=subprocess.PIPE)
+    port = int(server.stdout.readline())
+    return server, port
+
+
+class DecoderClient:
+    """The loop SABnzbd runs today: Python reads the socket and drives a Decoder"""
+
+    def __init__(self, sock, pipeline: int, buffer_size: int):
+        self.sock = sock
+        self.tls = isinstance(sock, ssl.SSLSocket)
+        self.pipeline = pipeline
+        self.decoder = sabctools.Decoder(buffer_size)
+        self.decoder.expect("greeting")
+        self.ready = False
+        self.outbuf = b""
+
+    def fileno(self):
+        return self.sock.fileno()
+
+    @property
+    def wants_write(self):
+        return bool(self.outbuf)
+
+    def fill(self, queue, writer, size):
+        if not self.ready:
+            return
+        batch = []
+        while queue and self.decoder.expected + len(batch) < self.pipeline:
+            number = queue.popleft()
+            batch.append(("%d@synthetic" % number, number, writer, number * size))
+        if batch:
+            self.outbuf += self.decoder.queue_requests(b"BODY <%s>\r\n", batch)
+
+    def on_writable(self):
+        if self.outbuf:
+            sent = self.sock.send(self.outbuf)
+            self.outbuf = self.outbuf[sent:]
+
+    def on_readable(self):
+        responses = []
+        # Until a short read: under TLS, records OpenSSL has buffered do not make the
+        # socket readable again
+        while True:
+            view = memoryview(self.decoder)
+            available = len(view)
+            try:
+                if self.tls:
+                    n = sabctools.unlocked_ssl_recv_into(self.sock, view)
+                else:
+                    n = self.sock.recv_into(view)
+            except (BlockingIOError, ssl.SSLWantReadError):
+                return responses
+            finally:
+                view.release()
+            if not n:
+                raise ConnectionResetError("Connection closed by server")
+            self.decoder.process(n)
+            for response in self.decoder:
+                if response.context == "greeting":
+                    self.ready = True
+                else:
+                    responses.append(response)
+            if n < available:
+                return responses
+
+    def requeue(self):
+        return [context for context in self.decoder.pending if context != "greeting"]
+
+    def close(self):
+        self.sock.close()
+
+
+class ConnectionClient:
+    """The same through NNTPConnection, which keeps the loop native"""
+
+    def __init__(self, sock, pipeline: int, buffer_size: int):
+        self.connection = sabctools.NNTPConnection(sock, pipeline=pipeline, buffer_size=buffer_size)
+        self.on_readable = self.connection.on_readable
+        self.on_writable = self.connection.on_writable
+        self.requeue = self.connection.requeue
+
+    def fileno(self):
+        return self.connection.fileno()
+
+    @property
+    def wants_write(self):
+        return self.connection.wants_write
+
+    def close(self):
+        self.connection.sock.close()
+
+    def fill(self, queue, writer, size):
+        # Kept topped up with what the pipeline can take next, the rest stays shared
+        while queue and self.connection.queued + self.connection.in_flight < self.connection.pipeline:
+            number = queue.popleft()
+            self.connection.submit("%d@synthetic" % number, number, writer, number * size)
+
+
+def open_client(args, port: int, context):
+    sock = socket.create_connection((HOST, port))
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 1 << 20)
+    if context:
+        sock = context.wrap_socket(sock, server_hostname="localhost")
+    sock.setblocking(False)
+    client_type = ConnectionClient if args.engine == "connection" else DecoderClient
+    return client_type(sock, args.pipeline, args.buffer_size)
+
+
+def soak(args, port: int, path: str):
+    context = None
+    if args.tls:
+        context = ssl.create_default_context()
+        context.check_hostname = False
+        context.verify_mode = ssl.CERT_NONE
+
+    writer = sabctools.FileWriter(path)
+    writer.preallocate(args.articles * args.size)
+    queue = collections.deque(range(args.articles))
+    stats = collections.Counter()
+
+    selector = selectors.DefaultSelector()
+    clients = []
+
+    def add_client():
+        client = open_client(args, port, context)
+        selector.register(client, selectors.EVENT_READ)
+        clients.append(client)
+        stats["connections"] += 1
+
+    for _ in range(args.connections):
+        add_client()
+
+    done = 0
+    while done < args.articles:
+        for client in clients:
+            client.fill(queue, writer, args.size)
+            events = selectors.EVENT_READ | (selectors.EVENT_WRITE if client.wants_write else 0)
+            selector.modify(client, events)
+        for key, mask in selector.select(1):
+            client = key.fileobj
+            try:
+                if mask & selectors.EVENT_WRITE:
+                    client.on_writable()
+                if mask & selectors.EVENT_READ:
+                    responses = client.on_readable()
+                else:
+                    responses = []
+            except OSError:
+                # ConnectionResetError for a plain socket, SSLEOFError under TLS
+                queue.extendleft(reversed(client.requeue()))
+                selector.unregister(client)
+                clients.remove(client)
+                client.close()
+                stats["truncated"] += 1
+                add_client()
+                continue
+            for response in responses:
+                done += 1
+                if response.status_code == 430:
+                    stats["missing"] += 1
+                elif response.crc_expected is not None and response.crc != response.crc_expected:
+                    stats["crc errors"] += 1
+                else:
+                    stats["decoded"] += response.bytes_decoded
+
+    for client in clients:
+        selector.unregister(client)
+        client.close()
+    selector.close()
+    writer.close()
+    return stats
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--connections", type=int, default=20)
+    parser.add_argument("--articles", type=int, default=2000)
+    parser.add_argument("--size", type=int, default=716800, help="decoded bytes per article")
+    parser.add_argument("--pipeline", type=int, default=4)
+    parser.add_argument("--buffer-size", type=int, default=256 * 1024)
+    parser.add_argument("--engine", choices=["decoder", "connection"], default="decoder")
+    parser.add_argument("--kind", choices=["yenc", "uu"], default="yenc")
+    parser.add_argument("--tls", action="store_true")
+    parser.add_argument("--latency", type=float, default=0.0)
+    parser.add_argument("--bandwidth", type=int, default=0, help="bytes per second per connection")
+    parser.add_argument("--missing-rate", type=float, default=0.0)
+    parser.add_argument("--truncate-rate", type=float, default=0.0)
+    args = parser.parse_args()
+
+    with tempfile.TemporaryDirectory() as workdir:
+        server, port = start_server(args, workdir)
+        try:
+            cpu = time.process_time()
+            wall = time.perf_counter()
+            stats = soak(args, port, os.path.join(workdir, "soak.bin"))
+            wall = time.perf_counter() - wall
+            cpu = time.process_time() - cpu
+        finally:
+            server.stdin.close()
+            server.wait()
+
+    gigabytes = stats["decoded"] / 1e9
+    print(f"{args.engine}: {args.articles} articles over {args.connections} connections, pipeline {args.pipeline}")
+    print(f"  decoded     {stats['decoded'] / 1e6:10.1f} MB in {wall:.2f} s = {stats['decoded'] / 1e6 / wall:.1f} MB/s")
+    if gigabytes:
+        print(f"  cpu         {cpu:10.2f} s = {cpu / gigabytes:.2f} s per GB")
+    if resource:
+        maxrss = resource.getrusage(resource.RUSAGE_SELF).ru_maxrss
+        # Kilobytes on Linux, bytes on macOS
+        print(f"  peak rss    {maxrss / (1 << 20 if sys.platform == 'darwin' else 1 << 10):10.1f} MB")
+    print(f"  missing {stats['missing']}, truncated {stats['truncated']}, crc errors {stats['crc errors']}, "
+          f"connections opened {stats['connections']}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,92 @@
+#!/usr/bin/python3 -OO
+"""
+UU decoding throughput on the tests/uufiles corpus, scaled up.
+
+Each file's body is repeated until an article holds --size bytes of encoded lines,
+and --articles of those are pipelined through one Decoder, as a connection would
+receive them. binascii.a2b_uu over the same lines is shown for reference.
+
+    python benchmarks/uu.py [--size BYTES] [--articles N] [--rounds N]
+"""
+
+import argparse
+import binascii
+import glob
+import os
+import time
+
+import sabctools
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+
+def corpus_lines() -> list:
+    """The body lines of every UU test article, without dot-stuffing"""
+    lines = []
+    for path in sorted(glob.glob(os.path.join(HERE, "..", "tests", "uufiles", "*.nntp"))):
+        with open(path, "rb") as f:
+            in_body = False
+            for line in f.read().split(b"\r\n"):
+                if line.startswith(b"begin "):
+                    in_body = True
+                elif line in (b"`", b"end"):
+                    in_body = False
+                elif in_body and line:
+                    lines.append(line[1:] if line.startswith(b"..") else line)
+    return lines
+
+
+def build_article(lines: list, size: int, number: int) -> bytes:
+    body = []
+    total = 0
+    while total < size:
+        for line in lines:
+            body.append(b"." + line if line.startswith(b".") else line)
+            total += len(line) + 2
+            if total >= size:
+                break
+    return b"222 0 <%d@uu>\r\nbegin 644 file%d.bin\r\n" % (number, number) + b"\r\n".join(body) + b"\r\n`\r\nend\r\n.\r\n"
+
+
+def replay(wire: bytes, read_size: int) -> float:
+    decoder = sabctools.Decoder(read_size)
+    source = memoryview(wire)
+    start = time.perf_counter()
+    position = 0
+    while position < len(source):
+        view = memoryview(decoder)
+        n = min(len(view), len(source) - position)
+        view[:n] = source[position : position + n]
+        view.release()
+        decoder.process(n)
+        position += n
+        for _ in decoder:
+            pass
+    return time.perf_counter() - start
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--size", type=int, default=1_000_000, help="encoded bytes per article")
+    parser.add_argument("--articles", type=int, default=50)
+    parser.add_argument("--read-size", type=int, default=256 * 1024)
+    parser.add_argument("--rounds", type=int, default=5)
+    args = parser.parse_args()
+
+    lines = corpus_lines()
+    wire = b"".join(build_article(lines, args.size, number) for number in range(args.articles))
+    print(f"{args.articles} articles, {len(wire) / 1e6:.1f} MB encoded, simd {sabctools.simd}")
+
+    best = min(replay(wire, args.read_size) for _ in range(args.rounds))
+    print(f"  Decoder          {len(wire) / 1e6 / best:8.1f} MB/s")
+
+    reference = [line for line in lines] * (len(wire) // sum(len(line) + 2 for line in lines) + 1)
+    start = time.perf_counter()
+    for line in reference:
+        binascii.a2b_uu(line)
+    elapsed = time.perf_counter() - start
+    print(f"  binascii.a2b_uu  {sum(len(line) + 2 for line in reference) / 1e6 / elapsed:8.1f} MB/s")
+
+
+if __name__ == "__main__":
+    main()
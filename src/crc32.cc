@@ -17,8 +17,28 @@
  */
 
 #include "crc32.h"
+#include "filereader.h"
 #include "rapidyenc/rapidyenc.h"
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/* Least each thread is given; below this a thread costs more to start than it saves */
+#define CRC32_MIN_PIECE (4 * 1024 * 1024)
+/* Most threads one call starts, whatever it asks for: each holds a stack and a read buffer */
+#define CRC32_MAX_THREADS 64
+/* Read buffer per thread when hashing a file */
+#define CRC32_READ_SIZE (1024 * 1024)
+/* Read size for scan_blocks, on top of the block it keeps behind */
+#define SCAN_READ_SIZE (4 * 1024 * 1024)
+/* Largest block_size scan_blocks accepts */
+#define SCAN_MAX_BLOCK (256 * 1024 * 1024)
+
 PyObject* crc32_combine(PyObject *self, PyObject *args) {
     unsigned long crc1, crc2;
     unsigned long long length;
@@ -80,3 +100,394 @@ PyObject* crc32_xpow8n(PyObject* self, PyObject* arg) {
 
     return PyLong_FromUnsignedLong(result);
 }
+
+/*
+ * CRC32 of each buffer in a list, all under one release of the GIL.
+ *
+ * For buffers of a few KB the cost of a Python-level loop is the call itself: argument
+ * parsing, a buffer export and a GIL round trip per buffer, which rivals the hashing.
+ * Here every buffer is exported first, hashed back to back and released afterwards.
+ * There is no separate interleaving kernel: rapidyenc's folding loop already keeps four
+ * independent accumulators (PCLMUL) or wider ones (VPCLMUL, PMULL) in flight within one
+ * buffer, which is what hides the multiply latency from 64 bytes upwards.
+ */
+PyObject* crc32_many(PyObject* self, PyObject* arg) {
+    PyObject *sequence = PySequence_Fast(arg, "crc32_many() expects an iterable of buffers");
+    if (!sequence) return NULL;
+
+    const Py_ssize_t count = PySequence_Fast_GET_SIZE(sequence);
+    std::vector<Py_buffer> views(count);
+    std::vector<uint32_t> crcs(count);
+    PyObject *result = NULL;
+
+    Py_ssize_t exported = 0;
+    for (; exported < count; exported++) {
+        if (PyObject_GetBuffer(PySequence_Fast_GET_ITEM(sequence, exported), &views[exported], PyBUF_SIMPLE) < 0) {
+            goto done;
+        }
+    }
+
+    Py_BEGIN_ALLOW_THREADS;
+    for (Py_ssize_t i = 0; i < count; i++) {
+        crcs[i] = rapidyenc_crc(views[i].buf, views[i].len, 0);
+    }
+    Py_END_ALLOW_THREADS;
+
+    result = PyList_New(count);
+    if (!result) goto done;
+    for (Py_ssize_t i = 0; i < count; i++) {
+        PyObject *crc = PyLong_FromUnsignedLong(crcs[i]);
+        if (!crc) {
+            Py_CLEAR(result);
+            goto done;
+        }
+        PyList_SET_ITEM(result, i, crc);
+    }
+
+done:
+    for (Py_ssize_t i = 0; i < exported; i++) PyBuffer_Release(&views[i]);
+    Py_DECREF(sequence);
+    return result;
+}
+
+/* One thread's share of a crc32() call, hashed from memory or read from the file */
+typedef struct {
+    const char *data; // NULL when reading from the file
+    long long offset;
+    long long length;
+    uint32_t crc;
+    unsigned long error;
+} Crc32Piece;
+
+static void crc32_hash_piece(Crc32Piece *piece, FileHandle handle) {
+    if (piece->data) {
+        piece->crc = rapidyenc_crc(piece->data, static_cast<size_t>(piece->length), 0);
+        return;
+    }
+    const size_t chunk = static_cast<size_t>(std::min<long long>(piece->length, CRC32_READ_SIZE));
+    char *buffer = static_cast<char *>(malloc(chunk ? chunk : 1));
+    if (!buffer) {
+        piece->error = FILEREADER_NO_MEMORY;
+        return;
+    }
+    uint32_t crc = 0;
+    for (long long done = 0; done < piece->length;) {
+        const size_t want = static_cast<size_t>(std::min<long long>(piece->length - done, chunk));
+        if (!filereader_read_at(handle, buffer, want, piece->offset + done, &piece->error)) break;
+        crc = rapidyenc_crc(buffer, want, crc);
+        done += want;
+    }
+    free(buffer);
+    piece->crc = crc;
+}
+
+/*
+ * crc32(data, offset=0, length=None, init=0, threads=1)
+ *
+ * CRC32 of a buffer, or of a file named by a str or os.PathLike path, from offset for
+ * length bytes (to the end when None), continuing from init. bytes are data, not a path.
+ *
+ * With more than one thread the range is split into contiguous pieces, one per thread,
+ * each hashed from zero and joined in order with rapidyenc_crc_combine. The calling
+ * thread takes the first piece itself. Everything runs with the GIL released.
+ */
+PyObject* crc32_compute(PyObject* self, PyObject* args, PyObject* kwds) {
+    static const char *kwlist[] = {"data", "offset", "length", "init", "threads", nullptr};
+    PyObject *data;
+    long long offset = 0;
+    PyObject *length_arg = Py_None;
+    unsigned long init = 0;
+    int threads = 1;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|LOki:crc32", const_cast<char **>(kwlist), &data, &offset,
+                                     &length_arg, &init, &threads)) {
+        return NULL;
+    }
+    if (threads < 0) {
+        PyErr_SetString(PyExc_ValueError, "threads must not be negative");
+        return NULL;
+    }
+    long long length = -1;
+    if (!Py_IsNone(length_arg)) {
+        length = PyLong_AsLongLong(length_arg);
+        if (length == -1 && PyErr_Occurred()) return NULL;
+        if (length < 0) {
+            PyErr_SetString(PyExc_ValueError, "length must not be negative");
+            return NULL;
+        }
+    }
+
+    Py_buffer view = {};
+    PyObject *fspath = NULL;
+    FileHandle handle = SABCTOOLS_INVALID_HANDLE;
+    long long size;
+    if (PyObject_CheckBuffer(data)) {
+        if (PyObject_GetBuffer(data, &view, PyBUF_SIMPLE) < 0) return NULL;
+        size = view.len;
+    } else {
+        fspath = PyOS_FSPath(data);
+        if (!fspath) return NULL;
+        if (!filereader_open(fspath, &handle, &size)) {
+            Py_DECREF(fspath);
+            return NULL;
+        }
+    }
+
+    PyObject *result = NULL;
+    if (offset < 0 || offset > size || (length >= 0 && length > size - offset)) {
+        PyErr_Format(PyExc_ValueError, "offset %lld and length %lld do not fit %lld bytes", offset, length, size);
+    } else {
+        if (length < 0) length = size - offset;
+        if (threads == 0) threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+        const long long most = std::max(1LL, length / CRC32_MIN_PIECE);
+        const int count = static_cast<int>(std::min<long long>({threads, most, CRC32_MAX_THREADS}));
+
+        std::vector<Crc32Piece> pieces(count);
+        const long long share = length / count;
+        for (int i = 0; i < count; i++) {
+            const long long begin = offset + i * share;
+            pieces[i].offset = begin;
+            pieces[i].length = i == count - 1 ? offset + length - begin : share;
+            pieces[i].data = fspath ? NULL : static_cast<const char *>(view.buf) + begin;
+        }
+
+        uint32_t crc = static_cast<uint32_t>(init);
+        unsigned long error = 0;
+        Py_BEGIN_ALLOW_THREADS;
+        std::vector<std::thread> workers;
+        for (int i = 1; i < count; i++) workers.emplace_back(crc32_hash_piece, &pieces[i], handle);
+        crc32_hash_piece(&pieces[0], handle);
+        for (std::thread &worker : workers) worker.join();
+        for (const Crc32Piece &piece : pieces) {
+            if (piece.error && !error) error = piece.error;
+            crc = rapidyenc_crc_combine(crc, piece.crc, piece.length);
+        }
+        Py_END_ALLOW_THREADS;
+
+        if (error) {
+            filereader_raise(error, fspath);
+        } else {
+            result = PyLong_FromUnsignedLong(crc);
+        }
+    }
+
+    if (fspath) {
+        filereader_close(handle);
+        Py_DECREF(fspath);
+    } else {
+        PyBuffer_Release(&view);
+    }
+    return result;
+}
+
+/*
+ * The tables to roll a CRC32 window of `window` bytes along by one byte.
+ *
+ * The same construction as crcutil's RollingCrc, built from rapidyenc's public CRC
+ * algebra rather than crcutil's internals. Kept as the register (the inverted CRC), a
+ * step is the usual table update for the byte coming in, xored with out[] for the byte
+ * leaving: out[b] is what b followed by `window` zeros contributes beyond the zeros alone.
+ */
+typedef struct {
+    uint32_t in[256];
+    uint32_t out[256];
+} RollingTables;
+
+static void rolling_tables(RollingTables *tables, size_t window) {
+    for (uint32_t b = 0; b < 256; b++) {
+        uint32_t reg = b;
+        for (int bit = 0; bit < 8; bit++) reg = (reg >> 1) ^ (0xEDB88320 & (0 - (reg & 1)));
+        tables->in[b] = reg;
+    }
+    const uint32_t zeros = rapidyenc_crc_zeros(0, window);
+    for (uint32_t b = 0; b < 256; b++) {
+        const unsigned char byte = static_cast<unsigned char>(b);
+        tables->out[b] = rapidyenc_crc_zeros(rapidyenc_crc(&byte, 1, 0), window) ^ zeros;
+    }
+}
+
+/* Where scan_blocks reads from: the caller's buffer, or a window onto the file */
+typedef struct {
+    char *buffer;
+    size_t capacity;
+    size_t filled;      // valid bytes in buffer
+    long long position; // file offset of buffer[0]
+    long long size;
+    FileHandle handle;  // SABCTOOLS_INVALID_HANDLE for a buffer, which is all there already
+    unsigned long error;
+} ScanSource;
+
+/*
+ * Make buffer[*at, *at + need) valid. For a file, the bytes from *at on are moved to the
+ * front first and the rest of the buffer read, so *at becomes 0. False at the end of the
+ * data, or on a read error.
+ */
+static bool scan_ensure(ScanSource *source, size_t *at, size_t need) {
+    if (*at + need <= source->filled) return true;
+    if (source->handle == SABCTOOLS_INVALID_HANDLE) return false;
+
+    const size_t kept = source->filled - *at;
+    memmove(source->buffer, source->buffer + *at, kept);
+    source->position += *at;
+    source->filled = kept;
+    *at = 0;
+
+    const long long remaining = source->size - (source->position + static_cast<long long>(kept));
+    const size_t want = static_cast<size_t>(std::min<long long>(source->capacity - kept, remaining));
+    if (want > 0) {
+        if (!filereader_read_at(source->handle, source->buffer + kept, want, source->position + kept,
+                                &source->error)) {
+            return false;
+        }
+        source->filled += want;
+    }
+    return need <= source->filled;
+}
+
+/*
+ * scan_blocks(data, block_size, crcs) -> [(offset, index), ...]
+ *
+ * Find where blocks with known CRC32s sit in a buffer or a file (str or os.PathLike
+ * path; bytes are data), whatever their alignment: the PAR2 quick scan for slices that
+ * were displaced by bytes lost or added in transit. A CRC32 of a block_size window is
+ * rolled along one byte at a time with the GIL released, and looked up, through a
+ * 64K-bit filter first, in the CRCs given. A candidate is confirmed with a full CRC of
+ * its window, and reported as (offset, index into crcs); several indices sharing a CRC
+ * are all reported. The scan then carries on after the block, as PAR2 clients do.
+ */
+PyObject* scan_blocks(PyObject* self, PyObject* args, PyObject* kwds) {
+    static const char *kwlist[] = {"data", "block_size", "crcs", nullptr};
+    PyObject *data;
+    Py_ssize_t block_size;
+    PyObject *crcs_arg;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "OnO:scan_blocks", const_cast<char **>(kwlist), &data,
+                                     &block_size, &crcs_arg)) {
+        return NULL;
+    }
+    if (block_size < 1 || block_size > SCAN_MAX_BLOCK) {
+        PyErr_Format(PyExc_ValueError, "block_size must be between 1 and %d", SCAN_MAX_BLOCK);
+        return NULL;
+    }
+
+    PyObject *sequence = PySequence_Fast(crcs_arg, "crcs must be an iterable of CRC32 values");
+    if (!sequence) return NULL;
+    std::unordered_map<uint32_t, std::vector<Py_ssize_t>> wanted;
+    std::vector<uint64_t> filter(1 << 10);
+    for (Py_ssize_t i = 0; i < PySequence_Fast_GET_SIZE(sequence); i++) {
+        const unsigned long value = PyLong_AsUnsignedLong(PySequence_Fast_GET_ITEM(sequence, i));
+        if (value == static_cast<unsigned long>(-1) && PyErr_Occurred()) {
+            Py_DECREF(sequence);
+            return NULL;
+        }
+        if (value > 0xFFFFFFFFUL) {
+            Py_DECREF(sequence);
+            PyErr_SetString(PyExc_OverflowError, "a CRC32 must fit in 32 bits");
+            return NULL;
+        }
+        const uint32_t crc = static_cast<uint32_t>(value);
+        wanted[crc].push_back(i);
+        filter[crc >> 22] |= 1ULL << ((crc >> 16) & 63);
+    }
+    Py_DECREF(sequence);
+
+    Py_buffer view = {};
+    PyObject *fspath = NULL;
+    ScanSource source = {};
+    source.handle = SABCTOOLS_INVALID_HANDLE;
+    if (PyObject_CheckBuffer(data)) {
+        if (PyObject_GetBuffer(data, &view, PyBUF_SIMPLE) < 0) return NULL;
+        source.buffer = static_cast<char *>(view.buf);
+        source.capacity = source.filled = view.len;
+        source.size = view.len;
+    } else {
+        fspath = PyOS_FSPath(data);
+        if (!fspath) return NULL;
+        if (!filereader_open(fspath, &source.handle, &source.size)) {
+            Py_DECREF(fspath);
+            return NULL;
+        }
+        source.capacity = block_size + SCAN_READ_SIZE;
+        source.buffer = static_cast<char *>(malloc(source.capacity));
+        if (!source.buffer) {
+            filereader_close(source.handle);
+            Py_DECREF(fspath);
+            return PyErr_NoMemory();
+        }
+    }
+
+    RollingTables *tables = static_cast<RollingTables *>(malloc(sizeof(RollingTables)));
+    std::vector<std::pair<long long, Py_ssize_t>> hits;
+    const size_t window = static_cast<size_t>(block_size);
+
+    Py_BEGIN_ALLOW_THREADS;
+    if (tables && !wanted.empty()) {
+        rolling_tables(tables, window);
+        const unsigned char *bytes = reinterpret_cast<const unsigned char *>(source.buffer);
+        size_t at = 0;
+        uint32_t reg = 0;
+        bool started = scan_ensure(&source, &at, window);
+        if (started) reg = ~rapidyenc_crc(source.buffer + at, window, 0);
+        const uint64_t *bits = filter.data();
+        while (started) {
+            // Roll through what is loaded until the filter lets a window through, in
+            // locals, so the hot loop has nothing to reload
+            const size_t last = source.filled - window;
+            size_t i = at;
+            uint32_t r = reg;
+            bool candidate;
+            for (;;) {
+                const uint32_t crc = ~r;
+                candidate = bits[crc >> 22] & (1ULL << ((crc >> 16) & 63));
+                if (candidate || i == last) break;
+                r = (r >> 8) ^ tables->in[(r ^ bytes[i + window]) & 0xFF] ^ tables->out[bytes[i]];
+                i++;
+            }
+            at = i;
+            reg = r;
+
+            if (candidate) {
+                const uint32_t crc = ~reg;
+                auto found = wanted.find(crc);
+                if (found != wanted.end() && rapidyenc_crc(source.buffer + at, window, 0) == crc) {
+                    for (Py_ssize_t index : found->second) hits.emplace_back(source.position + at, index);
+                    // Carry on after the block, from a fresh window
+                    at += window;
+                    if (!scan_ensure(&source, &at, window)) break;
+                    reg = ~rapidyenc_crc(source.buffer + at, window, 0);
+                    continue;
+                }
+            }
+            if (!scan_ensure(&source, &at, window + 1)) break;
+            reg = (reg >> 8) ^ tables->in[(reg ^ bytes[at + window]) & 0xFF] ^ tables->out[bytes[at]];
+            at++;
+        }
+    }
+    Py_END_ALLOW_THREADS;
+
+    PyObject *result = NULL;
+    if (!tables) {
+        PyErr_NoMemory();
+    } else if (source.error) {
+        filereader_raise(source.error, fspath);
+    } else if ((result = PyList_New(static_cast<Py_ssize_t>(hits.size())))) {
+        for (size_t i = 0; i < hits.size(); i++) {
+            PyObject *hit = Py_BuildValue("(Ln)", hits[i].first, hits[i].second);
+            if (!hit) {
+                Py_CLEAR(result);
+                break;
+            }
+            PyList_SET_ITEM(result, i, hit);
+        }
+    }
+
+    free(tables);
+    if (fspath) {
+        free(source.buffer);
+        filereader_close(source.handle);
+        Py_DECREF(fspath);
+    } else {
+        PyBuffer_Release(&view);
+    }
+    return result;
+}
@@ -26,5 +26,8 @@ PyObject* crc32_multiply(PyObject *, PyObject*);
 PyObject* crc32_zero_unpad(PyObject *, PyObject*);
 PyObject* crc32_xpown(PyObject *, PyObject*);
 PyObject* crc32_xpow8n(PyObject *, PyObject*);
+PyObject* crc32_many(PyObject *, PyObject*);
+PyObject* crc32_compute(PyObject *, PyObject*, PyObject*);
+PyObject* scan_blocks(PyObject *, PyObject*, PyObject*);
 
 #endif //SABCTOOLS_CRC32_H
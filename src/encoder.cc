@@ -0,0 +1,463 @@
+/*
+ * Copyright 2007-2026 The SABnzbd-Team (sabnzbd.org)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "encoder.h"
+#include "yenc.h"
+
+#include "structmember.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+static int Encoder_init(Encoder *self, PyObject *args, PyObject *kwds) {
+    static const char *kwlist[] = {"line_size", nullptr};
+    int line_size = YENC_LINESIZE;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|i:Encoder", const_cast<char **>(kwlist), &line_size)) return -1;
+    if (line_size < 2 || line_size > ENCODER_MAX_LINE_SIZE) {
+        PyErr_Format(PyExc_ValueError, "line_size must be between 2 and %d", ENCODER_MAX_LINE_SIZE);
+        return -1;
+    }
+    if (self->busy) {
+        PyErr_SetString(PyExc_RuntimeError, "Encoder is in use");
+        return -1;
+    }
+
+    self->line_size = line_size;
+    self->column = 0;
+    self->crc = 0;
+    self->bytes_in = 0;
+    self->bytes_out = 0;
+    self->held = 0;
+    self->ended = false;
+    return 0;
+}
+
+static void Encoder_dealloc(Encoder *self) {
+    free(self->scratch);
+    Py_TYPE(self)->tp_free(reinterpret_cast<PyObject *>(self));
+}
+
+/* What encode() may write for `length` bytes: rapidyenc's bound, and a held back byte */
+static size_t encoder_max_length(size_t length, int line_size) {
+    return rapidyenc_encode_max_length(length, line_size) + 1;
+}
+
+/* Whether [a, a + a_len) and [b, b + b_len) share a byte */
+static bool overlaps(const char *a, Py_ssize_t a_len, const char *b, Py_ssize_t b_len) {
+    return a < b + b_len && b < a + a_len;
+}
+
+/*
+ * Encode the next chunk of the article.
+ *
+ * ``data`` is any contiguous buffer. With ``out``, a writable buffer of at least
+ * max_length(len(data)) bytes that must not overlap ``data``, the encoded bytes are
+ * written to its start and their count is returned. Without it they are returned as
+ * bytes, encoded through the Encoder's scratch buffer so nothing worst-case sized is
+ * allocated per call.
+ *
+ * ``is_end`` marks the last chunk of the article: a space or tab ending it is escaped,
+ * where any other chunk keeps it back, since only the next call knows whether the
+ * article ends there. That chunk may be empty. Encoding again afterwards needs reset(),
+ * since it would be a new article.
+ */
+static PyObject *Encoder_encode(Encoder *self, PyObject *args, PyObject *kwds) {
+    static const char *kwlist[] = {"data", "out", "is_end", nullptr};
+    Py_buffer data;
+    PyObject *out = Py_None;
+    int is_end = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "y*|Op:encode", const_cast<char **>(kwlist), &data, &out, &is_end))
+        return NULL;
+
+    // Two threads in here at once would share the column, and one could free the scratch
+    // buffer the other is writing to
+    if (self->busy) {
+        PyBuffer_Release(&data);
+        PyErr_SetString(PyExc_RuntimeError, "Encoder is in use by another thread");
+        return NULL;
+    }
+    if (self->ended) {
+        PyBuffer_Release(&data);
+        PyErr_SetString(PyExc_ValueError, "the article was already ended, call reset() to start the next");
+        return NULL;
+    }
+
+    const size_t needed = encoder_max_length(data.len, self->line_size);
+    Py_buffer target;
+    char *dest;
+
+    if (Py_IsNone(out)) {
+        if (self->scratch_size < needed) {
+            char *grown = static_cast<char *>(realloc(self->scratch, needed));
+            if (!grown) {
+                PyBuffer_Release(&data);
+                return PyErr_NoMemory();
+            }
+            self->scratch = grown;
+            self->scratch_size = needed;
+        }
+        dest = self->scratch;
+    } else {
+        if (PyObject_GetBuffer(out, &target, PyBUF_WRITABLE) < 0) {
+            PyBuffer_Release(&data);
+            return NULL;
+        }
+        if (static_cast<size_t>(target.len) < needed) {
+            PyErr_Format(PyExc_ValueError, "out holds %zd bytes, encoding %zd may need %zu", target.len, data.len,
+                         needed);
+        } else if (overlaps(static_cast<const char *>(data.buf), data.len, static_cast<const char *>(target.buf),
+                            target.len)) {
+            PyErr_SetString(PyExc_ValueError, "out must not overlap data");
+        }
+        if (PyErr_Occurred()) {
+            PyBuffer_Release(&target);
+            PyBuffer_Release(&data);
+            return NULL;
+        }
+        dest = static_cast<char *>(target.buf);
+    }
+
+    size_t written = 0;
+    if (self->held && is_end && data.len == 0) {
+        // The article ends on the byte kept back, so it is the last on its line
+        dest[written++] = '=';
+        dest[written++] = static_cast<char>(self->held + 64);
+        self->column++;
+    } else if (self->held) {
+        dest[written++] = self->held;
+    }
+    self->held = 0;
+
+    self->busy = true;
+    Py_BEGIN_ALLOW_THREADS;
+    written += rapidyenc_encode_ex_crc(self->line_size, &self->column, data.buf, dest + written, data.len, is_end,
+                                       &self->crc);
+    Py_END_ALLOW_THREADS;
+    self->busy = false;
+
+    // rapidyenc escapes whitespace in the last column itself, so one left at the end here
+    // is mid-line, and ends the line only if the article ends with it
+    if (!is_end && written > 0 && (dest[written - 1] == ' ' || dest[written - 1] == '\t')) {
+        self->held = dest[--written];
+    }
+
+    self->bytes_in += data.len;
+    self->bytes_out += static_cast<Py_ssize_t>(written);
+    self->ended = is_end;
+    PyBuffer_Release(&data);
+
+    if (Py_IsNone(out)) {
+        return PyBytes_FromStringAndSize(self->scratch, static_cast<Py_ssize_t>(written));
+    }
+    PyBuffer_Release(&target);
+    return PyLong_FromSize_t(written);
+}
+
+/* Start the next article: column 0, CRC and counters cleared, the scratch buffer kept */
+static PyObject *Encoder_reset(Encoder *self, PyObject *Py_UNUSED(ignored)) {
+    if (self->busy) {
+        PyErr_SetString(PyExc_RuntimeError, "Encoder is in use by another thread");
+        return NULL;
+    }
+    self->column = 0;
+    self->crc = 0;
+    self->bytes_in = 0;
+    self->bytes_out = 0;
+    self->held = 0;
+    self->ended = false;
+    Py_RETURN_NONE;
+}
+
+/* The size ``out`` needs for encoding ``length`` bytes at this line size */
+static PyObject *Encoder_max_length(Encoder *self, PyObject *arg) {
+    const Py_ssize_t length = PyLong_AsSsize_t(arg);
+    if (length == -1 && PyErr_Occurred()) return NULL;
+    if (length < 0) {
+        PyErr_SetString(PyExc_ValueError, "length is < 0");
+        return NULL;
+    }
+    return PyLong_FromSize_t(encoder_max_length(length, self->line_size));
+}
+
+static PyObject *Encoder_get_crc(Encoder *self, void *Py_UNUSED(closure)) {
+    return PyLong_FromUnsignedLong(self->crc);
+}
+
+static PyObject *Encoder_repr(Encoder *self) {
+    return PyUnicode_FromFormat("<sabctools.Encoder line_size=%d column=%d bytes_in=%zd>", self->line_size,
+                                self->column, self->bytes_in);
+}
+
+static PyMemberDef Encoder_members[] = {
+    {"line_size", T_INT, offsetof(Encoder, line_size), READONLY, PyDoc_STR("Characters per encoded line")},
+    {"column", T_INT, offsetof(Encoder, column), READONLY,
+     PyDoc_STR("Column the next chunk continues from")},
+    {"bytes_in", T_PYSSIZET, offsetof(Encoder, bytes_in), READONLY,
+     PyDoc_STR("Input bytes encoded since the last reset()")},
+    {"bytes_out", T_PYSSIZET, offsetof(Encoder, bytes_out), READONLY,
+     PyDoc_STR("Encoded bytes produced since the last reset()")},
+    {"ended", T_BOOL, offsetof(Encoder, ended), READONLY,
+     PyDoc_STR("The last chunk was encoded with is_end")},
+    {NULL}
+};
+
+static PyGetSetDef Encoder_getset[] = {
+    {"crc", (getter)Encoder_get_crc, NULL, PyDoc_STR("CRC32 of the input encoded since the last reset()"), NULL},
+    {NULL}
+};
+
+static PyMethodDef Encoder_methods[] = {
+    {"encode", (PyCFunction)(void (*)(void))Encoder_encode, METH_VARARGS | METH_KEYWORDS,
+     PyDoc_STR("encode(data, out=None, is_end=False)\n\nEncode the next chunk of the article.")},
+    {"reset", (PyCFunction)Encoder_reset, METH_NOARGS,
+     PyDoc_STR("reset()\n\nStart the next article.")},
+    {"max_length", (PyCFunction)Encoder_max_length, METH_O,
+     PyDoc_STR("max_length(length)\n\nThe most encoding length bytes can produce, padding included.")},
+    {NULL}
+};
+
+PyTypeObject EncoderType = {
+    PyVarObject_HEAD_INIT(nullptr, 0)
+    "sabctools.Encoder",                    // tp_name
+    sizeof(Encoder),                        // tp_basicsize
+    0,                                      // tp_itemsize
+    (destructor)Encoder_dealloc,            // tp_dealloc
+    0,                                      // tp_vectorcall_offset
+    nullptr,                                // tp_getattr
+    nullptr,                                // tp_setattr
+    nullptr,                                // tp_as_async
+    (reprfunc)Encoder_repr,                 // tp_repr
+    nullptr,                                // tp_as_number
+    nullptr,                                // tp_as_sequence
+    nullptr,                                // tp_as_mapping
+    nullptr,                                // tp_hash
+    nullptr,                                // tp_call
+    nullptr,                                // tp_str
+    nullptr,                                // tp_getattro
+    nullptr,                                // tp_setattro
+    nullptr,                                // tp_as_buffer
+    Py_TPFLAGS_DEFAULT,                     // tp_flags
+    PyDoc_STR("Encoder"),                   // tp_doc
+    nullptr,                                // tp_traverse
+    nullptr,                                // tp_clear
+    nullptr,                                // tp_richcompare
+    0,                                      // tp_weaklistoffset
+    nullptr,                                // tp_iter
+    nullptr,                                // tp_iternext
+    Encoder_methods,                        // tp_methods
+    Encoder_members,                        // tp_members
+    Encoder_getset,                         // tp_getset
+    nullptr,                                // tp_base
+    nullptr,                                // tp_dict
+    nullptr,                                // tp_descr_get
+    nullptr,                                // tp_descr_set
+    0,                                      // tp_dictoffset
+    (initproc)Encoder_init,                 // tp_init
+    PyType_GenericAlloc,                    // tp_alloc
+    PyType_GenericNew,                      // tp_new
+};
+
+bool encoder_init(PyObject *m) {
+    if (PyType_Ready(&EncoderType) < 0) return false;
+    if (PyModule_AddType(m, &EncoderType) < 0) return false;
+    return true;
+}
+
+/* Text for a header or the =ybegin name: str as UTF-8, or bytes, with no line break in it */
+bool article_text(PyObject *item, std::string_view &text, const char *what) {
+    const char *data;
+    Py_ssize_t length;
+    if (PyUnicode_Check(item)) {
+        data = PyUnicode_AsUTF8AndSize(item, &length);
+        if (!data) return false;
+    } else if (PyBytes_Check(item)) {
+        data = PyBytes_AS_STRING(item);
+        length = PyBytes_GET_SIZE(item);
+    } else {
+        PyErr_Format(PyExc_TypeError, "%s must be str or bytes, not %s", what, Py_TYPE(item)->tp_name);
+        return false;
+    }
+    // A line break would end the header early and let the rest be read as something else
+    if (memchr(data, '\r', length) || memchr(data, '\n', length)) {
+        PyErr_Format(PyExc_ValueError, "%s must not contain CR or LF", what);
+        return false;
+    }
+    text = std::string_view(data, length);
+    return true;
+}
+
+/* "Name: value" lines and the blank line after them, from a mapping or (name, value) pairs */
+bool article_headers(PyObject *headers, std::string &out) {
+    PyObject *items = PyDict_Check(headers) ? PyDict_Items(headers) : PySequence_List(headers);
+    if (!items) return false;
+
+    bool ok = true;
+    for (Py_ssize_t i = 0; ok && i < PyList_GET_SIZE(items); i++) {
+        PyObject *pair = PyList_GET_ITEM(items, i);
+        std::string_view name, value;
+        if (!PyTuple_Check(pair) || PyTuple_GET_SIZE(pair) != 2) {
+            PyErr_SetString(PyExc_TypeError, "headers must be a mapping or (name, value) pairs");
+            ok = false;
+        } else if (!article_text(PyTuple_GET_ITEM(pair, 0), name, "header name") ||
+                   !article_text(PyTuple_GET_ITEM(pair, 1), value, "header value")) {
+            ok = false;
+        } else if (name.empty() || name.find(':') != std::string_view::npos) {
+            PyErr_SetString(PyExc_ValueError, "header name must be non-empty and without ':'");
+            ok = false;
+        } else {
+            out.append(name);
+            out.append(": ");
+            out.append(value);
+            out.append("\r\n");
+        }
+    }
+    Py_DECREF(items);
+    out.append("\r\n");
+    return ok;
+}
+
+void article_ybegin(std::string &out, std::string_view name, Py_ssize_t part, Py_ssize_t total, long long begin,
+                    long long end, long long size, int line_size) {
+    char line[128];
+    snprintf(line, sizeof(line), "=ybegin part=%zd total=%zd line=%d size=%lld name=", part, total, line_size, size);
+    out.append(line);
+    out.append(name);
+    snprintf(line, sizeof(line), "\r\n=ypart begin=%lld end=%lld\r\n", begin + 1, end);
+    out.append(line);
+}
+
+size_t article_yend(char *out, Py_ssize_t part, Py_ssize_t total, size_t length, uint32_t pcrc, uint32_t crc) {
+    int written;
+    if (part == total) {
+        written = snprintf(out, ARTICLE_TAIL_MAX, "\r\n=yend size=%zu part=%zd pcrc32=%08x crc32=%08x\r\n.\r\n", length,
+                           part, pcrc, crc);
+    } else {
+        written = snprintf(out, ARTICLE_TAIL_MAX, "\r\n=yend size=%zu part=%zd pcrc32=%08x\r\n.\r\n", length, part,
+                           pcrc);
+    }
+    return static_cast<size_t>(written);
+}
+
+/*
+ * One yEnc part as a complete article, ready for POST.
+ *
+ * ``source`` holds the whole file, typically an mmap, and the part is source[begin:end]
+ * with 0-based offsets. Everything is written into one bytes object: the NNTP headers
+ * and the blank line after them (left out when ``headers`` is None), =ybegin and =ypart,
+ * the encoded body, =yend and the terminating ".". yEnc escapes a '.' starting a line,
+ * so the body never needs dot-stuffing.
+ *
+ * ``crc`` is the CRC32 of source[:begin], which the caller has from the previous part's
+ * result. The whole-file crc32= on the last part is that combined with this part's,
+ * without reading the earlier parts again. Left as None it is computed from the source,
+ * which costs exactly that read.
+ *
+ * ``size`` is the file size for =ybegin, by default len(source); it can be larger when
+ * the source maps only the start of the file. Returns (article, pcrc32, crc32 of
+ * source[:end]).
+ */
+PyObject *build_article(PyObject *self, PyObject *args, PyObject *kwds) {
+    static const char *kwlist[] = {"source", "part", "total",    "begin",     "end", "name",
+                                   "headers", "crc", "size", "line_size", nullptr};
+    Py_buffer source;
+    Py_ssize_t part, total, begin, end;
+    PyObject *name_object;
+    PyObject *headers = Py_None;
+    PyObject *crc_object = Py_None;
+    PyObject *size_object = Py_None;
+    int line_size = YENC_LINESIZE;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "y*nnnnO|OOOi:build_article", const_cast<char **>(kwlist), &source,
+                                     &part, &total, &begin, &end, &name_object, &headers, &crc_object, &size_object,
+                                     &line_size)) {
+        return NULL;
+    }
+
+    PyObject *result = NULL;
+    std::string head;
+    std::string_view name;
+    unsigned long crc_before = 0;
+    bool crc_known = begin == 0;
+    Py_ssize_t size = source.len;
+
+    if (!Py_IsNone(size_object)) {
+        size = PyLong_AsSsize_t(size_object);
+        if (size == -1 && PyErr_Occurred()) goto done;
+    }
+
+    if (part < 1 || part > total) {
+        PyErr_SetString(PyExc_ValueError, "part must be between 1 and total");
+        goto done;
+    }
+    if (begin < 0 || end <= begin || end > source.len || end > size) {
+        PyErr_SetString(PyExc_ValueError, "begin and end must be a non-empty range within the source and size");
+        goto done;
+    }
+    if (line_size < 2 || line_size > ENCODER_MAX_LINE_SIZE) {
+        PyErr_Format(PyExc_ValueError, "line_size must be between 2 and %d", ENCODER_MAX_LINE_SIZE);
+        goto done;
+    }
+    if (!Py_IsNone(crc_object)) {
+        crc_before = PyLong_AsUnsignedLong(crc_object);
+        if (PyErr_Occurred()) goto done;
+        if (crc_before > 0xFFFFFFFFUL) {
+            PyErr_SetString(PyExc_OverflowError, "crc must fit in 32 bits");
+            goto done;
+        }
+        crc_known = true;
+    }
+    if (!article_text(name_object, name, "name")) goto done;
+    if (!Py_IsNone(headers) && !article_headers(headers, head)) goto done;
+
+    article_ybegin(head, name, part, total, begin, end, size, line_size);
+
+    {
+        const char *data = static_cast<const char *>(source.buf) + begin;
+        const size_t length = static_cast<size_t>(end - begin);
+        const size_t bound = head.size() + rapidyenc_encode_max_length(length, line_size) + ARTICLE_TAIL_MAX;
+
+        result = PyBytes_FromStringAndSize(NULL, static_cast<Py_ssize_t>(bound));
+        if (!result) goto done;
+        char *out = PyBytes_AS_STRING(result);
+        memcpy(out, head.data(), head.size());
+        char *body = out + head.size();
+
+        size_t encoded;
+        uint32_t pcrc = 0, crc_end;
+        Py_BEGIN_ALLOW_THREADS;
+        int column = 0;
+        encoded = rapidyenc_encode_ex_crc(line_size, &column, data, body, length, 1, &pcrc);
+        if (!crc_known) crc_before = rapidyenc_crc(source.buf, begin, 0);
+        crc_end = rapidyenc_crc_combine(static_cast<uint32_t>(crc_before), pcrc, length);
+        Py_END_ALLOW_THREADS;
+
+        char *tail = body + encoded;
+        tail += article_yend(tail, part, total, length, pcrc, crc_end);
+
+        if (_PyBytes_Resize(&result, tail - out) < 0) goto done;
+        result = Py_BuildValue("(NII)", result, pcrc, crc_end);
+    }
+
+done:
+    PyBuffer_Release(&source);
+    return result;
+}
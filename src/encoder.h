@@ -0,0 +1,79 @@
+/*
+ * Copyright 2007-2026 The SABnzbd-Team (sabnzbd.org)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef SABCTOOLS_ENCODER_H
+#define SABCTOOLS_ENCODER_H
+
+#include <Python.h>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/*
+ * yEnc encoding of one article in as many chunks as the caller likes.
+ *
+ * yenc_encode() starts every call at column 0 and ends it as the end of an article, so
+ * a part can only be encoded from a single buffer holding all of it. This keeps the
+ * column and the running CRC of the input between calls instead, so a part can be fed
+ * from a file or an mmap a piece at a time, and only the call given is_end escapes the
+ * whitespace a line must not end on. A chunk ending in a space or tab keeps it back
+ * until the next call, so an article ended by an empty chunk can still escape it.
+ *
+ * Output goes into a writable buffer the caller passes, so a posting loop can reuse one
+ * buffer for every chunk, or into a scratch buffer the Encoder keeps and grows, with
+ * the result copied out as bytes.
+ */
+typedef struct {
+    PyObject_HEAD
+
+    char *scratch; // grown on demand, kept for the next call
+    size_t scratch_size;
+    Py_ssize_t bytes_in;
+    Py_ssize_t bytes_out;
+    int line_size;
+    int column;
+    uint32_t crc;
+    char held;  // a space or tab that ended the last chunk, written or escaped by the next call
+    bool ended; // the last call had is_end set; reset() before the next article
+    bool busy;  // an encode is running with the GIL released
+} Encoder;
+
+extern PyTypeObject EncoderType;
+
+bool encoder_init(PyObject *);
+PyObject *build_article(PyObject *, PyObject *, PyObject *);
+
+/* Largest line_size accepted; yEnc posters use 128 and nothing sensible exceeds this */
+#define ENCODER_MAX_LINE_SIZE 8192
+/* Room article_yend() needs: =yend with both CRCs, and the terminator */
+#define ARTICLE_TAIL_MAX 128
+
+/*
+ * The pieces of an article around the encoded body, shared by build_article() and
+ * FileEncoder. The first two need the GIL and raise; the others touch no Python.
+ */
+bool article_text(PyObject *item, std::string_view &text, const char *what);
+bool article_headers(PyObject *headers, std::string &out);
+void article_ybegin(std::string &out, std::string_view name, Py_ssize_t part, Py_ssize_t total, long long begin,
+                    long long end, long long size, int line_size);
+// crc32= is only written on the last part, and is always its last eight characters
+// before the line break and terminator
+size_t article_yend(char *out, Py_ssize_t part, Py_ssize_t total, size_t length, uint32_t pcrc, uint32_t crc);
+
+#endif // SABCTOOLS_ENCODER_H
@@ -0,0 +1,245 @@
+/*
+ * Copyright 2007-2026 The SABnzbd-Team (sabnzbd.org)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "fileassembler.h"
+#include "rapidyenc/rapidyenc.h"
+
+#include <iterator>
+
+static PyObject *FileAssembler_new(PyTypeObject *type, PyObject *Py_UNUSED(args), PyObject *Py_UNUSED(kwds)) {
+    FileAssembler *self = reinterpret_cast<FileAssembler *>(type->tp_alloc(type, 0));
+    if (!self) return NULL;
+    // A real C++ object inside a C struct, so constructed and destroyed by hand
+    new (&self->runs) std::map<long long, AssembledRun>();
+    return reinterpret_cast<PyObject *>(self);
+}
+
+static int FileAssembler_init(FileAssembler *self, PyObject *args, PyObject *kwds) {
+    static const char *kwlist[] = {"size", nullptr};
+    long long size;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "L:FileAssembler", const_cast<char **>(kwlist), &size)) return -1;
+    if (size < 0) {
+        PyErr_SetString(PyExc_ValueError, "size must not be negative");
+        return -1;
+    }
+    self->size = size;
+    self->covered = 0;
+    self->added = 0;
+    self->runs.clear();
+    return 0;
+}
+
+static void FileAssembler_dealloc(FileAssembler *self) {
+    self->runs.~map();
+    Py_TYPE(self)->tp_free(reinterpret_cast<PyObject *>(self));
+}
+
+/* The file's CRC with every byte not recorded yet taken as zero */
+static uint32_t FileAssembler_compute(const FileAssembler *self) {
+    uint32_t crc = 0;
+    long long position = 0;
+    for (const auto &[begin, run] : self->runs) {
+        if (begin > position) crc = rapidyenc_crc_zeros(crc, begin - position);
+        crc = rapidyenc_crc_combine(crc, run.crc, run.end - begin);
+        position = run.end;
+    }
+    if (self->size > position) crc = rapidyenc_crc_zeros(crc, self->size - position);
+    return crc;
+}
+
+/*
+ * add(begin, size, crc)
+ *
+ * Record the CRC32 of file[begin:begin + size], as a response's part_begin, part_size
+ * and crc. Returns the whole file's CRC when this completes the file, otherwise None.
+ * A part overlapping one already recorded is refused: the merged runs no longer know
+ * where the earlier parts began, so a part fetched twice must be added once.
+ */
+static PyObject *FileAssembler_add(FileAssembler *self, PyObject *args, PyObject *kwds) {
+    static const char *kwlist[] = {"begin", "size", "crc", nullptr};
+    long long begin, length;
+    unsigned long long crc_arg;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "LLK:add", const_cast<char **>(kwlist), &begin, &length,
+                                     &crc_arg)) {
+        return NULL;
+    }
+    if (crc_arg > 0xFFFFFFFFULL) {
+        PyErr_SetString(PyExc_OverflowError, "crc must fit in 32 bits");
+        return NULL;
+    }
+    if (begin < 0 || length <= 0 || length > self->size - begin) {
+        PyErr_Format(PyExc_ValueError, "part at %lld of %lld bytes does not fit a file of %lld", begin, length,
+                     self->size);
+        return NULL;
+    }
+    long long end = begin + length;
+    uint32_t crc = static_cast<uint32_t>(crc_arg);
+
+    // The run starting after begin, and the one before it, are the only candidates for
+    // an overlap or a merge
+    auto next = self->runs.upper_bound(begin);
+    auto previous = next == self->runs.begin() ? self->runs.end() : std::prev(next);
+    if ((previous != self->runs.end() && previous->second.end > begin) ||
+        (next != self->runs.end() && next->first < end)) {
+        PyErr_Format(PyExc_ValueError, "part at %lld of %lld bytes overlaps one already added", begin, length);
+        return NULL;
+    }
+
+    if (next != self->runs.end() && next->first == end) {
+        crc = rapidyenc_crc_combine(crc, next->second.crc, next->second.end - end);
+        end = next->second.end;
+        self->runs.erase(next);
+    }
+    if (previous != self->runs.end() && previous->second.end == begin) {
+        previous->second.crc = rapidyenc_crc_combine(previous->second.crc, crc, end - begin);
+        previous->second.end = end;
+    } else {
+        self->runs.emplace(begin, AssembledRun{end, crc});
+    }
+    self->covered += length;
+    self->added++;
+
+    if (self->covered == self->size) return PyLong_FromUnsignedLong(FileAssembler_compute(self));
+    Py_RETURN_NONE;
+}
+
+/* missing() -> [(begin, end), ...], the ranges not recorded yet */
+static PyObject *FileAssembler_missing(FileAssembler *self, PyObject *Py_UNUSED(ignored)) {
+    PyObject *result = PyList_New(0);
+    if (!result) return NULL;
+    long long position = 0;
+    auto append = [result](long long begin, long long end) {
+        PyObject *gap = Py_BuildValue("(LL)", begin, end);
+        if (!gap) return false;
+        const int failed = PyList_Append(result, gap);
+        Py_DECREF(gap);
+        return failed == 0;
+    };
+    for (const auto &[begin, run] : self->runs) {
+        if (begin > position && !append(position, begin)) {
+            Py_DECREF(result);
+            return NULL;
+        }
+        position = run.end;
+    }
+    if (self->size > position && !append(position, self->size)) {
+        Py_DECREF(result);
+        return NULL;
+    }
+    return result;
+}
+
+static PyObject *FileAssembler_get_crc(FileAssembler *self, void *Py_UNUSED(closure)) {
+    return PyLong_FromUnsignedLong(FileAssembler_compute(self));
+}
+
+static PyObject *FileAssembler_get_complete(FileAssembler *self, void *Py_UNUSED(closure)) {
+    return PyBool_FromLong(self->covered == self->size);
+}
+
+static PyObject *FileAssembler_get_size(FileAssembler *self, void *Py_UNUSED(closure)) {
+    return PyLong_FromLongLong(self->size);
+}
+
+static PyObject *FileAssembler_get_covered(FileAssembler *self, void *Py_UNUSED(closure)) {
+    return PyLong_FromLongLong(self->covered);
+}
+
+static PyObject *FileAssembler_get_added(FileAssembler *self, void *Py_UNUSED(closure)) {
+    return PyLong_FromSsize_t(self->added);
+}
+
+static PyObject *FileAssembler_get_runs(FileAssembler *self, void *Py_UNUSED(closure)) {
+    return PyLong_FromSize_t(self->runs.size());
+}
+
+static PyObject *FileAssembler_repr(FileAssembler *self) {
+    return PyUnicode_FromFormat("<sabctools.FileAssembler size=%lld covered=%lld runs=%zu>", self->size,
+                                self->covered, self->runs.size());
+}
+
+static PyMethodDef FileAssembler_methods[] = {
+    {"add", (PyCFunction)(void(*)(void))FileAssembler_add, METH_VARARGS | METH_KEYWORDS,
+     PyDoc_STR("add(begin, size, crc)\n\nRecord a part's CRC32. Returns the file's CRC32 once it is complete, "
+               "otherwise None.")},
+    {"missing", (PyCFunction)FileAssembler_missing, METH_NOARGS,
+     PyDoc_STR("missing()\n\nThe (begin, end) ranges not added yet, in order.")},
+    {NULL}
+};
+
+// Getters rather than members: offsetof is only conditionally supported on a type
+// holding C++ objects, and compilers warn about it
+static PyGetSetDef FileAssembler_getset[] = {
+    {"crc", (getter)FileAssembler_get_crc, NULL,
+     PyDoc_STR("CRC32 of the file, with the ranges not added yet taken as zeros"), NULL},
+    {"complete", (getter)FileAssembler_get_complete, NULL, PyDoc_STR("Every byte has been added"), NULL},
+    {"size", (getter)FileAssembler_get_size, NULL, PyDoc_STR("Size of the file"), NULL},
+    {"covered", (getter)FileAssembler_get_covered, NULL, PyDoc_STR("Bytes added so far"), NULL},
+    {"added", (getter)FileAssembler_get_added, NULL, PyDoc_STR("Parts added so far"), NULL},
+    {"runs", (getter)FileAssembler_get_runs, NULL, PyDoc_STR("Contiguous runs the parts have merged into"), NULL},
+    {NULL}
+};
+
+PyTypeObject FileAssemblerType = {
+    PyVarObject_HEAD_INIT(nullptr, 0)
+    "sabctools.FileAssembler",              // tp_name
+    sizeof(FileAssembler),                  // tp_basicsize
+    0,                                      // tp_itemsize
+    (destructor)FileAssembler_dealloc,      // tp_dealloc
+    0,                                      // tp_vectorcall_offset
+    nullptr,                                // tp_getattr
+    nullptr,                                // tp_setattr
+    nullptr,                                // tp_as_async
+    (reprfunc)FileAssembler_repr,           // tp_repr
+    nullptr,                                // tp_as_number
+    nullptr,                                // tp_as_sequence
+    nullptr,                                // tp_as_mapping
+    nullptr,                                // tp_hash
+    nullptr,                                // tp_call
+    nullptr,                                // tp_str
+    nullptr,                                // tp_getattro
+    nullptr,                                // tp_setattro
+    nullptr,                                // tp_as_buffer
+    Py_TPFLAGS_DEFAULT,                     // tp_flags
+    PyDoc_STR("FileAssembler"),             // tp_doc
+    nullptr,                                // tp_traverse
+    nullptr,                                // tp_clear
+    nullptr,                                // tp_richcompare
+    0,                                      // tp_weaklistoffset
+    nullptr,                                // tp_iter
+    nullptr,                                // tp_iternext
+    FileAssembler_methods,                  // tp_methods
+    nullptr,                                // tp_members
+    FileAssembler_getset,                   // tp_getset
+    nullptr,                                // tp_base
+    nullptr,                                // tp_dict
+    nullptr,                                // tp_descr_get
+    nullptr,                                // tp_descr_set
+    0,                                      // tp_dictoffset
+    (initproc)FileAssembler_init,           // tp_init
+    PyType_GenericAlloc,                    // tp_alloc
+    FileAssembler_new,                      // tp_new
+};
+
+bool fileassembler_init(PyObject *m) {
+    if (PyType_Ready(&FileAssemblerType) < 0) return false;
+    if (PyModule_AddType(m, &FileAssemblerType) < 0) return false;
+    return true;
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright 2007-2026 The SABnzbd-Team (sabnzbd.org)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef SABCTOOLS_FILEASSEMBLER_H
+#define SABCTOOLS_FILEASSEMBLER_H
+
+#include <Python.h>
+
+#include <cstdint>
+#include <map>
+#include <new>
+
+/* A run of the file whose CRC is known: begin is the map key */
+typedef struct {
+    long long end;
+    uint32_t crc;
+} AssembledRun;
+
+/*
+ * The CRC32 of a file put together from articles, without reading the file.
+ *
+ * Every decoded article already carries the CRC of its part and where the part goes.
+ * Parts are recorded as they complete, in any order, and runs that touch are merged
+ * straight away with crc32_combine, so the map holds one entry per contiguous run and
+ * the whole-file CRC is ready the moment the last part lands. A part that never arrives
+ * counts as zeros, which is what a preallocated file holds there.
+ */
+typedef struct {
+    PyObject_HEAD
+
+    long long size;
+    long long covered; // bytes recorded so far
+    Py_ssize_t added;
+    std::map<long long, AssembledRun> runs;
+} FileAssembler;
+
+extern PyTypeObject FileAssemblerType;
+
+bool fileassembler_init(PyObject *);
+
+#endif // SABCTOOLS_FILEASSEMBLER_H
@@ -0,0 +1,473 @@
+/*
+ * Copyright 2007-2026 The SABnzbd-Team (sabnzbd.org)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "fileencoder.h"
+#include "encoder.h"
+#include "filereader.h"
+#include "yenc.h"
+#include "rapidyenc/rapidyenc.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32) || defined(__CYGWIN__)
+#define FILEENCODER_SEPARATORS "/\\"
+#else
+#define FILEENCODER_SEPARATORS "/"
+#endif
+
+/* SABnzbd's default article size */
+#define FILEENCODER_PART_SIZE 716800
+/* The largest part accepted, matching what the decoder accepts for one */
+#define FILEENCODER_MAX_PART_SIZE (10 * 1024 * 1024)
+/* Most workers one file gets, whatever it asks for: each holds a stack and an article */
+#define FILEENCODER_MAX_THREADS 64
+
+/* Read and encode one part into its article. Runs on a worker, without the GIL. */
+static void FileEncoder_encode_part(FileEncoder *self, EncodeJob *job, char *buffer) {
+    if (!buffer) {
+        job->error = FILEREADER_NO_MEMORY;
+        return;
+    }
+    const size_t length = static_cast<size_t>(job->end - job->begin);
+    if (!filereader_read_at(self->handle, buffer, length, job->begin, &job->error)) return;
+
+    char *body = job->out + job->head_size;
+    int column = 0;
+    job->pcrc = 0;
+    const size_t encoded = rapidyenc_encode_ex_crc(self->line_size, &column, buffer, body, length, 1, &job->pcrc);
+    // The last part's crc32= is a placeholder until the iterator knows the file's CRC
+    char *tail = body + encoded;
+    tail += article_yend(tail, job->part, self->parts, length, job->pcrc, 0);
+    job->length = static_cast<size_t>(tail - job->out);
+}
+
+static void FileEncoder_work(FileEncoder *self) {
+    // One read buffer per worker for its whole life, rather than one per part
+    char *buffer = static_cast<char *>(malloc(self->part_size));
+
+    std::unique_lock<std::mutex> guard(self->lock);
+    for (;;) {
+        self->work_ready.wait(guard, [self] { return self->stopping || !self->todo.empty(); });
+        if (self->stopping) break;
+        EncodeJob *job = self->todo.front();
+        self->todo.pop_front();
+
+        guard.unlock();
+        FileEncoder_encode_part(self, job, buffer);
+        guard.lock();
+
+        job->done = true;
+        self->job_done.notify_all();
+    }
+    guard.unlock();
+    free(buffer);
+}
+
+/*
+ * Wind down: the workers finish the part they are on and exit, every unyielded article
+ * is dropped and the file is closed. Afterwards the iterator is exhausted.
+ */
+static void FileEncoder_stop(FileEncoder *self) {
+    {
+        std::lock_guard<std::mutex> guard(self->lock);
+        self->stopping = true;
+        self->todo.clear();
+    }
+    self->work_ready.notify_all();
+
+    if (!self->workers.empty()) {
+        Py_BEGIN_ALLOW_THREADS;
+        for (std::thread &worker : self->workers) worker.join();
+        Py_END_ALLOW_THREADS;
+        self->workers.clear();
+    }
+
+    for (EncodeJob *job : self->jobs) {
+        Py_XDECREF(job->article);
+        delete job;
+    }
+    self->jobs.clear();
+
+    if (self->handle != SABCTOOLS_INVALID_HANDLE) {
+        filereader_close(self->handle);
+        self->handle = SABCTOOLS_INVALID_HANDLE;
+    }
+}
+
+static PyObject *FileEncoder_new(PyTypeObject *type, PyObject *Py_UNUSED(args), PyObject *Py_UNUSED(kwds)) {
+    FileEncoder *self = reinterpret_cast<FileEncoder *>(type->tp_alloc(type, 0));
+    if (!self) return NULL;
+    self->handle = SABCTOOLS_INVALID_HANDLE;
+    // Real C++ objects inside a C struct, so constructed and destroyed by hand
+    new (&self->name) std::string();
+    new (&self->jobs) std::deque<EncodeJob *>();
+    new (&self->todo) std::deque<EncodeJob *>();
+    new (&self->lock) std::mutex();
+    new (&self->work_ready) std::condition_variable();
+    new (&self->job_done) std::condition_variable();
+    new (&self->workers) std::vector<std::thread>();
+    return reinterpret_cast<PyObject *>(self);
+}
+
+/* The =ybegin name when none is given: the last component of the path */
+static bool FileEncoder_default_name(FileEncoder *self, PyObject *fspath) {
+    const char *data;
+    Py_ssize_t length;
+    if (PyUnicode_Check(fspath)) {
+        data = PyUnicode_AsUTF8AndSize(fspath, &length);
+        if (!data) return false;
+    } else {
+        data = PyBytes_AS_STRING(fspath);
+        length = PyBytes_GET_SIZE(fspath);
+    }
+    const std::string_view path(data, length);
+    const size_t separator = path.find_last_of(FILEENCODER_SEPARATORS);
+    self->name = separator == std::string_view::npos ? path : path.substr(separator + 1);
+    return true;
+}
+
+static int FileEncoder_init(FileEncoder *self, PyObject *args, PyObject *kwds) {
+    static const char *kwlist[] = {"path",   "part_size", "line_size", "threads",
+                                   "window", "name",      "headers",   nullptr};
+    PyObject *path;
+    Py_ssize_t part_size = FILEENCODER_PART_SIZE;
+    int line_size = YENC_LINESIZE;
+    int threads = 0;
+    Py_ssize_t window = 0;
+    PyObject *name = Py_None;
+    PyObject *headers = Py_None;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|niinOO:FileEncoder", const_cast<char **>(kwlist), &path,
+                                     &part_size, &line_size, &threads, &window, &name, &headers)) {
+        return -1;
+    }
+    if (self->path) {
+        PyErr_SetString(PyExc_RuntimeError, "FileEncoder cannot be reinitialized");
+        return -1;
+    }
+    if (part_size < 1 || part_size > FILEENCODER_MAX_PART_SIZE) {
+        PyErr_Format(PyExc_ValueError, "part_size must be between 1 and %d", FILEENCODER_MAX_PART_SIZE);
+        return -1;
+    }
+    if (line_size < 2 || line_size > ENCODER_MAX_LINE_SIZE) {
+        PyErr_Format(PyExc_ValueError, "line_size must be between 2 and %d", ENCODER_MAX_LINE_SIZE);
+        return -1;
+    }
+    if (threads < 0 || window < 0) {
+        PyErr_SetString(PyExc_ValueError, "threads and window must not be negative");
+        return -1;
+    }
+
+    PyObject *fspath = PyOS_FSPath(path);
+    if (!fspath) return -1;
+
+    if (Py_IsNone(name)) {
+        if (!FileEncoder_default_name(self, fspath)) {
+            Py_DECREF(fspath);
+            return -1;
+        }
+    } else {
+        std::string_view text;
+        if (!article_text(name, text, "name")) {
+            Py_DECREF(fspath);
+            return -1;
+        }
+        self->name = text;
+    }
+
+    if (!filereader_open(fspath, &self->handle, &self->size)) {
+        Py_DECREF(fspath);
+        return -1;
+    }
+    self->path = fspath;
+    self->headers = Py_NewRef(headers);
+    self->part_size = part_size;
+    self->line_size = line_size;
+    self->parts = static_cast<Py_ssize_t>((self->size + part_size - 1) / part_size);
+
+    if (threads == 0) threads = static_cast<int>(std::thread::hardware_concurrency());
+    if (threads < 1) threads = 1;
+    if (threads > FILEENCODER_MAX_THREADS) threads = FILEENCODER_MAX_THREADS;
+    if (threads > self->parts) threads = static_cast<int>(self->parts);
+    // Twice the workers: one article each being encoded, one each waiting to be taken
+    self->window = window ? window : 2 * static_cast<Py_ssize_t>(threads);
+
+    for (int i = 0; i < threads; i++) self->workers.emplace_back(FileEncoder_work, self);
+    if (self->parts == 0) FileEncoder_stop(self);
+    return 0;
+}
+
+/* Hand parts to the pool until the window is full. Needs the GIL, for the headers. */
+static bool FileEncoder_schedule(FileEncoder *self) {
+    while (self->scheduled < self->parts && static_cast<Py_ssize_t>(self->jobs.size()) < self->window) {
+        const Py_ssize_t part = self->scheduled + 1;
+        const long long begin = static_cast<long long>(self->scheduled) * self->part_size;
+        const long long end = std::min(begin + self->part_size, self->size);
+
+        std::string head;
+        PyObject *headers = PyCallable_Check(self->headers)
+                                ? PyObject_CallFunction(self->headers, "nn", part, self->parts)
+                                : Py_NewRef(self->headers);
+        if (!headers) return false;
+        const bool ok = Py_IsNone(headers) || article_headers(headers, head);
+        Py_DECREF(headers);
+        if (!ok) return false;
+        // The headers callback is the caller's code, and could have closed us
+        if (self->stopping) {
+            PyErr_SetString(PyExc_ValueError, "FileEncoder was closed");
+            return false;
+        }
+        article_ybegin(head, self->name, part, self->parts, begin, end, self->size, self->line_size);
+
+        const size_t bound = head.size() + rapidyenc_encode_max_length(static_cast<size_t>(end - begin),
+                                                                        self->line_size) + ARTICLE_TAIL_MAX;
+        PyObject *article = PyBytes_FromStringAndSize(NULL, static_cast<Py_ssize_t>(bound));
+        if (!article) return false;
+        EncodeJob *job = new (std::nothrow) EncodeJob();
+        if (!job) {
+            Py_DECREF(article);
+            PyErr_NoMemory();
+            return false;
+        }
+        job->article = article;
+        job->out = PyBytes_AS_STRING(article);
+        job->part = part;
+        job->begin = begin;
+        job->end = end;
+        job->head_size = head.size();
+        memcpy(job->out, head.data(), head.size());
+
+        self->jobs.push_back(job);
+        {
+            std::lock_guard<std::mutex> guard(self->lock);
+            self->todo.push_back(job);
+        }
+        self->work_ready.notify_one();
+        self->scheduled++;
+    }
+    return true;
+}
+
+static bool FileEncoder_check_idle(FileEncoder *self) {
+    if (self->busy) {
+        PyErr_SetString(PyExc_RuntimeError, "FileEncoder is in use by another thread");
+        return false;
+    }
+    return true;
+}
+
+/*
+ * The next article, as (article, part, begin, end, pcrc32).
+ *
+ * Waits, with the GIL released, for the oldest part in flight, so articles come out in
+ * order whichever worker finishes first. Tops the window up before waiting, so the pool
+ * keeps working while the caller sends what it was given.
+ */
+static PyObject *FileEncoder_next(FileEncoder *self) {
+    if (self->stopping || self->yielded >= self->parts) return NULL;
+    if (!FileEncoder_check_idle(self)) return NULL;
+    if (!FileEncoder_schedule(self)) return NULL;
+
+    EncodeJob *job = self->jobs.front();
+    self->busy = true;
+    Py_BEGIN_ALLOW_THREADS;
+    {
+        std::unique_lock<std::mutex> guard(self->lock);
+        self->job_done.wait(guard, [job] { return job->done; });
+    }
+    Py_END_ALLOW_THREADS;
+    self->busy = false;
+    self->jobs.pop_front();
+
+    PyObject *article = job->article;
+    if (job->error) {
+        filereader_raise(job->error, self->path);
+        Py_DECREF(article);
+        delete job;
+        // Nothing after a part that could not be read is worth posting
+        FileEncoder_stop(self);
+        return NULL;
+    }
+
+    const long long length = job->end - job->begin;
+    self->crc = rapidyenc_crc_combine(self->crc, job->pcrc, length);
+    if (job->part == self->parts) {
+        // The placeholder sits right before "\r\n.\r\n"
+        char digits[9];
+        snprintf(digits, sizeof(digits), "%08x", self->crc);
+        memcpy(job->out + job->length - 5 - 8, digits, 8);
+    }
+    const Py_ssize_t part = job->part;
+    const long long begin = job->begin, end = job->end;
+    const uint32_t pcrc = job->pcrc;
+    const size_t used = job->length;
+    delete job;
+    self->yielded++;
+
+    // The worst case was allocated; give the rest back
+    if (_PyBytes_Resize(&article, static_cast<Py_ssize_t>(used)) < 0) return NULL;
+    if (self->yielded == self->parts) FileEncoder_stop(self);
+    return Py_BuildValue("(NnLLk)", article, part, begin, end, static_cast<unsigned long>(pcrc));
+}
+
+static PyObject *FileEncoder_close(FileEncoder *self, PyObject *Py_UNUSED(ignored)) {
+    if (!FileEncoder_check_idle(self)) return NULL;
+    FileEncoder_stop(self);
+    Py_RETURN_NONE;
+}
+
+static PyObject *FileEncoder_enter(FileEncoder *self, PyObject *Py_UNUSED(ignored)) {
+    return Py_NewRef(reinterpret_cast<PyObject *>(self));
+}
+
+static PyObject *FileEncoder_exit(FileEncoder *self, PyObject *Py_UNUSED(args)) {
+    return FileEncoder_close(self, NULL);
+}
+
+static int FileEncoder_traverse(FileEncoder *self, visitproc visit, void *arg) {
+    Py_VISIT(self->headers);
+    return 0;
+}
+
+static int FileEncoder_clear(FileEncoder *self) {
+    Py_CLEAR(self->headers);
+    return 0;
+}
+
+static void FileEncoder_dealloc(FileEncoder *self) {
+    PyObject_GC_UnTrack(self);
+    FileEncoder_stop(self);
+    Py_XDECREF(self->headers);
+    Py_XDECREF(self->path);
+    self->name.~basic_string();
+    self->jobs.~deque();
+    self->todo.~deque();
+    self->lock.~mutex();
+    self->work_ready.~condition_variable();
+    self->job_done.~condition_variable();
+    self->workers.~vector();
+    Py_TYPE(self)->tp_free(reinterpret_cast<PyObject *>(self));
+}
+
+// Getters rather than members: offsetof is only conditionally supported on a type
+// holding C++ objects, and compilers warn about it
+static PyObject *FileEncoder_get_parts(FileEncoder *self, void *Py_UNUSED(closure)) {
+    return PyLong_FromSsize_t(self->parts);
+}
+
+static PyObject *FileEncoder_get_yielded(FileEncoder *self, void *Py_UNUSED(closure)) {
+    return PyLong_FromSsize_t(self->yielded);
+}
+
+static PyObject *FileEncoder_get_size(FileEncoder *self, void *Py_UNUSED(closure)) {
+    return PyLong_FromLongLong(self->size);
+}
+
+static PyObject *FileEncoder_get_crc(FileEncoder *self, void *Py_UNUSED(closure)) {
+    return PyLong_FromUnsignedLong(self->crc);
+}
+
+static PyObject *FileEncoder_get_threads(FileEncoder *self, void *Py_UNUSED(closure)) {
+    return PyLong_FromSize_t(self->workers.size());
+}
+
+static PyObject *FileEncoder_get_window(FileEncoder *self, void *Py_UNUSED(closure)) {
+    return PyLong_FromSsize_t(self->window);
+}
+
+static PyObject *FileEncoder_get_path(FileEncoder *self, void *Py_UNUSED(closure)) {
+    return Py_NewRef(self->path ? self->path : Py_None);
+}
+
+static PyObject *FileEncoder_repr(FileEncoder *self) {
+    return PyUnicode_FromFormat("<sabctools.FileEncoder path=%R parts=%zd yielded=%zd>",
+                                self->path ? self->path : Py_None, self->parts, self->yielded);
+}
+
+static PyMethodDef FileEncoder_methods[] = {
+    {"close", (PyCFunction)FileEncoder_close, METH_NOARGS,
+     PyDoc_STR("close()\n\nStop the workers, drop the articles not yielded yet and close the file.")},
+    {"__enter__", (PyCFunction)FileEncoder_enter, METH_NOARGS, NULL},
+    {"__exit__", (PyCFunction)FileEncoder_exit, METH_VARARGS, NULL},
+    {NULL}
+};
+
+static PyGetSetDef FileEncoder_getset[] = {
+    {"parts", (getter)FileEncoder_get_parts, NULL, PyDoc_STR("Articles the file is split into"), NULL},
+    {"yielded", (getter)FileEncoder_get_yielded, NULL, PyDoc_STR("Articles yielded so far"), NULL},
+    {"size", (getter)FileEncoder_get_size, NULL, PyDoc_STR("Size of the file when it was opened"), NULL},
+    {"crc", (getter)FileEncoder_get_crc, NULL,
+     PyDoc_STR("CRC32 of the parts yielded so far; the file's once all have been"), NULL},
+    {"threads", (getter)FileEncoder_get_threads, NULL, PyDoc_STR("Workers still running"), NULL},
+    {"window", (getter)FileEncoder_get_window, NULL, PyDoc_STR("Most articles in flight at once"), NULL},
+    {"path", (getter)FileEncoder_get_path, NULL, PyDoc_STR("Path the file was opened with"), NULL},
+    {NULL}
+};
+
+PyTypeObject FileEncoderType = {
+    PyVarObject_HEAD_INIT(nullptr, 0)
+    "sabctools.FileEncoder",                // tp_name
+    sizeof(FileEncoder),                    // tp_basicsize
+    0,                                      // tp_itemsize
+    (destructor)FileEncoder_dealloc,        // tp_dealloc
+    0,                                      // tp_vectorcall_offset
+    nullptr,                                // tp_getattr
+    nullptr,                                // tp_setattr
+    nullptr,                                // tp_as_async
+    (reprfunc)FileEncoder_repr,             // tp_repr
+    nullptr,                                // tp_as_number
+    nullptr,                                // tp_as_sequence
+    nullptr,                                // tp_as_mapping
+    nullptr,                                // tp_hash
+    nullptr,                                // tp_call
+    nullptr,                                // tp_str
+    nullptr,                                // tp_getattro
+    nullptr,                                // tp_setattro
+    nullptr,                                // tp_as_buffer
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC, // tp_flags
+    PyDoc_STR("FileEncoder"),               // tp_doc
+    (traverseproc)FileEncoder_traverse,     // tp_traverse
+    (inquiry)FileEncoder_clear,             // tp_clear
+    nullptr,                                // tp_richcompare
+    0,                                      // tp_weaklistoffset
+    PyObject_SelfIter,                      // tp_iter
+    (iternextfunc)FileEncoder_next,         // tp_iternext
+    FileEncoder_methods,                    // tp_methods
+    nullptr,                                // tp_members
+    FileEncoder_getset,                     // tp_getset
+    nullptr,                                // tp_base
+    nullptr,                                // tp_dict
+    nullptr,                                // tp_descr_get
+    nullptr,                                // tp_descr_set
+    0,                                      // tp_dictoffset
+    (initproc)FileEncoder_init,             // tp_init
+    PyType_GenericAlloc,                    // tp_alloc
+    FileEncoder_new,                        // tp_new
+};
+
+/* encode_file(path, ...) is FileEncoder(path, ...), under the name it is used by */
+PyObject *encode_file(PyObject *Py_UNUSED(self), PyObject *args, PyObject *kwds) {
+    return PyObject_Call(reinterpret_cast<PyObject *>(&FileEncoderType), args, kwds);
+}
+
+bool fileencoder_init(PyObject *m) {
+    if (PyType_Ready(&FileEncoderType) < 0) return false;
+    if (PyModule_AddType(m, &FileEncoderType) < 0) return false;
+    return true;
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright 2007-2026 The SABnzbd-Team (sabnzbd.org)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef SABCTOOLS_FILEENCODER_H
+#define SABCTOOLS_FILEENCODER_H
+
+#include <Python.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "filewriter.h"
+
+/* One part on its way through the pool */
+typedef struct {
+    PyObject *article;  // bytes sized for the worst case, filled by a worker without the GIL
+    char *out;          // its storage, taken while the GIL was held
+    Py_ssize_t part;    // 1-based
+    long long begin;    // 0-based file offsets
+    long long end;
+    size_t head_size;   // headers, =ybegin and =ypart, already in article
+    size_t length;      // of the finished article
+    uint32_t pcrc;
+    unsigned long error; // errno, or the Windows error code, from reading the part
+    bool done;
+} EncodeJob;
+
+/*
+ * A file turned into articles on a pool of threads, yielded in order.
+ *
+ * Posting a large upload is bound by encoding and CRC on one core. Here each part is
+ * read with a positional read and encoded on a worker of its own, straight into the
+ * bytes object that is eventually yielded. The number of parts in flight is bounded by
+ * the window, so memory stays at about window articles however large the file.
+ *
+ * Every part's =yend carries its own pcrc32. The whole-file crc32 on the last part is
+ * not known until every earlier part is done, so its worker leaves room for it and the
+ * iterator fills it in, combining the part CRCs in order as it yields them.
+ */
+typedef struct {
+    PyObject_HEAD
+
+    FileHandle handle;
+    PyObject *path;
+    PyObject *headers; // None, a mapping, or a callable(part, total) returning either
+    std::string name;
+    long long size;
+    Py_ssize_t part_size;
+    Py_ssize_t parts;
+    Py_ssize_t scheduled; // parts handed to the pool so far
+    Py_ssize_t yielded;
+    Py_ssize_t window;
+    int line_size;
+    uint32_t crc; // of everything yielded so far
+
+    // Scheduled and not yet yielded, in part order; owned here, the workers only borrow
+    std::deque<EncodeJob *> jobs;
+    // Guarded by lock: the jobs no worker has picked up yet, and each job's done flag
+    std::deque<EncodeJob *> todo;
+    std::mutex lock;
+    std::condition_variable work_ready;
+    std::condition_variable job_done;
+    std::vector<std::thread> workers;
+    bool stopping;
+    bool busy; // next() is waiting with the GIL released, so nothing may free the jobs
+} FileEncoder;
+
+extern PyTypeObject FileEncoderType;
+
+bool fileencoder_init(PyObject *);
+PyObject *encode_file(PyObject *, PyObject *, PyObject *);
+
+#endif // SABCTOOLS_FILEENCODER_H
@@ -0,0 +1,134 @@
+/*
+ * Copyright 2007-2026 The SABnzbd-Team (sabnzbd.org)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "filereader.h"
+
+#include <errno.h>
+// memset, for zeroing the OVERLAPPED on Windows
+#include <string.h>
+
+#if !defined(_WIN32) && !defined(__CYGWIN__)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
+
+bool filereader_open(PyObject *fspath, FileHandle *handle, long long *size) {
+#if defined(_WIN32) || defined(__CYGWIN__)
+    PyObject *as_str = NULL;
+    if (PyBytes_Check(fspath)) {
+        as_str = PyUnicode_DecodeFSDefaultAndSize(PyBytes_AS_STRING(fspath), PyBytes_GET_SIZE(fspath));
+        if (!as_str) return false;
+    }
+    wchar_t *wide = PyUnicode_AsWideCharString(as_str ? as_str : fspath, NULL);
+    Py_XDECREF(as_str);
+    if (!wide) return false;
+
+    HANDLE opened;
+    LARGE_INTEGER measured;
+    bool ok = false;
+    Py_BEGIN_ALLOW_THREADS;
+    opened = CreateFileW(wide, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+                         OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (opened != INVALID_HANDLE_VALUE) ok = GetFileSizeEx(opened, &measured);
+    Py_END_ALLOW_THREADS;
+    PyMem_Free(wide);
+
+    if (!ok) {
+        PyErr_SetExcFromWindowsErrWithFilenameObject(PyExc_OSError, 0, fspath);
+        if (opened != INVALID_HANDLE_VALUE) CloseHandle(opened);
+        return false;
+    }
+    *handle = opened;
+    *size = measured.QuadPart;
+#else
+    PyObject *encoded = NULL;
+    if (!PyUnicode_FSConverter(fspath, &encoded)) return false;
+
+    int opened;
+    struct stat info;
+    int measured = -1;
+    const char *filename = PyBytes_AS_STRING(encoded);
+    Py_BEGIN_ALLOW_THREADS;
+    do {
+        opened = open(filename, O_RDONLY | O_CLOEXEC);
+    } while (opened < 0 && errno == EINTR);
+    if (opened >= 0) measured = fstat(opened, &info);
+    Py_END_ALLOW_THREADS;
+    Py_DECREF(encoded);
+
+    if (measured < 0) {
+        PyErr_SetFromErrnoWithFilenameObject(PyExc_OSError, fspath);
+        if (opened >= 0) close(opened);
+        return false;
+    }
+    *handle = opened;
+    *size = info.st_size;
+#endif
+    return true;
+}
+
+bool filereader_read_at(FileHandle handle, char *buffer, size_t length, long long offset, unsigned long *error) {
+    while (length > 0) {
+#if defined(_WIN32) || defined(__CYGWIN__)
+        OVERLAPPED overlapped;
+        memset(&overlapped, 0, sizeof(overlapped));
+        overlapped.Offset = static_cast<DWORD>(offset & 0xFFFFFFFF);
+        overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        DWORD got = 0;
+        const DWORD want = length > 0x40000000 ? 0x40000000 : static_cast<DWORD>(length);
+        if (!ReadFile(handle, buffer, want, &got, &overlapped)) {
+            *error = GetLastError();
+            return false;
+        }
+#else
+        const ssize_t got = pread(handle, buffer, length, static_cast<off_t>(offset));
+        if (got < 0) {
+            if (errno == EINTR) continue;
+            *error = errno;
+            return false;
+        }
+#endif
+        if (got == 0) {
+            // The file shrank after it was measured
+            *error = FILEREADER_SHORT_READ;
+            return false;
+        }
+        buffer += got;
+        length -= got;
+        offset += got;
+    }
+    return true;
+}
+
+void filereader_close(FileHandle handle) {
+#if defined(_WIN32) || defined(__CYGWIN__)
+    CloseHandle(handle);
+#else
+    close(handle);
+#endif
+}
+
+void filereader_raise(unsigned long error, PyObject *fspath) {
+#if defined(_WIN32) || defined(__CYGWIN__)
+    PyErr_SetExcFromWindowsErrWithFilenameObject(PyExc_OSError, error, fspath);
+#else
+    errno = static_cast<int>(error);
+    PyErr_SetFromErrnoWithFilenameObject(PyExc_OSError, fspath);
+#endif
+}
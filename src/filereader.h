@@ -0,0 +1,57 @@
+/*
+ * Copyright 2007-2026 The SABnzbd-Team (sabnzbd.org)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef SABCTOOLS_FILEREADER_H
+#define SABCTOOLS_FILEREADER_H
+
+#include <Python.h>
+
+#include <cstddef>
+#include <errno.h>
+
+#include "filewriter.h"
+
+/*
+ * Positional reads from a file, for the native code that hashes or encodes files on
+ * threads of its own. Reads carry their offset, so any number of threads share one
+ * handle without locking; nothing but filereader_open needs the GIL.
+ */
+
+/* The errors filereader_read_at reports without an OS call to blame */
+#if defined(_WIN32) || defined(__CYGWIN__)
+#define FILEREADER_NO_MEMORY ERROR_NOT_ENOUGH_MEMORY
+#define FILEREADER_SHORT_READ ERROR_HANDLE_EOF
+#else
+#define FILEREADER_NO_MEMORY ENOMEM
+#define FILEREADER_SHORT_READ EIO
+#endif
+
+/* Open a str, bytes or os.PathLike path (already through os.fspath) and measure it.
+   Raises OSError with the filename on failure. */
+bool filereader_open(PyObject *fspath, FileHandle *handle, long long *size);
+
+/* Read exactly length bytes at offset. On failure sets *error to errno, or the Windows
+   error code, and returns false; a file that ends early is FILEREADER_SHORT_READ. */
+bool filereader_read_at(FileHandle handle, char *buffer, size_t length, long long offset, unsigned long *error);
+
+void filereader_close(FileHandle handle);
+
+/* Raise the OSError for an error from filereader_read_at */
+void filereader_raise(unsigned long error, PyObject *fspath);
+
+#endif // SABCTOOLS_FILEREADER_H
@@ -18,14 +18,26 @@
 
 #include "filewriter.h"
 
+#include <algorithm>
+#include <vector>
+
 #include <errno.h>
-// memset, for zeroing the OVERLAPPED on Windows
+#include <stdint.h>
+#include <stdlib.h>
+// memset, for zeroing the OVERLAPPED on Windows, and memcpy into the direct bounce buffer
 #include <string.h>
 
 #if !defined(_WIN32) && !defined(__CYGWIN__)
 #include <fcntl.h>
+#include <limits.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/uio.h>
+#endif
+
+// macOS only has pwritev from 11, later than the oldest release wheels are built for
+#if defined(__linux__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__)
+#define SABCTOOLS_HAVE_PWRITEV 1
 #endif
 
 /*
@@ -36,14 +48,75 @@
  */
 #define FILEWRITER_MAX_CHUNK ((Py_ssize_t)0x3FFFF000)
 
+/*
+ * O_DIRECT wants the offset, the length and the memory all aligned to the device's
+ * logical block size. 4096 is a multiple of every block size in use, 512-byte sectors
+ * included, and asking the device instead (statx STATX_DIOALIGN) needs Linux 6.1.
+ */
+#define FILEWRITER_DIRECT_ALIGN 4096
+
+/* Source memory that is not aligned is copied through this much aligned memory per thread */
+#define FILEWRITER_DIRECT_BOUNCE (1024 * 1024)
+
+#ifdef O_DIRECT
+namespace {
+struct DirectBounce {
+    char *buffer = nullptr;
+    ~DirectBounce() { free(buffer); }
+};
+thread_local DirectBounce direct_bounce;
+} // namespace
+#endif
+
+/*
+ * Counts one operation into users for as long as it lives, so close() waits for it, or
+ * finds close() under way and lets go at once. Test it before touching the handle: it
+ * is false once close() has begun, and for a writer that was never opened - made with
+ * __new__ alone, or whose __init__ failed - which has no handle to touch.
+ *
+ * Both sides are one read-modify-write of the same word, so there is no window in which
+ * an operation and close() each miss the other: whichever comes first in that word's
+ * order is seen by the other.
+ */
+class FileWriterUse {
+  public:
+    explicit FileWriterUse(FileWriter *writer) : writer(writer) {
+        open = !(writer->users.fetch_add(1, std::memory_order_acquire) & FILEWRITER_CLOSING) &&
+               writer->handle != SABCTOOLS_INVALID_HANDLE;
+    }
+    ~FileWriterUse() {
+        // The last one out after close() has begun wakes it. The notify is made under
+        // close_lock so it cannot fall between close() testing the count and sleeping.
+        if (writer->users.fetch_sub(1, std::memory_order_release) == (FILEWRITER_CLOSING | 1)) {
+            std::lock_guard<std::mutex> guard(writer->close_lock);
+            writer->drained.notify_all();
+        }
+    }
+    explicit operator bool() const { return open; }
+
+  private:
+    FileWriter *writer;
+    bool open;
+};
+
 static PyObject *FileWriter_new(PyTypeObject *type, PyObject *Py_UNUSED(args), PyObject *Py_UNUSED(kwargs)) {
     FileWriter *self = (FileWriter *)type->tp_alloc(type, 0);
     if (!self) return NULL;
     self->handle = SABCTOOLS_INVALID_HANDLE;
+    self->direct_handle = SABCTOOLS_INVALID_HANDLE;
     self->path = NULL;
-    // The mutex is a real C++ object inside a C struct, so it has to be constructed
-    // and destroyed by hand
-    new (&self->lock) std::shared_mutex();
+    // These are real C++ objects inside a C struct, so they have to be constructed and
+    // destroyed by hand
+    new (&self->users) std::atomic<uint32_t>(0);
+    new (&self->close_lock) std::mutex();
+    new (&self->drained) std::condition_variable();
+    self->uring = false;
+    self->direct = false;
+    new (&self->queued) std::atomic<long>(0);
+    self->writeback = 0;
+    new (&self->writeback_filled) std::unordered_map<long long, long long>();
+    new (&self->writeback_started) std::vector<long long>();
+    new (&self->writeback_lock) std::mutex();
     return (PyObject *)self;
 }
 
@@ -54,17 +127,28 @@ static void filewriter_close_handle(FileWriter *self) {
         CloseHandle(self->handle);
 #else
         close(self->handle);
+        if (self->direct_handle != SABCTOOLS_INVALID_HANDLE) close(self->direct_handle);
 #endif
         self->handle = SABCTOOLS_INVALID_HANDLE;
+        self->direct_handle = SABCTOOLS_INVALID_HANDLE;
     }
 }
 
 static int FileWriter_init(FileWriter *self, PyObject *args, PyObject *kwargs) {
-    static char *keywords[] = {(char *)"path", NULL};
+    static char *keywords[] = {(char *)"path", (char *)"io_uring", (char *)"direct", (char *)"writeback", NULL};
     PyObject *path_obj = NULL;
+    int io_uring = 0;
+    int direct = 0;
+    long long writeback = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|ppL:FileWriter", keywords, &path_obj, &io_uring, &direct,
+                                     &writeback))
+        return -1;
 
-    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O:FileWriter", keywords, &path_obj))
+    if (writeback < 0) {
+        PyErr_SetString(PyExc_ValueError, "writeback must not be negative");
         return -1;
+    }
 
     if (self->handle != SABCTOOLS_INVALID_HANDLE) {
         PyErr_SetString(PyExc_RuntimeError, "FileWriter is already open");
@@ -118,11 +202,29 @@ static int FileWriter_init(FileWriter *self, PyObject *args, PyObject *kwargs) {
     }
 
     int handle;
+    int direct_handle = -1;
     const char *filename = PyBytes_AS_STRING(encoded);
     Py_BEGIN_ALLOW_THREADS
     do {
         handle = open(filename, O_CREAT | O_WRONLY, 0666);
     } while (handle < 0 && errno == EINTR);
+
+    // Like io_uring, a request: a filesystem without O_DIRECT (tmpfs, some FUSE) refuses
+    // the second open, and the writer carries on through the page cache
+    if (handle >= 0 && direct) {
+#ifdef O_DIRECT
+        do {
+            direct_handle = open(filename, O_WRONLY | O_DIRECT);
+        } while (direct_handle < 0 && errno == EINTR);
+        direct = direct_handle >= 0;
+#elif defined(F_NOCACHE)
+        // macOS has no O_DIRECT, but will keep a descriptor's writes out of the cache,
+        // and without any alignment rules
+        direct = fcntl(handle, F_NOCACHE, 1) == 0;
+#else
+        direct = 0;
+#endif
+    }
     Py_END_ALLOW_THREADS
     Py_DECREF(encoded);
 
@@ -134,6 +236,26 @@ static int FileWriter_init(FileWriter *self, PyObject *args, PyObject *kwargs) {
 #endif
 
     self->handle = handle;
+#if defined(_WIN32) || defined(__CYGWIN__)
+    // FILE_FLAG_NO_BUFFERING would hold every write, head and tail included, to sector
+    // alignment; Windows stays buffered
+    self->direct = false;
+#else
+    self->direct_handle = direct_handle;
+    self->direct = direct;
+#endif
+#ifdef SYNC_FILE_RANGE_WRITE
+    self->writeback = writeback;
+#endif
+    // Whatever a previous file left counted does not apply to this one
+    self->writeback_filled.clear();
+    self->writeback_started.clear();
+    // A request, not a requirement: without a ring the writes stay with pwrite
+    self->uring = io_uring && uring_available();
+    // Open again after a close(), which left the closing bit set. Only the bit is
+    // cleared: an operation that lost to close() may not have left users yet, and its
+    // decrement still has to find its increment there.
+    self->users.fetch_and(~FILEWRITER_CLOSING, std::memory_order_release);
     Py_XSETREF(self->path, fspath);
     return 0;
 }
@@ -141,31 +263,23 @@ static int FileWriter_init(FileWriter *self, PyObject *args, PyObject *kwargs) {
 static void FileWriter_dealloc(FileWriter *self) {
     filewriter_close_handle(self);
     Py_CLEAR(self->path);
-    self->lock.~shared_mutex();
+    self->users.~atomic();
+    self->close_lock.~mutex();
+    self->drained.~condition_variable();
+    self->queued.~atomic();
+    self->writeback_filled.~unordered_map();
+    self->writeback_started.~vector();
+    self->writeback_lock.~mutex();
     Py_TYPE(self)->tp_free((PyObject *)self);
 }
 
 /*
- * Write the whole buffer at an absolute offset.
- *
- * The GIL is dropped for the duration, so nothing here may touch the Python API; the
- * buffer is pinned by the caller beforehand and any failure is carried out as an
- * error number and raised once the GIL is back.
+ * Write the whole buffer at an absolute offset through one handle, in chunks, retrying
+ * short writes. Returns the bytes written, short only when *error_code is set.
  */
-Py_ssize_t filewriter_write_raw(FileWriter *writer, const char *buffer, Py_ssize_t length, long long offset,
-                                bool *was_closed, unsigned long *error_code) {
+static Py_ssize_t filewriter_write_at(FileHandle handle, const char *buffer, Py_ssize_t length, long long offset,
+                                      unsigned long *error_code) {
     Py_ssize_t written_total = 0;
-    *was_closed = false;
-    *error_code = 0;
-
-    // Shared: concurrent writes are allowed and are the whole point. Only close()
-    // takes this exclusively, so the handle cannot be pulled away mid-write.
-    std::shared_lock<std::shared_mutex> guard(writer->lock);
-
-    if (writer->handle == SABCTOOLS_INVALID_HANDLE) {
-        *was_closed = true;
-        return 0;
-    }
 
     while (written_total < length) {
         Py_ssize_t remaining = length - written_total;
@@ -183,7 +297,7 @@ Py_ssize_t filewriter_write_raw(FileWriter *writer, const char *buffer, Py_ssize
         overlapped.OffsetHigh = position.HighPart;
 
         DWORD written = 0;
-        if (!WriteFile(writer->handle, buffer + written_total, (DWORD)remaining, &written, &overlapped)) {
+        if (!WriteFile(handle, buffer + written_total, (DWORD)remaining, &written, &overlapped)) {
             *error_code = (unsigned long)GetLastError();
             break;
         }
@@ -193,8 +307,7 @@ Py_ssize_t filewriter_write_raw(FileWriter *writer, const char *buffer, Py_ssize
         }
         written_total += (Py_ssize_t)written;
 #else
-        ssize_t written = pwrite(writer->handle, buffer + written_total, (size_t)remaining,
-                                 (off_t)(offset + written_total));
+        ssize_t written = pwrite(handle, buffer + written_total, (size_t)remaining, (off_t)(offset + written_total));
         if (written < 0) {
             if (errno == EINTR) continue;
             *error_code = (unsigned long)errno;
@@ -213,6 +326,160 @@ Py_ssize_t filewriter_write_raw(FileWriter *writer, const char *buffer, Py_ssize
     return written_total;
 }
 
+#ifdef O_DIRECT
+/*
+ * Write the block-aligned middle through the O_DIRECT descriptor and the unaligned
+ * head and tail through the buffered one.
+ *
+ * Holding the head and tail back until the neighbouring articles complete their blocks
+ * would keep them out of the cache too, but it would also make the file's contents
+ * depend on writes that may never come, for a few KB per article. Written buffered,
+ * they are coherent with the direct writes: the two only ever meet in a block that
+ * neither writes whole, and the kernel flushes cached pages over a range before writing
+ * it direct.
+ */
+static Py_ssize_t filewriter_write_direct(FileWriter *writer, const char *buffer, Py_ssize_t length,
+                                          long long offset, unsigned long *error_code) {
+    const Py_ssize_t align = FILEWRITER_DIRECT_ALIGN;
+    Py_ssize_t head = (Py_ssize_t)((align - offset % align) % align);
+    if (head > length) head = length;
+    const Py_ssize_t middle = (length - head) & ~(align - 1);
+    if (middle == 0) return filewriter_write_at(writer->handle, buffer, length, offset, error_code);
+
+    Py_ssize_t written = filewriter_write_at(writer->handle, buffer, head, offset, error_code);
+    if (written < head) return written;
+
+    const char *source = buffer + head;
+    Py_ssize_t done = 0;
+    if (((uintptr_t)source & (uintptr_t)(align - 1)) == 0) {
+        done = filewriter_write_at(writer->direct_handle, source, middle, offset + head, error_code);
+    } else {
+        if (!direct_bounce.buffer &&
+            posix_memalign(reinterpret_cast<void **>(&direct_bounce.buffer), align, FILEWRITER_DIRECT_BOUNCE) != 0) {
+            direct_bounce.buffer = nullptr;
+            *error_code = (unsigned long)ENOMEM;
+            return head;
+        }
+        while (done < middle) {
+            Py_ssize_t piece = middle - done;
+            if (piece > FILEWRITER_DIRECT_BOUNCE) piece = FILEWRITER_DIRECT_BOUNCE;
+            memcpy(direct_bounce.buffer, source + done, (size_t)piece);
+            written = filewriter_write_at(writer->direct_handle, direct_bounce.buffer, piece, offset + head + done,
+                                          error_code);
+            done += written;
+            if (written < piece) break;
+        }
+    }
+    if (done < middle) return head + done;
+
+    const Py_ssize_t tail = length - head - middle;
+    return head + middle + filewriter_write_at(writer->handle, source + middle, tail, offset + head + middle, error_code);
+}
+#endif
+
+/*
+ * Count a write of length bytes at offset into the writeback windows, and push out any
+ * it completed. Called while counted in users, so the descriptor is good.
+ *
+ * Writeback on a completed window is started without waiting. What was started the
+ * previous time round has had at least one more window's worth of writes to get to
+ * disk, so waiting for it rarely waits, and once it is on disk it can be dropped from
+ * the cache. A window written twice over - an article fetched again - is counted
+ * complete early, which only starts its writeback early. Errors are ignored: this is
+ * advice, and a failed write shows up at close or fsync regardless.
+ */
+static void filewriter_writeback_locked(FileWriter *writer, long long offset, Py_ssize_t length) {
+#ifdef SYNC_FILE_RANGE_WRITE
+    const long long window = writer->writeback;
+    if (!window || length <= 0) return;
+    const long long end = offset + length;
+
+    std::vector<long long> complete;
+    std::vector<long long> drop;
+    {
+        std::lock_guard<std::mutex> guard(writer->writeback_lock);
+        for (long long number = offset / window; number * window < end; number++) {
+            const long long covered = std::min(end, (number + 1) * window) - std::max(offset, number * window);
+            long long &filled = writer->writeback_filled[number];
+            filled += covered;
+            if (filled >= window) {
+                writer->writeback_filled.erase(number);
+                complete.push_back(number);
+            }
+        }
+        if (complete.empty()) return;
+        drop.swap(writer->writeback_started);
+        writer->writeback_started = complete;
+    }
+
+    for (long long number : drop) {
+        sync_file_range(writer->handle, number * window, window,
+                        SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+        posix_fadvise(writer->handle, number * window, window, POSIX_FADV_DONTNEED);
+    }
+    for (long long number : complete) {
+        sync_file_range(writer->handle, number * window, window, SYNC_FILE_RANGE_WRITE);
+    }
+#else
+    (void)writer;
+    (void)offset;
+    (void)length;
+#endif
+}
+
+void filewriter_written(FileWriter *writer, long long offset, Py_ssize_t length) {
+    if (!writer->writeback) return;
+    FileWriterUse use(writer);
+    if (use) filewriter_writeback_locked(writer, offset, length);
+}
+
+/*
+ * Write the whole buffer at an absolute offset.
+ *
+ * The GIL is dropped for the duration, so nothing here may touch the Python API; the
+ * buffer is pinned by the caller beforehand and any failure is carried out as an
+ * error number and raised once the GIL is back.
+ */
+Py_ssize_t filewriter_write_raw(FileWriter *writer, const char *buffer, Py_ssize_t length, long long offset,
+                                bool *was_closed, unsigned long *error_code) {
+    *was_closed = false;
+    *error_code = 0;
+
+    // Concurrent writes are allowed and are the whole point. Counted in, the handle
+    // cannot be pulled away mid-write.
+    FileWriterUse use(writer);
+    if (!use) {
+        *was_closed = true;
+        return 0;
+    }
+
+    Py_ssize_t written;
+#ifdef O_DIRECT
+    if (writer->direct_handle != SABCTOOLS_INVALID_HANDLE)
+        written = filewriter_write_direct(writer, buffer, length, offset, error_code);
+    else
+#endif
+        written = filewriter_write_at(writer->handle, buffer, length, offset, error_code);
+    filewriter_writeback_locked(writer, offset, written);
+    return written;
+}
+
+bool filewriter_submit(FileWriter *writer, UringWrite *op, const char *buffer, Py_ssize_t length, long long offset) {
+#if defined(_WIN32) || defined(__CYGWIN__)
+    return false;
+#else
+    // Direct writes are split three ways and bounce through aligned memory, which the
+    // ring does not do
+    if (!writer->uring || writer->direct) return false;
+
+    FileWriterUse use(writer);
+    if (!use) return false;
+    // Counted in queued before it leaves users, so close() cannot miss it
+    op->pending = &writer->queued;
+    return uring_submit_write(op, writer->handle, buffer, (size_t)length, offset);
+#endif
+}
+
 void filewriter_raise(FileWriter *writer, bool was_closed, unsigned long error_code) {
     if (was_closed) {
         PyErr_SetString(PyExc_ValueError, "write on closed FileWriter");
@@ -256,6 +523,176 @@ static PyObject *FileWriter_write(FileWriter *self, PyObject *args) {
     return PyLong_FromSsize_t(written_total);
 }
 
+/* One item of write_many, in the order the batch is written */
+typedef struct {
+    const char *data;
+    Py_ssize_t length;
+    long long offset;
+    Py_ssize_t index; // position in the caller's list
+} FileWriterItem;
+
+#ifdef SABCTOOLS_HAVE_PWRITEV
+/*
+ * Write iovecs back to back from offset, retrying short writes from where they stopped.
+ * The array is consumed in the process. Returns the bytes written, short only when
+ * *error_code is set.
+ */
+static Py_ssize_t filewriter_write_vector(FileHandle handle, struct iovec *iov, int count, long long offset,
+                                          unsigned long *error_code) {
+    Py_ssize_t written_total = 0;
+    while (count > 0) {
+        ssize_t written = pwritev(handle, iov, count, (off_t)(offset + written_total));
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            *error_code = (unsigned long)errno;
+            break;
+        }
+        if (written == 0) {
+            *error_code = (unsigned long)ENOSPC;
+            break;
+        }
+        written_total += (Py_ssize_t)written;
+        while (count > 0 && (size_t)written >= iov->iov_len) {
+            written -= (ssize_t)iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0) {
+            iov->iov_base = (char *)iov->iov_base + written;
+            iov->iov_len -= (size_t)written;
+        }
+    }
+    return written_total;
+}
+#endif
+
+/*
+ * Write a batch sorted by offset, setting ok[index] for each item that landed whole.
+ *
+ * Items that continue exactly where the previous one ended are merged into one pwritev,
+ * up to IOV_MAX buffers and FILEWRITER_MAX_CHUNK bytes, so an article cache flushing a
+ * burst of consecutive articles makes a handful of syscalls instead of one per article.
+ * A failure costs the items of its run, not the batch. Direct mode and platforms
+ * without pwritev write item by item, still counted in once and under one GIL release.
+ */
+static bool filewriter_write_batch(FileWriter *writer, std::vector<FileWriterItem> &items, std::vector<char> &ok) {
+    FileWriterUse use(writer);
+    if (!use) return false;
+
+    const size_t count = items.size();
+    size_t first = 0;
+    while (first < count) {
+        unsigned long error_code = 0;
+        const long long offset = items[first].offset;
+
+#ifdef SABCTOOLS_HAVE_PWRITEV
+        if (!writer->direct) {
+            struct iovec iov[IOV_MAX];
+            int used = 0;
+            Py_ssize_t length = 0;
+            size_t last = first;
+            for (; last < count && used < IOV_MAX; last++) {
+                const FileWriterItem &item = items[last];
+                if (item.offset != offset + length) break;
+                if (used && length + item.length > FILEWRITER_MAX_CHUNK) break;
+                iov[used].iov_base = const_cast<char *>(item.data);
+                iov[used].iov_len = (size_t)item.length;
+                used++;
+                length += item.length;
+            }
+
+            Py_ssize_t written;
+            if (used == 1) {
+                // Possibly larger than one pwritev may take, and no cheaper as a vector
+                written = filewriter_write_at(writer->handle, items[first].data, length, offset, &error_code);
+            } else {
+                written = filewriter_write_vector(writer->handle, iov, used, offset, &error_code);
+            }
+            for (size_t i = first; i < last; i++) {
+                ok[items[i].index] = items[i].offset + items[i].length <= offset + written;
+            }
+            filewriter_writeback_locked(writer, offset, written);
+            first = last;
+            continue;
+        }
+#endif
+        const FileWriterItem &item = items[first];
+        Py_ssize_t written;
+#ifdef O_DIRECT
+        if (writer->direct_handle != SABCTOOLS_INVALID_HANDLE)
+            written = filewriter_write_direct(writer, item.data, item.length, offset, &error_code);
+        else
+#endif
+            written = filewriter_write_at(writer->handle, item.data, item.length, offset, &error_code);
+        ok[item.index] = written == item.length;
+        filewriter_writeback_locked(writer, offset, written);
+        first++;
+    }
+    return true;
+}
+
+/*
+ * write_many([(data, offset), ...]) -> list of bool
+ *
+ * Every buffer is exported first, the batch is written under one release of the GIL,
+ * and each item reports whether it was written whole. A failed item can be retried
+ * with write() to see the error.
+ */
+static PyObject *FileWriter_write_many(FileWriter *self, PyObject *arg) {
+    PyObject *sequence = PySequence_Fast(arg, "write_many() expects an iterable of (data, offset) pairs");
+    if (!sequence) return NULL;
+
+    const Py_ssize_t count = PySequence_Fast_GET_SIZE(sequence);
+    std::vector<Py_buffer> views(count);
+    std::vector<FileWriterItem> items(count);
+    std::vector<char> ok(count, 0);
+    PyObject *result = NULL;
+    bool open = false;
+
+    Py_ssize_t exported = 0;
+    for (; exported < count; exported++) {
+        PyObject *pair = PySequence_Fast_GET_ITEM(sequence, exported);
+        long long offset;
+        if (!PyTuple_Check(pair)) {
+            PyErr_SetString(PyExc_TypeError, "write_many() items must be (data, offset) tuples");
+            goto done;
+        }
+        if (!PyArg_ParseTuple(pair, "y*L:write_many", &views[exported], &offset)) goto done;
+        if (offset < 0) {
+            PyBuffer_Release(&views[exported]);
+            PyErr_SetString(PyExc_ValueError, "offset must not be negative");
+            goto done;
+        }
+        items[exported] = {(const char *)views[exported].buf, views[exported].len, offset, exported};
+    }
+
+    // Stable, so items at the same offset are written in the order given
+    std::stable_sort(items.begin(), items.end(),
+                     [](const FileWriterItem &a, const FileWriterItem &b) { return a.offset < b.offset; });
+
+    Py_BEGIN_ALLOW_THREADS
+    open = filewriter_write_batch(self, items, ok);
+    Py_END_ALLOW_THREADS
+
+    if (!open) {
+        PyErr_SetString(PyExc_ValueError, "write on closed FileWriter");
+        goto done;
+    }
+
+    result = PyList_New(count);
+    if (!result) goto done;
+    for (Py_ssize_t i = 0; i < count; i++) {
+        PyObject *flag = ok[i] ? Py_True : Py_False;
+        Py_INCREF(flag);
+        PyList_SET_ITEM(result, i, flag);
+    }
+
+done:
+    for (Py_ssize_t i = 0; i < exported; i++) PyBuffer_Release(&views[i]);
+    Py_DECREF(sequence);
+    return result;
+}
+
 /*
  * Set the file length, marking it sparse first where the filesystem needs telling.
  *
@@ -283,9 +720,9 @@ static PyObject *FileWriter_preallocate(FileWriter *self, PyObject *arg) {
 
     Py_BEGIN_ALLOW_THREADS
     {
-        std::shared_lock<std::shared_mutex> guard(self->lock);
+        FileWriterUse use(self);
 
-        if (self->handle == SABCTOOLS_INVALID_HANDLE) {
+        if (!use) {
             was_closed = true;
         } else {
 #if defined(_WIN32) || defined(__CYGWIN__)
@@ -327,16 +764,25 @@ static PyObject *FileWriter_preallocate(FileWriter *self, PyObject *arg) {
 /*
  * Close the file. Idempotent, so it is safe from a finally block or twice over.
  *
- * The GIL is dropped before the exclusive lock is taken. Not for deadlock reasons -
- * a writer releases the shared lock before it reaches for the GIL again, so holding
- * the GIL here would still make progress - but because waiting for a multi-megabyte
- * write to drain while holding the GIL would stall every other Python thread in the
- * process for the duration.
+ * The GIL is dropped before waiting for writes to drain. Not for deadlock reasons -
+ * a writer leaves users before it reaches for the GIL again, so holding the GIL here
+ * would still make progress - but because waiting for a multi-megabyte write to drain
+ * while holding the GIL would stall every other Python thread in the process for the
+ * duration.
  */
 static PyObject *FileWriter_close(FileWriter *self, PyObject *Py_UNUSED(ignored)) {
     Py_BEGIN_ALLOW_THREADS
     {
-        std::unique_lock<std::shared_mutex> guard(self->lock);
+        // From here nothing new gets in; then wait out what already has
+        self->users.fetch_or(FILEWRITER_CLOSING, std::memory_order_acq_rel);
+        std::unique_lock<std::mutex> guard(self->close_lock);
+        self->drained.wait(guard, [self] {
+            return (self->users.load(std::memory_order_acquire) & ~FILEWRITER_CLOSING) == 0;
+        });
+        // Writes submitted to io_uring are not counted in users while they run, so wait
+        // for those separately. The kernel holds its own reference to the file, but close() is
+        // promised to return with the data handed over.
+        if (self->uring) uring_drain(&self->queued);
         filewriter_close_handle(self);
     }
     Py_END_ALLOW_THREADS
@@ -362,15 +808,12 @@ static PyObject *FileWriter_exit(FileWriter *self, PyObject *Py_UNUSED(args)) {
  * Taken from the handle this object owns rather than from the path, so it cannot
  * disagree with the file actually being written. Callers use it to tell an existing
  * file from one they have just created, which decides whether to preallocate.
- */
-/*
- * Read the handle under the same shared lock the writes take.
  *
- * close() mutates the handle under the exclusive lock with the GIL released, so
- * holding the GIL is not enough to be safe here: an unlocked read races it. For size
- * that matters in practice and not only formally, because the descriptor could be
- * closed - and reused by an unrelated file - between the check and the call below,
- * which is the failure this class owns its descriptor to rule out.
+ * The handle is read counted in users, the same as the writes. close() mutates it with
+ * the GIL released, so holding the GIL is not enough to be safe here: an uncounted read
+ * races it. For size that matters in practice and not only formally, because the
+ * descriptor could be closed - and reused by an unrelated file - between the check and
+ * the call below, which is the failure this class owns its descriptor to rule out.
  */
 static PyObject *FileWriter_get_size(FileWriter *self, void *Py_UNUSED(closure)) {
     bool was_closed = false;
@@ -379,9 +822,9 @@ static PyObject *FileWriter_get_size(FileWriter *self, void *Py_UNUSED(closure))
 
     Py_BEGIN_ALLOW_THREADS
     {
-        std::shared_lock<std::shared_mutex> guard(self->lock);
+        FileWriterUse use(self);
 
-        if (self->handle == SABCTOOLS_INVALID_HANDLE) {
+        if (!use) {
             was_closed = true;
         } else {
 #if defined(_WIN32) || defined(__CYGWIN__)
@@ -414,15 +857,15 @@ static PyObject *FileWriter_get_size(FileWriter *self, void *Py_UNUSED(closure))
     return PyLong_FromLongLong(size);
 }
 
+/* Closed once close() has begun, or never opened. Counting in never waits, so the GIL
+   can stay held. */
+static bool filewriter_is_closed(FileWriter *self) {
+    FileWriterUse use(self);
+    return !use;
+}
+
 static PyObject *FileWriter_get_closed(FileWriter *self, void *Py_UNUSED(closure)) {
-    bool closed;
-    Py_BEGIN_ALLOW_THREADS
-    {
-        std::shared_lock<std::shared_mutex> guard(self->lock);
-        closed = self->handle == SABCTOOLS_INVALID_HANDLE;
-    }
-    Py_END_ALLOW_THREADS
-    return PyBool_FromLong(closed);
+    return PyBool_FromLong(filewriter_is_closed(self));
 }
 
 /* No lock: path is set once during __init__ and only cleared in dealloc, by which
@@ -433,14 +876,20 @@ static PyObject *FileWriter_get_path(FileWriter *self, void *Py_UNUSED(closure))
     return self->path;
 }
 
+static PyObject *FileWriter_get_io_uring(FileWriter *self, void *Py_UNUSED(closure)) {
+    return PyBool_FromLong(self->uring);
+}
+
+static PyObject *FileWriter_get_direct(FileWriter *self, void *Py_UNUSED(closure)) {
+    return PyBool_FromLong(self->direct);
+}
+
+static PyObject *FileWriter_get_writeback(FileWriter *self, void *Py_UNUSED(closure)) {
+    return PyLong_FromLongLong(self->writeback);
+}
+
 static PyObject *FileWriter_repr(FileWriter *self) {
-    bool closed;
-    Py_BEGIN_ALLOW_THREADS
-    {
-        std::shared_lock<std::shared_mutex> guard(self->lock);
-        closed = self->handle == SABCTOOLS_INVALID_HANDLE;
-    }
-    Py_END_ALLOW_THREADS
+    const bool closed = filewriter_is_closed(self);
     return PyUnicode_FromFormat("<sabctools.FileWriter path=%R closed=%s>", self->path ? self->path : Py_None,
                                 closed ? "True" : "False");
 }
@@ -448,6 +897,9 @@ static PyObject *FileWriter_repr(FileWriter *self) {
 static PyMethodDef FileWriter_methods[] = {
     {"write", (PyCFunction)FileWriter_write, METH_VARARGS,
      PyDoc_STR("write(data, offset) -> int\n\nWrite all of data at an absolute offset, returning the bytes written.")},
+    {"write_many", (PyCFunction)FileWriter_write_many, METH_O,
+     PyDoc_STR("write_many(items) -> list\n\nWrite (data, offset) pairs under one release of the GIL, merging\n"
+               "adjacent ones into vectored writes. Returns whether each item was written whole.")},
     {"preallocate", (PyCFunction)FileWriter_preallocate, METH_O,
      PyDoc_STR("preallocate(length)\n\nSet the file length, marking it sparse first where required.")},
     {"close", (PyCFunction)FileWriter_close, METH_NOARGS,
@@ -460,6 +912,11 @@ static PyMethodDef FileWriter_methods[] = {
 static PyGetSetDef FileWriter_getset[] = {
     {"closed", (getter)FileWriter_get_closed, NULL, PyDoc_STR("Has the file been closed"), NULL},
     {"path", (getter)FileWriter_get_path, NULL, PyDoc_STR("Path the file was opened with"), NULL},
+    {"direct", (getter)FileWriter_get_direct, NULL, PyDoc_STR("Do writes bypass the page cache"), NULL},
+    {"io_uring", (getter)FileWriter_get_io_uring, NULL,
+     PyDoc_STR("Are streamed writes submitted through io_uring"), NULL},
+    {"writeback", (getter)FileWriter_get_writeback, NULL,
+     PyDoc_STR("Bytes per writeback window, 0 when writeback is left to the kernel"), NULL},
     {"size", (getter)FileWriter_get_size, NULL, PyDoc_STR("Current length of the file in bytes"), NULL},
     {NULL, NULL, NULL, NULL, NULL}
 };
@@ -485,7 +942,7 @@ PyTypeObject FileWriterType = {
     nullptr,                                // tp_setattro
     nullptr,                                // tp_as_buffer
     Py_TPFLAGS_DEFAULT,                     // tp_flags
-    PyDoc_STR("FileWriter(path)"),          // tp_doc
+    PyDoc_STR("FileWriter(path, io_uring=False, direct=False, writeback=0)"), // tp_doc
     nullptr,                                // tp_traverse
     nullptr,                                // tp_clear
     nullptr,                                // tp_richcompare
@@ -20,12 +20,18 @@
 #define SABCTOOLS_FILEWRITER_H
 
 #include <Python.h>
-// shared_mutex and shared_lock come from <shared_mutex>, unique_lock from <mutex>, and
-// placement new from <new>. libc++ happens to pull the latter two in transitively;
-// libstdc++ does not, so all three are named rather than relied on.
+// condition_variable comes from <condition_variable>, mutex and unique_lock from <mutex>,
+// and placement new from <new>. libc++ happens to pull some of these in transitively;
+// libstdc++ does not, so all are named rather than relied on.
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
 #include <mutex>
 #include <new>
-#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "uring.h"
 
 #if defined(_WIN32) || defined(__CYGWIN__)
 #ifndef WIN32_LEAN_AND_MEAN
@@ -54,23 +60,69 @@ typedef int FileHandle;
  * mode that matters here: a stale descriptor does not error, it writes an article
  * into whatever file now holds that number.
  *
- * Concurrency: writes take the lock in shared mode and run at the same time as one
- * another, which is what both platforms allow. pwrite() carries its own offset and
- * touches no shared file position. WriteFile() with an OVERLAPPED offset is
- * positional too, even on a handle that was not opened for overlapped I/O; it
- * disturbs the file pointer, but not the data. Only close() takes the lock
- * exclusively, so it waits for writes to drain rather than pulling the handle out
- * from under them.
+ * Concurrency: writes run at the same time as one another, which is what both
+ * platforms allow. pwrite() carries its own offset and touches no shared file
+ * position. WriteFile() with an OVERLAPPED offset is positional too, even on a handle
+ * that was not opened for overlapped I/O; it disturbs the file pointer, but not the
+ * data. What has to be kept apart is the handle and close(): every operation counts
+ * itself into users for as long as it needs the handle, and close() sets the closing
+ * bit, after which nothing new gets in, then waits for the count to drain rather than
+ * pulling the handle out from under them.
+ *
+ * That is one atomic add and one subtract per operation. A shared_mutex would do the
+ * same job, but its lock word takes a compare-and-swap loop on both sides plus the
+ * pthread call around it, on the one cacheline every connection streaming into a big
+ * file shares. Only close() sleeps, on a condition variable the last one out wakes.
+ *
+ * With io_uring, streamed writes are submitted while counted in users and complete
+ * after they leave. queued counts those, and close() waits for it to reach zero as
+ * well before the handle goes.
+ *
+ * In direct mode the block-aligned middle of each write goes through a second
+ * descriptor opened with O_DIRECT, so downloads stop filling the page cache with data
+ * nobody reads for minutes. The unaligned head and tail go through the ordinary one.
+ *
+ * With a writeback window (Linux), each window that has been written in full has its
+ * writeback started, and the windows started the time before are waited for and dropped
+ * from the cache. Completion is counted per window rather than taken from the furthest
+ * write, so the order articles arrive in does not matter: a last part or a par2 block
+ * written first only fills its own window. Dirty data stays bounded at the windows
+ * still being filled, plus one round of writeback, instead of piling up until the
+ * kernel flushes it all at once. Windows that are never filled - holes left by missing
+ * articles, or the partial one at the end of the file - are left to the kernel.
  */
 typedef struct {
     PyObject_HEAD
 
     FileHandle handle;
+    // O_DIRECT descriptor on the same file in direct mode on Linux, else invalid
+    FileHandle direct_handle;
     PyObject *path;
-    // Guards handle against close(), not the writes against each other
-    std::shared_mutex lock;
+    // Operations using the handle, plus FILEWRITER_CLOSING once close() has begun. Guards
+    // the handle against close(), not the writes against each other.
+    std::atomic<uint32_t> users;
+    // close() waits on drained, under close_lock, for users to reach zero
+    std::mutex close_lock;
+    std::condition_variable drained;
+    // Streamed writes go through the process-wide io_uring (Linux only)
+    bool uring;
+    // Writes bypass the page cache: O_DIRECT on Linux, F_NOCACHE on macOS
+    bool direct;
+    // Bytes per writeback window, 0 when off
+    long long writeback;
+    // Bytes written so far into each window not yet complete, by window number
+    std::unordered_map<long long, long long> writeback_filled;
+    // Windows whose writeback was started, to be waited for and dropped next time round
+    std::vector<long long> writeback_started;
+    // Guards the two above; held only to account, never across a sync
+    std::mutex writeback_lock;
+    // Writes submitted to the ring whose completions have not been reaped
+    std::atomic<long> queued;
 } FileWriter;
 
+/* Set in FileWriter.users once close() has begun; the bits below count operations */
+#define FILEWRITER_CLOSING ((uint32_t)1 << 31)
+
 bool filewriter_init(PyObject *);
 
 extern PyTypeObject FileWriterType;
@@ -87,6 +139,23 @@ extern PyTypeObject FileWriterType;
 Py_ssize_t filewriter_write_raw(FileWriter *writer, const char *buffer, Py_ssize_t length, long long offset,
                                 bool *was_closed, unsigned long *error_code);
 
+/*
+ * Submit a write through io_uring and return without waiting for it, for the decoder
+ * to overlap the write with decoding the next piece. The buffer has to stay untouched
+ * until uring_wait(op) returns, and a short write is the caller's to finish.
+ *
+ * False when the writer does not use the ring, writes direct, is closed or the ring
+ * is full: write it with filewriter_write_raw instead, which also reports the closed file. Safe to
+ * call with the GIL released.
+ */
+bool filewriter_submit(FileWriter *writer, UringWrite *op, const char *buffer, Py_ssize_t length, long long offset);
+
+/*
+ * Note that a write submitted with filewriter_submit has completed, for the writeback
+ * windows. filewriter_write_raw does this itself. Safe without the GIL.
+ */
+void filewriter_written(FileWriter *writer, long long offset, Py_ssize_t length);
+
 /* Raise the error reported by filewriter_write_raw. Requires the GIL. */
 void filewriter_raise(FileWriter *writer, bool was_closed, unsigned long error_code);
 
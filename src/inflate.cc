@@ -0,0 +1,83 @@
+/*
+ * Copyright 2007-2026 The SABnzbd-Team (sabnzbd.org)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "inflate.h"
+
+#include <cstring>
+
+static PyObject *zlib_decompress = NULL;
+static PyObject *zlib_decompressobj = NULL;
+
+bool inflate_init() {
+    PyObject *zlib_module = PyImport_ImportModule("zlib");
+    if (!zlib_module) return false;
+
+    zlib_decompress = PyObject_GetAttrString(zlib_module, "decompress");
+    zlib_decompressobj = PyObject_GetAttrString(zlib_module, "decompressobj");
+    Py_DECREF(zlib_module);
+    return zlib_decompress != NULL && zlib_decompressobj != NULL;
+}
+
+/*
+ * A zlib header is CMF FLG: deflate as the method in the low nibble of CMF, and the
+ * pair divisible by 31. Bare deflate can satisfy that by chance, but only when its
+ * first block happens to start with exactly those bits, which a real XZVER stream has
+ * never been seen to do.
+ */
+static bool has_zlib_header(const unsigned char *data, Py_ssize_t length) {
+    if (length < 2) return false;
+    return (data[0] & 0x0f) == 8 && ((data[0] << 8) | data[1]) % 31 == 0;
+}
+
+PyObject *inflate_block(const char *data, Py_ssize_t length) {
+    const int wbits = has_zlib_header(reinterpret_cast<const unsigned char *>(data), length)
+        ? INFLATE_WBITS_ZLIB : INFLATE_WBITS_RAW;
+
+    PyObject *view = PyMemoryView_FromMemory(const_cast<char *>(data), length, PyBUF_READ);
+    if (!view) return NULL;
+
+    PyObject *result = PyObject_CallFunction(zlib_decompress, "Oi", view, wbits);
+    Py_DECREF(view);
+    return result;
+}
+
+PyObject *inflate_stream_new(int wbits) {
+    return PyObject_CallFunction(zlib_decompressobj, "i", wbits);
+}
+
+bool inflate_stream(PyObject *stream, const char *in, Py_ssize_t in_length, char *out, Py_ssize_t out_length,
+                    Py_ssize_t &in_used, Py_ssize_t &out_written) {
+    PyObject *view = PyMemoryView_FromMemory(const_cast<char *>(in), in_length, PyBUF_READ);
+    if (!view) return false;
+
+    PyObject *result = PyObject_CallMethod(stream, "decompress", "On", view, out_length);
+    Py_DECREF(view);
+    if (!result) return false;
+
+    // max_length holds back input rather than output, so what did not fit comes back
+    // as unconsumed_tail and the output can be copied without checking its size
+    out_written = PyBytes_GET_SIZE(result);
+    memcpy(out, PyBytes_AS_STRING(result), out_written);
+    Py_DECREF(result);
+
+    PyObject *tail = PyObject_GetAttrString(stream, "unconsumed_tail");
+    if (!tail) return false;
+    in_used = in_length - PyBytes_GET_SIZE(tail);
+    Py_DECREF(tail);
+    return true;
+}
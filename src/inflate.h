@@ -0,0 +1,65 @@
+/*
+ * Copyright 2007-2026 The SABnzbd-Team (sabnzbd.org)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef SABCTOOLS_INFLATE_H
+#define SABCTOOLS_INFLATE_H
+
+#include <Python.h>
+
+/*
+ * Inflate through the zlib that Python itself ships.
+ *
+ * Linking zlib ourselves would mean finding it at build time on every platform, and on
+ * Windows CPython has it compiled into the interpreter with nothing exported, so there
+ * is no library to dlopen the way unlocked_ssl.cc does for OpenSSL. The zlib module is
+ * always there, and it drops the GIL around inflate() itself.
+ */
+
+/* Window bits for a zlib stream (RFC 1950), and for bare deflate (RFC 1951) */
+#define INFLATE_WBITS_ZLIB 15
+#define INFLATE_WBITS_RAW (-15)
+
+bool inflate_init();
+
+/*
+ * Inflate a complete compressed block in one go, as XZVER delivers it.
+ *
+ * Servers disagree on whether the deflate data carries a zlib header, so it is sniffed
+ * from the first two bytes rather than assumed. Returns a new bytes object, or NULL
+ * with an exception set.
+ */
+PyObject *inflate_block(const char *data, Py_ssize_t length);
+
+/*
+ * A streaming inflater whose state outlives any one call, as COMPRESS DEFLATE (RFC
+ * 8054) needs: the whole rest of the connection is one deflate stream, and its window
+ * carries across every read. A zlib.decompressobj, new reference or NULL.
+ */
+PyObject *inflate_stream_new(int wbits);
+
+/*
+ * Inflate from in into out, producing no more than out_length bytes.
+ *
+ * in_used is how much of the input zlib took; the rest did not fit and has to be
+ * offered again. Output short of out_length means everything zlib could produce from
+ * this input has been produced. False with an exception set on corrupt data.
+ */
+bool inflate_stream(PyObject *stream, const char *in, Py_ssize_t in_length, char *out, Py_ssize_t out_length,
+                    Py_ssize_t &in_used, Py_ssize_t &out_written);
+
+#endif // SABCTOOLS_INFLATE_H
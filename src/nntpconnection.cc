@@ -0,0 +1,778 @@
+/*
+ * Copyright 2007-2026 The SABnzbd-Team (sabnzbd.org)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "nntpconnection.h"
+#include "unlocked_ssl.h"
+
+#if !defined(_WIN32) && !defined(__CYGWIN__)
+#include <errno.h>
+#include <sys/socket.h>
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+/*
+ * Context of the requests the connection makes for itself: the greeting and the login.
+ * Its responses go through the same Decoder as the caller's, so they cannot be paired
+ * out of order, and are recognised by this object and never returned.
+ */
+static PyObject* ProtocolContext = NULL;
+
+static const char* state_names[] = {"greeting", "authenticating", "authenticating", "ready", "closed"};
+
+/* Plain sockets are read and written here, with the GIL released */
+static Py_ssize_t NNTPConnection_recv(NNTPConnection *self, char *buf, Py_ssize_t len)
+{
+    if (self->sslobj) return unlocked_ssl_recv_raw(self->sslobj, buf, len);
+
+    for (;;) {
+        Py_ssize_t received;
+#if defined(_WIN32) || defined(__CYGWIN__)
+        int error;
+        Py_BEGIN_ALLOW_THREADS;
+        received = recv(static_cast<SOCKET>(self->fd), buf, static_cast<int>(std::min<Py_ssize_t>(len, INT_MAX)), 0);
+        error = received < 0 ? WSAGetLastError() : 0;
+        Py_END_ALLOW_THREADS;
+        if (received >= 0) return received;
+        if (error == WSAEWOULDBLOCK) return UNLOCKED_SSL_WOULD_BLOCK;
+        PyErr_SetExcFromWindowsErr(PyExc_OSError, error);
+        return -1;
+#else
+        int error;
+        Py_BEGIN_ALLOW_THREADS;
+        received = recv(static_cast<int>(self->fd), buf, len, 0);
+        error = errno;
+        Py_END_ALLOW_THREADS;
+        if (received >= 0) return received;
+        if (error == EAGAIN || error == EWOULDBLOCK) return UNLOCKED_SSL_WOULD_BLOCK;
+        if (error == EINTR) {
+            if (PyErr_CheckSignals()) return -1;
+            continue;
+        }
+        errno = error;
+        PyErr_SetFromErrno(PyExc_OSError);
+        return -1;
+#endif
+    }
+}
+
+static Py_ssize_t NNTPConnection_send(NNTPConnection *self, const char *buf, Py_ssize_t len)
+{
+    if (self->sslobj) return unlocked_ssl_send_raw(self->sslobj, buf, len);
+
+    for (;;) {
+        Py_ssize_t sent;
+#if defined(_WIN32) || defined(__CYGWIN__)
+        int error;
+        Py_BEGIN_ALLOW_THREADS;
+        sent = send(static_cast<SOCKET>(self->fd), buf, static_cast<int>(std::min<Py_ssize_t>(len, INT_MAX)), 0);
+        error = sent < 0 ? WSAGetLastError() : 0;
+        Py_END_ALLOW_THREADS;
+        if (sent >= 0) return sent;
+        if (error == WSAEWOULDBLOCK) return UNLOCKED_SSL_WOULD_BLOCK;
+        PyErr_SetExcFromWindowsErr(PyExc_OSError, error);
+        return -1;
+#else
+        int error;
+        Py_BEGIN_ALLOW_THREADS;
+        sent = send(static_cast<int>(self->fd), buf, len, MSG_NOSIGNAL);
+        error = errno;
+        Py_END_ALLOW_THREADS;
+        if (sent >= 0) return sent;
+        if (error == EAGAIN || error == EWOULDBLOCK) return UNLOCKED_SSL_WOULD_BLOCK;
+        if (error == EINTR) {
+            if (PyErr_CheckSignals()) return -1;
+            continue;
+        }
+        errno = error;
+        PyErr_SetFromErrno(PyExc_OSError);
+        return -1;
+#endif
+    }
+}
+
+/* Send as much of the pending commands as the socket takes. False with an exception set. */
+static bool NNTPConnection_flush(NNTPConnection *self)
+{
+    while (self->out_sent < self->outbuf.size()) {
+        const Py_ssize_t sent = NNTPConnection_send(self, self->outbuf.data() + self->out_sent,
+                                                    static_cast<Py_ssize_t>(self->outbuf.size() - self->out_sent));
+        if (sent == UNLOCKED_SSL_WOULD_BLOCK) return true;
+        if (sent < 0) return false;
+        self->out_sent += sent;
+        self->bytes_sent += sent;
+    }
+    self->outbuf.clear();
+    self->out_sent = 0;
+    return true;
+}
+
+/* A command of the connection's own, answered before any of the caller's */
+static void NNTPConnection_command(NNTPConnection *self, std::string_view line)
+{
+    self->outbuf.append(line);
+    self->outbuf.append("\r\n");
+    decoder_expect(self->decoder, ProtocolContext, NULL);
+}
+
+/* Move queued requests onto the wire until the pipeline is full */
+static void NNTPConnection_fill(NNTPConnection *self)
+{
+    if (self->state != NNTP_STATE_READY) return;
+    while (self->in_flight < self->pipeline && !self->queue.empty()) {
+        QueuedRequest &request = self->queue.front();
+        self->outbuf.append(request.command);
+        // References are transferred to the Decoder
+        decoder_expect(self->decoder, request.context, request.sink, request.offset);
+        Py_XDECREF(request.context);
+        Py_XDECREF(request.sink);
+        self->queue.pop_front();
+        self->in_flight++;
+    }
+}
+
+static void NNTPConnection_close(NNTPConnection *self)
+{
+    self->state = NNTP_STATE_CLOSED;
+    self->outbuf.clear();
+    self->out_sent = 0;
+}
+
+static PyObject* NNTPConnection_message(NNTPResponse *response)
+{
+    return response->message ? response->message : Py_None;
+}
+
+/*
+ * Act on the reply to one of the connection's own commands.
+ *
+ * Anything other than the expected codes ends the session: a server that refuses the
+ * greeting or the login will not answer a request either, and carrying on would only
+ * turn one clear error into a queue of failed articles.
+ */
+static bool NNTPConnection_protocol(NNTPConnection *self, NNTPResponse *response)
+{
+    const int code = response->status_code;
+    switch (self->state) {
+        case NNTP_STATE_GREETING:
+            if (code != 200 && code != 201) {
+                NNTPConnection_close(self);
+                PyErr_Format(PyExc_ConnectionRefusedError, "Server refused the connection: %d %S", code,
+                             NNTPConnection_message(response));
+                return false;
+            }
+            if (self->authenticate) {
+                std::string line = "AUTHINFO USER " + self->username;
+                NNTPConnection_command(self, line);
+                self->state = NNTP_STATE_AUTH_USER;
+            } else {
+                self->state = NNTP_STATE_READY;
+            }
+            return true;
+
+        case NNTP_STATE_AUTH_USER:
+            if (code == 281) {
+                self->state = NNTP_STATE_READY;
+                return true;
+            }
+            if (code == 381) {
+                std::string line = "AUTHINFO PASS " + self->password;
+                NNTPConnection_command(self, line);
+                self->state = NNTP_STATE_AUTH_PASS;
+                return true;
+            }
+            break;
+
+        case NNTP_STATE_AUTH_PASS:
+            if (code == 281) {
+                self->state = NNTP_STATE_READY;
+                return true;
+            }
+            break;
+
+        default:
+            break;
+    }
+    NNTPConnection_close(self);
+    PyErr_Format(PyExc_PermissionError, "Authentication failed: %d %S", code, NNTPConnection_message(response));
+    return false;
+}
+
+/* Hand the caller's finished responses to `responses`, and act on the connection's own */
+static bool NNTPConnection_collect(NNTPConnection *self, PyObject *responses)
+{
+    NNTPResponse *response;
+    while ((response = decoder_next(self->decoder))) {
+        bool ok;
+        if (response->context == ProtocolContext) {
+            ok = NNTPConnection_protocol(self, response);
+        } else {
+            self->in_flight--;
+            ok = PyList_Append(responses, reinterpret_cast<PyObject *>(response)) == 0;
+        }
+        Py_DECREF(response);
+        if (!ok) return false;
+    }
+    return true;
+}
+
+/* Hold the exception that is set, to be raised by the next call */
+static void NNTPConnection_defer_error(NNTPConnection *self)
+{
+#if PY_VERSION_HEX >= SABCTOOLS_PY_HEX(3, 12)
+    PyObject *error = PyErr_GetRaisedException();
+#else
+    PyObject *error_type = NULL, *error = NULL, *error_traceback = NULL;
+    PyErr_Fetch(&error_type, &error, &error_traceback);
+    PyErr_NormalizeException(&error_type, &error, &error_traceback);
+    if (error && error_traceback) PyException_SetTraceback(error, error_traceback);
+    Py_XDECREF(error_type);
+    Py_XDECREF(error_traceback);
+#endif
+    Py_XSETREF(self->deferred_error, error);
+}
+
+/* Raise what NNTPConnection_defer_error held back, if anything. False once raised. */
+static bool NNTPConnection_raise_deferred(NNTPConnection *self)
+{
+    PyObject *error = self->deferred_error;
+    if (!error) return true;
+    self->deferred_error = NULL;
+#if PY_VERSION_HEX >= SABCTOOLS_PY_HEX(3, 12)
+    PyErr_SetRaisedException(error);
+#else
+    PyErr_Restore(Py_NewRef(reinterpret_cast<PyObject *>(Py_TYPE(error))), error, PyException_GetTraceback(error));
+#endif
+    return false;
+}
+
+static bool NNTPConnection_check_open(NNTPConnection *self)
+{
+    if (self->state == NNTP_STATE_CLOSED) {
+        PyErr_SetString(PyExc_ValueError, "I/O operation on closed NNTPConnection");
+        return false;
+    }
+    return true;
+}
+
+static PyObject* NNTPConnection_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+{
+    static const char* kwlist[] = {"sock", "username", "password", "pipeline", "buffer_size", "command", nullptr};
+    PyObject *sock;
+    const char *username = NULL;
+    const char *password = NULL;
+    Py_ssize_t pipeline = 1;
+    Py_ssize_t buffer_size = YENC_STAGING_SIZE;
+    const char *command = "BODY";
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|zznns:NNTPConnection", const_cast<char **>(kwlist), &sock,
+                                     &username, &password, &pipeline, &buffer_size, &command)) {
+        return NULL;
+    }
+    if (pipeline < 1) {
+        PyErr_SetString(PyExc_ValueError, "pipeline must be at least 1");
+        return NULL;
+    }
+    if (strcmp(command, "BODY") != 0 && strcmp(command, "ARTICLE") != 0) {
+        PyErr_SetString(PyExc_ValueError, "command must be BODY or ARTICLE");
+        return NULL;
+    }
+    for (const char *credential : {username, password}) {
+        if (credential && strpbrk(credential, "\r\n")) {
+            PyErr_SetString(PyExc_ValueError, "credentials must not contain CR or LF");
+            return NULL;
+        }
+    }
+
+    PyObject *blocking = PyObject_CallMethod(sock, "getblocking", NULL);
+    if (!blocking) return NULL;
+    const int is_blocking = PyObject_IsTrue(blocking);
+    Py_DECREF(blocking);
+    if (is_blocking) {
+        if (is_blocking > 0) PyErr_SetString(PyExc_ValueError, "Only non-blocking sockets are supported");
+        return NULL;
+    }
+
+    PyObject *fileno = PyObject_CallMethod(sock, "fileno", NULL);
+    if (!fileno) return NULL;
+    const long long fd = PyLong_AsLongLong(fileno);
+    Py_DECREF(fileno);
+    if (fd == -1) {
+        if (!PyErr_Occurred()) PyErr_SetString(PyExc_ValueError, "socket is closed");
+        return NULL;
+    }
+
+    // Resolved here, once, so that reading and writing never call back into Python
+    PyObject *sslobj = NULL;
+    if (unlocked_ssl_is_ssl_socket(sock)) {
+        if (!openssl_linked()) {
+            PyErr_SetString(PyExc_OSError, "Failed to link with OpenSSL");
+            return NULL;
+        }
+        sslobj = unlocked_ssl_nonblocking_sslobj(sock);
+        if (!sslobj) return NULL;
+    }
+
+    PyObject *decoder = PyObject_CallFunction(reinterpret_cast<PyObject *>(&DecoderType), "n", buffer_size);
+    if (!decoder) {
+        Py_XDECREF(sslobj);
+        return NULL;
+    }
+
+    NNTPConnection *self = reinterpret_cast<NNTPConnection *>(type->tp_alloc(type, 0));
+    if (!self) {
+        Py_DECREF(decoder);
+        Py_XDECREF(sslobj);
+        return NULL;
+    }
+
+    new (&self->queue) std::deque<QueuedRequest>();
+    new (&self->outbuf) std::string();
+    new (&self->username) std::string(username ? username : "");
+    new (&self->password) std::string(password ? password : "");
+    new (&self->command) std::string(command);
+    self->sock = Py_NewRef(sock);
+    self->sslobj = sslobj;
+    self->deferred_error = NULL;
+    self->decoder = reinterpret_cast<Decoder *>(decoder);
+    self->out_sent = 0;
+    self->pipeline = pipeline;
+    self->in_flight = 0;
+    self->bytes_received = 0;
+    self->bytes_sent = 0;
+    self->fd = static_cast<Py_intptr_t>(fd);
+    self->state = NNTP_STATE_GREETING;
+    self->authenticate = username != NULL;
+
+    // The server speaks first
+    decoder_expect(self->decoder, ProtocolContext, NULL);
+    return reinterpret_cast<PyObject *>(self);
+}
+
+static void NNTPConnection_clear_queue(NNTPConnection *self)
+{
+    for (QueuedRequest &request : self->queue) {
+        Py_XDECREF(request.context);
+        Py_XDECREF(request.sink);
+    }
+    self->queue.clear();
+}
+
+/*
+ * Contexts are often job objects that hold on to the connection they were sent on, and
+ * the socket may carry attributes of the caller's, so both can close a cycle.
+ */
+static int NNTPConnection_traverse(NNTPConnection *self, visitproc visit, void *arg)
+{
+    Py_VISIT(self->sock);
+    Py_VISIT(self->sslobj);
+    Py_VISIT(self->deferred_error);
+    Py_VISIT(self->decoder);
+    for (QueuedRequest &request : self->queue) {
+        Py_VISIT(request.context);
+        Py_VISIT(request.sink);
+    }
+    return 0;
+}
+
+/* Leaves a closed connection, which every method but requeue() refuses */
+static int NNTPConnection_clear(NNTPConnection *self)
+{
+    NNTPConnection_close(self);
+    NNTPConnection_clear_queue(self);
+    self->in_flight = 0;
+    Py_CLEAR(self->decoder);
+    Py_CLEAR(self->sslobj);
+    Py_CLEAR(self->deferred_error);
+    Py_CLEAR(self->sock);
+    return 0;
+}
+
+static void NNTPConnection_dealloc(NNTPConnection *self)
+{
+    PyObject_GC_UnTrack(self);
+    NNTPConnection_clear_queue(self);
+    self->queue.~deque();
+    self->outbuf.~basic_string();
+    self->username.~basic_string();
+    self->password.~basic_string();
+    self->command.~basic_string();
+    Py_XDECREF(self->decoder);
+    Py_XDECREF(self->sslobj);
+    Py_XDECREF(self->deferred_error);
+    Py_XDECREF(self->sock);
+    Py_TYPE(self)->tp_free(reinterpret_cast<PyObject *>(self));
+}
+
+/* Queue a line of the caller's, to go out when the pipeline has room for it */
+static PyObject* NNTPConnection_queue(NNTPConnection *self, std::string line, PyObject *context, PyObject *sink,
+                                      Py_ssize_t offset = 0)
+{
+    if (!NNTPConnection_check_open(self)) return NULL;
+    if (!decoder_check_sink(sink)) return NULL;
+
+    QueuedRequest request;
+    request.command = std::move(line);
+    request.context = Py_NewRef(context);
+    request.sink = Py_XNewRef(sink);
+    request.offset = offset;
+    self->queue.push_back(std::move(request));
+
+    // Sent on the next on_writable(), which wants_write now asks for
+    NNTPConnection_fill(self);
+    Py_RETURN_NONE;
+}
+
+/*
+ * Ask for an article.
+ *
+ * Nothing goes out here: the command is built and queued, and written once the
+ * pipeline has room and the socket is writable. `context` comes back as
+ * NNTPResponse.context, and `sink` and `offset` say where to decode it to, as with
+ * Decoder.expect().
+ */
+static PyObject* NNTPConnection_submit(NNTPConnection *self, PyObject *args, PyObject *kwds)
+{
+    static const char* kwlist[] = {"message_id", "context", "sink", "offset", nullptr};
+    PyObject *item;
+    PyObject *context;
+    PyObject *sink = Py_None;
+    Py_ssize_t offset = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "OO|On:submit", const_cast<char **>(kwlist), &item, &context,
+                                     &sink, &offset)) {
+        return NULL;
+    }
+    if (!decoder_check_offset(offset)) return NULL;
+
+    std::string_view message_id;
+    if (!decoder_message_id(item, message_id)) return NULL;
+
+    std::string line = self->command;
+    line.append(" <");
+    line.append(message_id);
+    line.append(">\r\n");
+    return NNTPConnection_queue(self, std::move(line), context, Py_IsNone(sink) ? NULL : sink, offset);
+}
+
+/*
+ * Select a newsgroup.
+ *
+ * Queued behind earlier requests like any other, and answered with a 211 response
+ * whose message holds the article count and range.
+ */
+static PyObject* NNTPConnection_group(NNTPConnection *self, PyObject *args, PyObject *kwds)
+{
+    static const char* kwlist[] = {"name", "context", nullptr};
+    PyObject *item;
+    PyObject *context = Py_None;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|O:group", const_cast<char **>(kwlist), &item, &context)) {
+        return NULL;
+    }
+
+    std::string_view name;
+    if (!decoder_message_id(item, name)) return NULL;
+    if (name.empty() || name.find(' ') != std::string_view::npos) {
+        PyErr_SetString(PyExc_ValueError, "invalid newsgroup name");
+        return NULL;
+    }
+
+    std::string line = "GROUP ";
+    line.append(name);
+    line.append("\r\n");
+    return NNTPConnection_queue(self, std::move(line), context, NULL);
+}
+
+/*
+ * Read what the socket has, decode it and return the caller's finished responses.
+ *
+ * Call when the socket is readable. Reads until the socket runs dry, up to
+ * NNTP_MAX_READS times, then refills the pipeline and sends what it can. Responses
+ * decoded before the server hung up, or before any other error, are still returned:
+ * they are already out of the Decoder and off in_flight, so requeue() could not give
+ * them back either. The error is raised by the next call instead.
+ */
+static PyObject* NNTPConnection_on_readable(NNTPConnection *self, PyObject *Py_UNUSED(ignored))
+{
+    if (!NNTPConnection_raise_deferred(self)) return NULL;
+    if (!NNTPConnection_check_open(self)) return NULL;
+
+    PyObject *responses = PyList_New(0);
+    if (!responses) return NULL;
+
+    for (int reads = 0; reads < NNTP_MAX_READS; reads++) {
+        Py_ssize_t available;
+        char *space = decoder_free_space(self->decoder, available);
+        if (available <= 0) {
+            PyErr_SetString(PyExc_BufferError, "Decoder buffer is full");
+            goto error;
+        }
+
+        const Py_ssize_t received = NNTPConnection_recv(self, space, available);
+        if (received == UNLOCKED_SSL_WOULD_BLOCK) break;
+        if (received < 0) goto error;
+        if (received == 0) {
+            // Nothing can be sent to a server that has gone, but what it sent first
+            // is complete and the caller's
+            if (PyList_GET_SIZE(responses)) return responses;
+            NNTPConnection_close(self);
+            PyErr_SetString(PyExc_ConnectionResetError, "Connection closed by server");
+            goto error;
+        }
+
+        self->bytes_received += received;
+        if (!decoder_process(self->decoder, received)) goto error;
+        if (!NNTPConnection_collect(self, responses)) goto error;
+
+        // A short read drained the socket, and for TLS OpenSSL's buffer too: reading
+        // again would only find out it is empty
+        if (received < available) break;
+    }
+
+    NNTPConnection_fill(self);
+    if (!NNTPConnection_flush(self)) goto error;
+    return responses;
+
+error:
+    if (PyList_GET_SIZE(responses)) {
+        NNTPConnection_defer_error(self);
+        return responses;
+    }
+    Py_DECREF(responses);
+    return NULL;
+}
+
+/* Send queued commands. Call when the socket is writable and wants_write is set. */
+static PyObject* NNTPConnection_on_writable(NNTPConnection *self, PyObject *Py_UNUSED(ignored))
+{
+    if (!NNTPConnection_raise_deferred(self)) return NULL;
+    if (!NNTPConnection_check_open(self)) return NULL;
+    NNTPConnection_fill(self);
+    if (!NNTPConnection_flush(self)) return NULL;
+    Py_RETURN_NONE;
+}
+
+/*
+ * Take back every request this connection has not answered, and close it.
+ *
+ * For a connection that failed or is being dropped: returns the contexts of the
+ * requests in flight, oldest first, then of those still queued, so the caller can
+ * submit them to the next connection. Responses part-received are discarded along
+ * with the Decoder state, since their remaining bytes will never arrive.
+ */
+static PyObject* NNTPConnection_requeue(NNTPConnection *self, PyObject *Py_UNUSED(ignored))
+{
+    PyObject *contexts = PyList_New(0);
+    if (!contexts) return NULL;
+
+    auto add = [&](PyObject *context) {
+        if (context == ProtocolContext) return true;
+        return PyList_Append(contexts, context ? context : Py_None) == 0;
+    };
+
+    Decoder *decoder = self->decoder;
+    // Gone only after the garbage collector cleared this connection, with nothing left
+    if (!decoder) return contexts;
+    for (NNTPResponse *item : decoder->deque) {
+        if (!add(item->context)) goto error;
+    }
+    if (decoder->response && !add(decoder->response->context)) goto error;
+    for (PendingRequest &request : decoder->pending) {
+        if (!add(request.context)) goto error;
+    }
+    for (QueuedRequest &request : self->queue) {
+        if (!add(request.context)) goto error;
+    }
+
+    // A fresh Decoder rather than a reset one: nothing that was pending may be paired
+    // with whatever the socket still delivers
+    {
+        PyObject *fresh = PyObject_CallFunction(reinterpret_cast<PyObject *>(&DecoderType), "n", decoder->size);
+        if (!fresh) goto error;
+        Py_SETREF(self->decoder, reinterpret_cast<Decoder *>(fresh));
+    }
+    NNTPConnection_clear_queue(self);
+    self->in_flight = 0;
+    // The caller is moving on, and whatever failed is behind it
+    Py_CLEAR(self->deferred_error);
+    NNTPConnection_close(self);
+    return contexts;
+
+error:
+    Py_DECREF(contexts);
+    return NULL;
+}
+
+static PyObject* NNTPConnection_fileno(NNTPConnection *self, PyObject *Py_UNUSED(ignored))
+{
+    return PyLong_FromLongLong(static_cast<long long>(self->fd));
+}
+
+static PyObject* NNTPConnection_repr(NNTPConnection *self)
+{
+    return PyUnicode_FromFormat("<NNTPConnection fd=%zd state=%s queued=%zd in_flight=%zd>",
+                                static_cast<Py_ssize_t>(self->fd), state_names[self->state],
+                                static_cast<Py_ssize_t>(self->queue.size()), self->in_flight);
+}
+
+// Getters rather than members: offsetof is only conditionally supported on a type
+// that holds a std::deque
+static PyObject* NNTPConnection_get_state(NNTPConnection *self, void *Py_UNUSED(closure))
+{
+    return PyUnicode_FromString(state_names[self->state]);
+}
+
+static PyObject* NNTPConnection_get_wants_write(NNTPConnection *self, void *Py_UNUSED(closure))
+{
+    if (self->state == NNTP_STATE_CLOSED) Py_RETURN_FALSE;
+    const bool room = self->state == NNTP_STATE_READY && self->in_flight < self->pipeline && !self->queue.empty();
+    return PyBool_FromLong(self->out_sent < self->outbuf.size() || room);
+}
+
+static PyObject* NNTPConnection_get_queued(NNTPConnection *self, void *Py_UNUSED(closure))
+{
+    return PyLong_FromSsize_t(static_cast<Py_ssize_t>(self->queue.size()));
+}
+
+static PyObject* NNTPConnection_get_in_flight(NNTPConnection *self, void *Py_UNUSED(closure))
+{
+    return PyLong_FromSsize_t(self->in_flight);
+}
+
+static PyObject* NNTPConnection_get_pipeline(NNTPConnection *self, void *Py_UNUSED(closure))
+{
+    return PyLong_FromSsize_t(self->pipeline);
+}
+
+static int NNTPConnection_set_pipeline(NNTPConnection *self, PyObject *value, void *Py_UNUSED(closure))
+{
+    if (!value) {
+        PyErr_SetString(PyExc_AttributeError, "cannot delete pipeline");
+        return -1;
+    }
+    const Py_ssize_t pipeline = PyLong_AsSsize_t(value);
+    if (pipeline == -1 && PyErr_Occurred()) return -1;
+    if (pipeline < 1) {
+        PyErr_SetString(PyExc_ValueError, "pipeline must be at least 1");
+        return -1;
+    }
+    // A smaller window takes effect as the requests already sent are answered
+    self->pipeline = pipeline;
+    return 0;
+}
+
+static PyObject* NNTPConnection_get_bytes_received(NNTPConnection *self, void *Py_UNUSED(closure))
+{
+    return PyLong_FromSsize_t(self->bytes_received);
+}
+
+static PyObject* NNTPConnection_get_bytes_sent(NNTPConnection *self, void *Py_UNUSED(closure))
+{
+    return PyLong_FromSsize_t(self->bytes_sent);
+}
+
+static PyObject* NNTPConnection_get_sock(NNTPConnection *self, void *Py_UNUSED(closure))
+{
+    return Py_NewRef(self->sock ? self->sock : Py_None);
+}
+
+static PyGetSetDef NNTPConnection_getset[] = {
+    {"state", (getter)NNTPConnection_get_state, NULL,
+     PyDoc_STR("greeting, authenticating, ready or closed"), NULL},
+    {"wants_write", (getter)NNTPConnection_get_wants_write, NULL,
+     PyDoc_STR("Whether there are commands to send, so the socket should be watched for writing"), NULL},
+    {"queued", (getter)NNTPConnection_get_queued, NULL,
+     PyDoc_STR("Requests waiting for room in the pipeline"), NULL},
+    {"in_flight", (getter)NNTPConnection_get_in_flight, NULL,
+     PyDoc_STR("Requests sent whose responses have not been returned yet"), NULL},
+    {"pipeline", (getter)NNTPConnection_get_pipeline, (setter)NNTPConnection_set_pipeline,
+     PyDoc_STR("Most requests to keep in flight"), NULL},
+    {"bytes_received", (getter)NNTPConnection_get_bytes_received, NULL,
+     PyDoc_STR("Bytes read from the socket, before decompression or decoding"), NULL},
+    {"bytes_sent", (getter)NNTPConnection_get_bytes_sent, NULL,
+     PyDoc_STR("Bytes of commands written to the socket"), NULL},
+    {"sock", (getter)NNTPConnection_get_sock, NULL,
+     PyDoc_STR("The socket this connection runs on"), NULL},
+    {NULL}
+};
+
+static PyMethodDef NNTPConnection_methods[] = {
+    {"submit", (PyCFunction)(void(*)(void))NNTPConnection_submit, METH_VARARGS | METH_KEYWORDS,
+     PyDoc_STR("submit(message_id, context, sink=None, offset=0)\n\nQueue a request for an article.")},
+    {"group", (PyCFunction)(void(*)(void))NNTPConnection_group, METH_VARARGS | METH_KEYWORDS,
+     PyDoc_STR("group(name, context=None)\n\nQueue a GROUP command.")},
+    {"on_readable", (PyCFunction)NNTPConnection_on_readable, METH_NOARGS,
+     PyDoc_STR("on_readable()\n\nRead and decode; returns the finished responses.")},
+    {"on_writable", (PyCFunction)NNTPConnection_on_writable, METH_NOARGS,
+     PyDoc_STR("on_writable()\n\nSend queued commands.")},
+    {"requeue", (PyCFunction)NNTPConnection_requeue, METH_NOARGS,
+     PyDoc_STR("requeue()\n\nClose and return the contexts of every unanswered request.")},
+    {"fileno", (PyCFunction)NNTPConnection_fileno, METH_NOARGS,
+     PyDoc_STR("fileno()\n\nThe socket's file descriptor, for selectors.")},
+    {NULL}
+};
+
+PyTypeObject NNTPConnectionType = {
+    PyVarObject_HEAD_INIT(nullptr, 0)
+    "sabctools.NNTPConnection",             // tp_name
+    sizeof(NNTPConnection),                 // tp_basicsize
+    0,                                      // tp_itemsize
+    (destructor)NNTPConnection_dealloc,     // tp_dealloc
+    0,                                      // tp_vectorcall_offset
+    nullptr,                                // tp_getattr
+    nullptr,                                // tp_setattr
+    nullptr,                                // tp_as_async
+    (reprfunc)NNTPConnection_repr,          // tp_repr
+    nullptr,                                // tp_as_number
+    nullptr,                                // tp_as_sequence
+    nullptr,                                // tp_as_mapping
+    nullptr,                                // tp_hash
+    nullptr,                                // tp_call
+    nullptr,                                // tp_str
+    nullptr,                                // tp_getattro
+    nullptr,                                // tp_setattro
+    nullptr,                                // tp_as_buffer
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC, // tp_flags
+    PyDoc_STR("NNTPConnection(sock, username=None, password=None, pipeline=1, buffer_size=262144, command='BODY')"), // tp_doc
+    (traverseproc)NNTPConnection_traverse,  // tp_traverse
+    (inquiry)NNTPConnection_clear,          // tp_clear
+    nullptr,                                // tp_richcompare
+    0,                                      // tp_weaklistoffset
+    nullptr,                                // tp_iter
+    nullptr,                                // tp_iternext
+    NNTPConnection_methods,                 // tp_methods
+    nullptr,                                // tp_members
+    NNTPConnection_getset,                  // tp_getset
+    nullptr,                                // tp_base
+    nullptr,                                // tp_dict
+    nullptr,                                // tp_descr_get
+    nullptr,                                // tp_descr_set
+    0,                                      // tp_dictoffset
+    nullptr,                                // tp_init
+    PyType_GenericAlloc,                    // tp_alloc
+    NNTPConnection_new,                     // tp_new
+};
+
+bool nntpconnection_init(PyObject *m) {
+    ProtocolContext = PyObject_CallNoArgs(reinterpret_cast<PyObject *>(&PyBaseObject_Type));
+    if (!ProtocolContext) return false;
+    if (PyType_Ready(&NNTPConnectionType) < 0) return false;
+    if (PyModule_AddType(m, &NNTPConnectionType) < 0) return false;
+    return true;
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright 2007-2026 The SABnzbd-Team (sabnzbd.org)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef SABCTOOLS_NNTPCONNECTION_H
+#define SABCTOOLS_NNTPCONNECTION_H
+
+#include <Python.h>
+
+#include <deque>
+#include <string>
+
+#include "yenc.h"
+
+/* How far a connection has got in its session */
+enum NNTPConnectionState {
+    NNTP_STATE_GREETING,  // waiting for the 200/201
+    NNTP_STATE_AUTH_USER, // AUTHINFO USER sent
+    NNTP_STATE_AUTH_PASS, // AUTHINFO PASS sent
+    NNTP_STATE_READY,     // requests flow
+    NNTP_STATE_CLOSED     // failed, reset or requeued; the socket is the caller's to close
+};
+
+/* Reads per on_readable() call, so one busy connection cannot starve the others */
+#define NNTP_MAX_READS 16
+
+/* A request submitted but not sent yet, because the pipeline was full */
+typedef struct {
+    std::string command; // the whole line, CRLF included
+    PyObject* context;
+    PyObject* sink;
+    Py_ssize_t offset;
+} QueuedRequest;
+
+/*
+ * One NNTP connection, driven by the caller's event loop.
+ *
+ * Owns the session from the greeting onwards: logs in, keeps up to `pipeline` requests
+ * on the wire, feeds its own Decoder and pairs each response with the request that
+ * asked for it. Python submits requests and receives finished NNTPResponses, and
+ * nothing in between - every byte of every article passes through here without a
+ * Python call.
+ *
+ * The caller keeps the socket: it connects it (and completes any TLS handshake),
+ * watches it for readiness and closes it. Reconnecting is the caller's as well, with
+ * requeue() handing back everything this connection had not finished.
+ */
+typedef struct {
+    PyObject_HEAD
+
+    PyObject* sock; // socket.socket or ssl.SSLSocket, non-blocking
+    PyObject* sslobj; // the _ssl object behind an SSLSocket, looked up once; NULL for plain sockets
+    // An error hit after responses were already collected: those are returned first, and
+    // this is raised by the next call
+    PyObject* deferred_error;
+    Decoder* decoder;
+    std::deque<QueuedRequest> queue;
+    // Commands not yet accepted by the socket, sent from out_sent onwards
+    std::string outbuf;
+    size_t out_sent;
+    std::string username;
+    std::string password;
+    std::string command; // "BODY" or "ARTICLE"
+    Py_ssize_t pipeline;
+    Py_ssize_t in_flight; // caller requests sent whose responses have not been returned
+    Py_ssize_t bytes_received;
+    Py_ssize_t bytes_sent;
+    Py_intptr_t fd; // the socket itself for plain connections; TLS goes through sslobj
+    int state;
+    bool authenticate;
+} NNTPConnection;
+
+extern PyTypeObject NNTPConnectionType;
+
+bool nntpconnection_init(PyObject *);
+
+#endif // SABCTOOLS_NNTPCONNECTION_H
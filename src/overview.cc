@@ -0,0 +1,300 @@
+/*
+ * Copyright 2007-2026 The SABnzbd-Team (sabnzbd.org)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "overview.h"
+#include "yenc.h"
+
+#include <charconv>
+
+/* Fields on an overview line: the number, the five text fields, :bytes and :lines */
+#define OVERVIEW_FIELDS (OVERVIEW_TEXT_FIELDS + 3)
+
+/*
+ * Parse a decimal field, or 0 when it is empty or not a number.
+ *
+ * :bytes and :lines are optional in practice whatever RFC 3977 says, and some servers
+ * leave them blank, so a bad one costs the value and not the whole line.
+ */
+static int64_t parse_count(std::string_view field) {
+    int64_t value = 0;
+    auto [ptr, ec] = std::from_chars(field.data(), field.data() + field.size(), value);
+    return ec == std::errc() ? value : 0;
+}
+
+bool overview_parse_line(OverviewColumns *columns, std::string_view line) {
+    std::string_view fields[OVERVIEW_FIELDS];
+    size_t found = 0;
+
+    // Anything past :lines is Xref and other extra headers, which nothing asks for
+    while (found < OVERVIEW_FIELDS) {
+        size_t tab = line.find('\t');
+        fields[found++] = line.substr(0, tab);
+        if (tab == std::string_view::npos) break;
+        line.remove_prefix(tab + 1);
+    }
+
+    // The article number is the one field a line is useless without
+    int64_t number = 0;
+    const std::string_view first = fields[0];
+    auto [ptr, ec] = std::from_chars(first.data(), first.data() + first.size(), number);
+    if (ec != std::errc() || ptr != first.data() + first.size()) {
+        columns->skipped++;
+        return false;
+    }
+
+    columns->number.push_back(number);
+    for (int field = 0; field < OVERVIEW_TEXT_FIELDS; field++) {
+        // Missing trailing fields are left empty rather than dropping the line
+        columns->text[field].append(fields[field + 1]);
+        columns->ends[field].push_back(static_cast<int64_t>(columns->text[field].size()));
+    }
+    columns->bytes.push_back(parse_count(fields[OVERVIEW_TEXT_FIELDS + 1]));
+    columns->lines.push_back(parse_count(fields[OVERVIEW_TEXT_FIELDS + 2]));
+    return true;
+}
+
+void overview_parse_block(OverviewColumns *columns, std::string_view block) {
+    while (!block.empty()) {
+        size_t newline = block.find('\n');
+        std::string_view line = block.substr(0, newline);
+        block.remove_prefix(newline == std::string_view::npos ? block.size() : newline + 1);
+
+        // The compressed form is CRLF like the wire, but be lenient about bare LF
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+
+        // Some servers compress the terminator along with the data
+        if (line == ".") break;
+        if (line.size() >= 2 && line[0] == '.' && line[1] == '.') line.remove_prefix(1);
+        if (line.empty()) continue;
+
+        overview_parse_line(columns, line);
+    }
+}
+
+/* One native array as bytes, so a memoryview cast can expose it without copying again */
+static PyObject *int64_bytes(const std::vector<int64_t> &values) {
+    return PyBytes_FromStringAndSize(reinterpret_cast<const char *>(values.data()),
+                                     static_cast<Py_ssize_t>(values.size() * sizeof(int64_t)));
+}
+
+PyObject *overview_build(OverviewColumns *columns) {
+    Overview *self = reinterpret_cast<Overview *>(OverviewType.tp_alloc(&OverviewType, 0));
+    if (!self) return NULL;
+
+    const Py_ssize_t count = static_cast<Py_ssize_t>(columns->number.size());
+    self->count = count;
+    self->skipped = columns->skipped;
+
+    self->number = int64_bytes(columns->number);
+    self->bytes = int64_bytes(columns->bytes);
+    self->lines = int64_bytes(columns->lines);
+    if (!self->number || !self->bytes || !self->lines) goto error;
+
+    {
+        Py_ssize_t blob_size = 0;
+        for (const std::string &text : columns->text) blob_size += static_cast<Py_ssize_t>(text.size());
+
+        self->blob = PyBytes_FromStringAndSize(NULL, blob_size);
+        if (!self->blob) goto error;
+
+        char *blob = PyBytes_AS_STRING(self->blob);
+        int64_t base = 0;
+        for (int field = 0; field < OVERVIEW_TEXT_FIELDS; field++) {
+            const std::string &text = columns->text[field];
+            memcpy(blob + base, text.data(), text.size());
+
+            // count + 1 offsets, absolute within the blob: entry i is [offsets[i], offsets[i + 1])
+            self->offsets[field] = PyBytes_FromStringAndSize(NULL, (count + 1) * sizeof(int64_t));
+            if (!self->offsets[field]) goto error;
+            int64_t *offsets = reinterpret_cast<int64_t *>(PyBytes_AS_STRING(self->offsets[field]));
+            offsets[0] = base;
+            for (Py_ssize_t index = 0; index < count; index++) {
+                offsets[index + 1] = base + columns->ends[field][index];
+            }
+            base += static_cast<int64_t>(text.size());
+        }
+    }
+
+    return reinterpret_cast<PyObject *>(self);
+
+error:
+    Py_DECREF(self);
+    return NULL;
+}
+
+static void Overview_dealloc(Overview *self) {
+    Py_XDECREF(self->number);
+    Py_XDECREF(self->bytes);
+    Py_XDECREF(self->lines);
+    Py_XDECREF(self->blob);
+    for (PyObject *offsets : self->offsets) Py_XDECREF(offsets);
+    Py_TYPE(self)->tp_free(reinterpret_cast<PyObject *>(self));
+}
+
+/* A fresh int64 view each time: memoryviews are cheap, and this keeps the object immutable */
+static PyObject *int64_view(PyObject *bytes) {
+    PyObject *view = PyMemoryView_FromObject(bytes);
+    if (!view) return NULL;
+    PyObject *cast = PyObject_CallMethod(view, "cast", "s", "q");
+    Py_DECREF(view);
+    return cast;
+}
+
+static PyObject *Overview_get_number(Overview *self, void *Py_UNUSED(closure)) { return int64_view(self->number); }
+static PyObject *Overview_get_bytes(Overview *self, void *Py_UNUSED(closure)) { return int64_view(self->bytes); }
+static PyObject *Overview_get_lines(Overview *self, void *Py_UNUSED(closure)) { return int64_view(self->lines); }
+
+/* The field index travels in the closure, so one getter serves every text column */
+static PyObject *Overview_get_offsets(Overview *self, void *closure) {
+    return int64_view(self->offsets[reinterpret_cast<intptr_t>(closure)]);
+}
+
+static PyObject *Overview_get_blob(Overview *self, void *Py_UNUSED(closure)) {
+    Py_INCREF(self->blob);
+    return self->blob;
+}
+
+static Py_ssize_t Overview_len(Overview *self) {
+    return self->count;
+}
+
+/*
+ * One article as a tuple, for the caller that wants a row rather than columns.
+ *
+ * Costs the Python objects the columnar form exists to avoid, so it is meant for
+ * looking at a few entries, not for walking the whole response.
+ */
+static PyObject *Overview_item(Overview *self, Py_ssize_t index) {
+    if (index < 0 || index >= self->count) {
+        PyErr_SetString(PyExc_IndexError, "Overview index out of range");
+        return NULL;
+    }
+
+    const char *blob = PyBytes_AS_STRING(self->blob);
+    PyObject *row = PyTuple_New(OVERVIEW_FIELDS);
+    if (!row) return NULL;
+
+    PyObject *number = PyLong_FromLongLong(reinterpret_cast<int64_t *>(PyBytes_AS_STRING(self->number))[index]);
+    if (!number) goto error;
+    PyTuple_SET_ITEM(row, 0, number);
+
+    for (int field = 0; field < OVERVIEW_TEXT_FIELDS; field++) {
+        const int64_t *offsets = reinterpret_cast<int64_t *>(PyBytes_AS_STRING(self->offsets[field]));
+        PyObject *text = decode_utf8_with_fallback(
+            std::string_view(blob + offsets[index], static_cast<size_t>(offsets[index + 1] - offsets[index])));
+        if (!text) goto error;
+        PyTuple_SET_ITEM(row, field + 1, text);
+    }
+
+    {
+        PyObject *bytes = PyLong_FromLongLong(reinterpret_cast<int64_t *>(PyBytes_AS_STRING(self->bytes))[index]);
+        if (!bytes) goto error;
+        PyTuple_SET_ITEM(row, OVERVIEW_TEXT_FIELDS + 1, bytes);
+
+        PyObject *lines = PyLong_FromLongLong(reinterpret_cast<int64_t *>(PyBytes_AS_STRING(self->lines))[index]);
+        if (!lines) goto error;
+        PyTuple_SET_ITEM(row, OVERVIEW_TEXT_FIELDS + 2, lines);
+    }
+    return row;
+
+error:
+    Py_DECREF(row);
+    return NULL;
+}
+
+static PyObject *Overview_repr(Overview *self) {
+    return PyUnicode_FromFormat("<sabctools.Overview count=%zd skipped=%zd>", self->count, self->skipped);
+}
+
+static PyMemberDef Overview_members[] = {
+    {"skipped", T_PYSSIZET, offsetof(Overview, skipped), READONLY,
+     PyDoc_STR("Lines that did not start with an article number and were left out")},
+    {nullptr, 0, 0, 0, nullptr}
+};
+
+static PyGetSetDef Overview_getset[] = {
+    {"number", (getter)Overview_get_number, NULL, PyDoc_STR("Article numbers, as int64"), NULL},
+    {"bytes", (getter)Overview_get_bytes, NULL, PyDoc_STR("The :bytes metadata item, as int64"), NULL},
+    {"lines", (getter)Overview_get_lines, NULL, PyDoc_STR("The :lines metadata item, as int64"), NULL},
+    {"blob", (getter)Overview_get_blob, NULL, PyDoc_STR("Every text field, addressed through the offsets"), NULL},
+    {"subject", (getter)Overview_get_offsets, NULL, PyDoc_STR("Offsets of the Subject fields in blob"),
+     reinterpret_cast<void *>(OVERVIEW_SUBJECT)},
+    {"from_", (getter)Overview_get_offsets, NULL, PyDoc_STR("Offsets of the From fields in blob"),
+     reinterpret_cast<void *>(OVERVIEW_FROM)},
+    {"date", (getter)Overview_get_offsets, NULL, PyDoc_STR("Offsets of the Date fields in blob"),
+     reinterpret_cast<void *>(OVERVIEW_DATE)},
+    {"message_id", (getter)Overview_get_offsets, NULL, PyDoc_STR("Offsets of the Message-ID fields in blob"),
+     reinterpret_cast<void *>(OVERVIEW_MESSAGE_ID)},
+    {"references", (getter)Overview_get_offsets, NULL, PyDoc_STR("Offsets of the References fields in blob"),
+     reinterpret_cast<void *>(OVERVIEW_REFERENCES)},
+    {NULL, NULL, NULL, NULL, NULL}
+};
+
+static PySequenceMethods Overview_as_sequence = {
+    (lenfunc)Overview_len,                // sq_length
+    nullptr,                              // sq_concat
+    nullptr,                              // sq_repeat
+    (ssizeargfunc)Overview_item,          // sq_item
+};
+
+PyTypeObject OverviewType = {
+    PyVarObject_HEAD_INIT(nullptr, 0)
+    "sabctools.Overview",                   // tp_name
+    sizeof(Overview),                       // tp_basicsize
+    0,                                      // tp_itemsize
+    (destructor)Overview_dealloc,           // tp_dealloc
+    0,                                      // tp_vectorcall_offset
+    nullptr,                                // tp_getattr
+    nullptr,                                // tp_setattr
+    nullptr,                                // tp_as_async
+    (reprfunc)Overview_repr,                // tp_repr
+    nullptr,                                // tp_as_number
+    &Overview_as_sequence,                  // tp_as_sequence
+    nullptr,                                // tp_as_mapping
+    nullptr,                                // tp_hash
+    nullptr,                                // tp_call
+    nullptr,                                // tp_str
+    nullptr,                                // tp_getattro
+    nullptr,                                // tp_setattro
+    nullptr,                                // tp_as_buffer
+    Py_TPFLAGS_DEFAULT,                     // tp_flags
+    PyDoc_STR("Overview"),                  // tp_doc
+    nullptr,                                // tp_traverse
+    nullptr,                                // tp_clear
+    nullptr,                                // tp_richcompare
+    0,                                      // tp_weaklistoffset
+    nullptr,                                // tp_iter
+    nullptr,                                // tp_iternext
+    nullptr,                                // tp_methods
+    Overview_members,                       // tp_members
+    Overview_getset,                        // tp_getset
+    nullptr,                                // tp_base
+    nullptr,                                // tp_dict
+    nullptr,                                // tp_descr_get
+    nullptr,                                // tp_descr_set
+    0,                                      // tp_dictoffset
+    nullptr,                                // tp_init
+    PyType_GenericAlloc,                    // tp_alloc
+    nullptr,                                // tp_new: only ever built by the decoder
+};
+
+bool overview_init(PyObject *m) {
+    if (PyType_Ready(&OverviewType) < 0) return false;
+    if (PyModule_AddType(m, &OverviewType) < 0) return false;
+    return true;
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2007-2026 The SABnzbd-Team (sabnzbd.org)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef SABCTOOLS_OVERVIEW_H
+#define SABCTOOLS_OVERVIEW_H
+
+#include <Python.h>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/* The text fields of an overview line, in the order RFC 3977 puts them */
+enum OverviewField {
+    OVERVIEW_SUBJECT,
+    OVERVIEW_FROM,
+    OVERVIEW_DATE,
+    OVERVIEW_MESSAGE_ID,
+    OVERVIEW_REFERENCES,
+    OVERVIEW_TEXT_FIELDS
+};
+
+/*
+ * An overview response under construction.
+ *
+ * Filled line by line while the response arrives and turned into an Overview only once
+ * it is complete, so a group of a million articles costs a handful of growing C++
+ * buffers rather than a million Python strings. Each text field gets a buffer of its
+ * own and the buffers are laid end to end when the response completes: one column's
+ * strings are then contiguous in the blob, and its offsets need no second array of
+ * lengths.
+ */
+struct OverviewColumns {
+    std::vector<int64_t> number;
+    std::vector<int64_t> bytes;
+    std::vector<int64_t> lines;
+    std::string text[OVERVIEW_TEXT_FIELDS];
+    // Where each entry ends within text[field]; it starts where the previous one ended
+    std::vector<int64_t> ends[OVERVIEW_TEXT_FIELDS];
+    // Lines that did not start with an article number
+    Py_ssize_t skipped = 0;
+};
+
+/*
+ * The parsed result of an OVER, XOVER or XZVER response.
+ *
+ * Columnar, so indexing a group costs a fixed handful of objects per response however
+ * many articles it lists. Numeric columns are native int64 arrays; the text columns all
+ * live in one bytes blob, each with an array of count + 1 offsets into it.
+ */
+typedef struct {
+    PyObject_HEAD
+
+    Py_ssize_t count;
+    Py_ssize_t skipped;
+    PyObject *number;
+    PyObject *bytes;
+    PyObject *lines;
+    PyObject *blob;
+    PyObject *offsets[OVERVIEW_TEXT_FIELDS];
+} Overview;
+
+extern PyTypeObject OverviewType;
+
+bool overview_init(PyObject *);
+
+/* Add one overview line, dot-unstuffed and without its CRLF. False if it was skipped. */
+bool overview_parse_line(OverviewColumns *columns, std::string_view line);
+
+/* Add every line of an inflated XZVER block, stopping at a terminating "." */
+void overview_parse_block(OverviewColumns *columns, std::string_view block);
+
+/* Build the Overview for a completed response. New reference, or NULL on error. */
+PyObject *overview_build(OverviewColumns *columns);
+
+#endif // SABCTOOLS_OVERVIEW_H
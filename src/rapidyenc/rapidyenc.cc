@@ -122,5 +122,57 @@ int rapidyenc_crc_kernel() {
 	return RapidYenc::crc32_isa_level();
 }
 
+#ifndef RAPIDYENC_DISABLE_DECODE
+// Input per block: with its output, at most as large again, this still fits a 32KB L1
+#define RAPIDYENC_FUSED_BLOCK 16384
+RapidYencDecoderEnd rapidyenc_decode_incremental_crc(const void** src, void** dest, size_t src_length, RapidYencDecoderState* state, uint32_t* crc) {
+	RapidYencDecoderState unusedState = RYDEC_STATE_CRLF;
+	if(!state) state = &unusedState;
+	uint32_t running = *crc;
+	RapidYenc::YencDecoderEnd ended = RapidYenc::YDEC_END_NONE;
+	while(src_length) {
+		// end blocks on a 64-byte boundary, so the SIMD kernels' alignment prologue only runs once
+		size_t block = RAPIDYENC_FUSED_BLOCK - ((uintptr_t)*src & 63);
+		if(block > src_length) block = src_length;
+		unsigned char* out = (unsigned char*)*dest;
+		ended = RapidYenc::decode_end(src, dest, block, (RapidYenc::YencDecoderState*)state);
+		running = RapidYenc::crc32(out, (unsigned char*)*dest - out, running);
+		if(ended != RapidYenc::YDEC_END_NONE) break;
+		src_length -= block;
+	}
+	*crc = running;
+	return (RapidYencDecoderEnd)ended;
+}
+#endif
+
+#ifndef RAPIDYENC_DISABLE_ENCODE
+// Input per block: typical output is barely larger, so both usually fit a 32KB L1
+#define RAPIDYENC_FUSED_ENCODE_BLOCK 16384
+size_t rapidyenc_encode_ex_crc(int line_size, int* column, const void* __restrict src, void* __restrict dest, size_t src_length, int is_end, uint32_t* crc) {
+	int unusedColumn = 0;
+	if(!column) column = &unusedColumn;
+	// nothing to interleave with a single block: the separate calls do the same work
+	if(src_length <= RAPIDYENC_FUSED_ENCODE_BLOCK) {
+		size_t written = RapidYenc::encode(line_size, column, src, dest, src_length, is_end);
+		*crc = RapidYenc::crc32(src, src_length, *crc);
+		return written;
+	}
+	const unsigned char* in = (const unsigned char*)src;
+	unsigned char* out = (unsigned char*)dest;
+	uint32_t running = *crc;
+	while(src_length) {
+		// end blocks on a 64-byte boundary, so every block's vector loads stay aligned
+		size_t block = RAPIDYENC_FUSED_ENCODE_BLOCK - ((uintptr_t)in & 63);
+		if(block > src_length) block = src_length;
+		out += RapidYenc::encode(line_size, column, in, out, block, is_end && block == src_length);
+		running = RapidYenc::crc32(in, block, running);
+		in += block;
+		src_length -= block;
+	}
+	*crc = running;
+	return out - (unsigned char*)dest;
+}
+#endif
+
 #endif // !defined(RAPIDYENC_DISABLE_CRC)
 
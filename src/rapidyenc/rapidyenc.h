@@ -74,6 +74,16 @@ RAPIDYENC_API size_t rapidyenc_encode(const void* __restrict src, void* __restri
  */
 RAPIDYENC_API size_t rapidyenc_encode_ex(int line_size, int* column, const void* __restrict src, void* __restrict dest, size_t src_length, int is_end);
 
+#ifndef RAPIDYENC_DISABLE_CRC
+/**
+ * Like `rapidyenc_encode_ex`, but also folds the source data into `*crc`
+ * The result is the same as following it with `*crc = rapidyenc_crc(src, src_length, *crc)`, except that the source is
+ * encoded in blocks small enough to stay in L1 cache, and each block is hashed right after it was encoded
+ * `rapidyenc_crc_init` must have been called as well as `rapidyenc_encode_init`
+ */
+RAPIDYENC_API size_t rapidyenc_encode_ex_crc(int line_size, int* column, const void* __restrict src, void* __restrict dest, size_t src_length, int is_end, uint32_t* crc);
+#endif
+
 /**
  * Returns the kernel/ISA level used for encoding
  * Values correspond with RYKERN_* definitions above
@@ -154,6 +164,16 @@ RAPIDYENC_API size_t rapidyenc_decode_ex(int is_raw, const void* src, void* dest
  */
 RAPIDYENC_API RapidYencDecoderEnd rapidyenc_decode_incremental(const void** src, void** dest, size_t src_length, RapidYencDecoderState* state);
 
+#ifndef RAPIDYENC_DISABLE_CRC
+/**
+ * Like `rapidyenc_decode_incremental`, but also folds the decoded bytes into `*crc`
+ * The result is the same as following it with `*crc = rapidyenc_crc(dest_before, dest_after - dest_before, *crc)`, except that
+ * the input is decoded in blocks small enough to stay in L1 cache, and each block's output is hashed right after it is written
+ * `rapidyenc_crc_init` must have been called as well as `rapidyenc_decode_init`
+ */
+RAPIDYENC_API RapidYencDecoderEnd rapidyenc_decode_incremental_crc(const void** src, void** dest, size_t src_length, RapidYencDecoderState* state, uint32_t* crc);
+#endif
+
 /**
  * Returns the kernel/ISA level used for decoding
  * Values correspond with RYKERN_* definitions above
@@ -107,8 +107,10 @@ size_t RapidYenc::do_encode_generic(int line_size, int* colOffset, const unsigne
 			if (RapidYenc::escapedLUT[c] && c != '.'-42) {
 				memcpy(p, &RapidYenc::escapedLUT[c], sizeof(uint16_t));
 				p += 2;
+				col += 2;
 			} else {
 				*(p++) = c + 42;
+				col++;
 			}
 		}
 		
@@ -65,8 +65,10 @@ static size_t do_encode_simd(int line_size, int* colOffset, const unsigned char*
 				if (RapidYenc::escapedLUT[c] && c != '.'-42) {
 					memcpy(p, RapidYenc::escapedLUT + c, 2);
 					p += 2;
+					(*colOffset) += 2;
 				} else {
 					*(p++) = c + 42;
+					(*colOffset)++;
 				}
 				if(i == 0) break;
 				c = es[i++];
@@ -22,6 +22,13 @@
 #include "crc32.h"
 #include "sparse.h"
 #include "filewriter.h"
+#include "overview.h"
+#include "statdecoder.h"
+#include "sessioncache.h"
+#include "nntpconnection.h"
+#include "encoder.h"
+#include "fileassembler.h"
+#include "fileencoder.h"
 #include "utils.h"
 
 /* Function and exception declarations */
@@ -35,12 +42,48 @@ static PyMethodDef sabctools_methods[] = {
         METH_O,
         "yenc_encode(input_string)"
     },
+    {
+        "build_article",
+        (PyCFunction)(void(*)(void))build_article,
+        METH_VARARGS | METH_KEYWORDS,
+        "build_article(source, part, total, begin, end, name, headers=None, crc=None, size=None, line_size=128)"
+    },
+    {
+        "encode_file",
+        (PyCFunction)(void(*)(void))encode_file,
+        METH_VARARGS | METH_KEYWORDS,
+        "encode_file(path, part_size=716800, line_size=128, threads=0, window=0, name=None, headers=None)"
+    },
     {
         "unlocked_ssl_recv_into",
         unlocked_ssl_recv_into,
         METH_VARARGS,
         "unlocked_ssl_recv_into(ssl_socket, buffer)"
     },
+    {
+        "unlocked_ssl_send",
+        unlocked_ssl_send,
+        METH_VARARGS,
+        "unlocked_ssl_send(ssl_socket, buffer)"
+    },
+    {
+        "unlocked_ssl_decrypt_into",
+        unlocked_ssl_decrypt_into,
+        METH_VARARGS,
+        "unlocked_ssl_decrypt_into(ssl_object, ciphertext, buffer)"
+    },
+    {
+        "crc32",
+        (PyCFunction)(void(*)(void))crc32_compute,
+        METH_VARARGS | METH_KEYWORDS,
+        "crc32(data, offset=0, length=None, init=0, threads=1)"
+    },
+    {
+        "scan_blocks",
+        (PyCFunction)(void(*)(void))scan_blocks,
+        METH_VARARGS | METH_KEYWORDS,
+        "scan_blocks(data, block_size, crcs)"
+    },
     {
         "crc32_combine",
         crc32_combine,
@@ -71,6 +114,12 @@ static PyMethodDef sabctools_methods[] = {
         METH_O,
         "crc32_xpow8n(n)"
     },
+    {
+        "crc32_many",
+        crc32_many,
+        METH_O,
+        "crc32_many(buffers)"
+    },
     {
         "sparse",
         sparse,
@@ -152,6 +201,41 @@ PyMODINIT_FUNC PyInit_sabctools(void) {
         return NULL;
     }
 
+    if (!overview_init(m)) {
+        Py_DECREF(m);
+        return NULL;
+    }
+
+    if (!statdecoder_init(m)) {
+        Py_DECREF(m);
+        return NULL;
+    }
+
+    if (!sessioncache_init(m)) {
+        Py_DECREF(m);
+        return NULL;
+    }
+
+    if (!nntpconnection_init(m)) {
+        Py_DECREF(m);
+        return NULL;
+    }
+
+    if (!encoder_init(m)) {
+        Py_DECREF(m);
+        return NULL;
+    }
+
+    if (!fileencoder_init(m)) {
+        Py_DECREF(m);
+        return NULL;
+    }
+
+    if (!fileassembler_init(m)) {
+        Py_DECREF(m);
+        return NULL;
+    }
+
     PyModule_AddStringConstant(m, "version", SABCTOOLS_VERSION);
     PyModule_AddStringConstant(m, "simd", kernel_name(rapidyenc_decode_kernel()));
     PyModule_AddStringConstant(m, "crc_simd", kernel_name(rapidyenc_crc_kernel()));
@@ -1,8 +1,9 @@
 from enum import IntEnum
 from os import PathLike
 from types import TracebackType
-from typing import Tuple, Optional, IO, List, Iterator, Union, Type
-from ssl import SSLSocket
+from typing import Callable, Tuple, Optional, IO, List, Iterable, Iterator, Mapping, Union, Type
+from socket import socket
+from ssl import SSLSocket, SSLObject
 from _typeshed import ReadableBuffer, WriteableBuffer
 
 __version__: str
@@ -11,12 +12,206 @@ simd: str
 crc_simd: str
 
 def yenc_encode(input_string: bytes) -> Tuple[bytes, int]: ...
+
+class Encoder:
+    """yEnc encoder for one article fed in any number of chunks.
+
+    The column and the CRC of the input carry over between encode() calls, so a part can
+    be read from a file a piece at a time. reset() starts the next article.
+    """
+
+    def __init__(self, line_size: int = 128) -> None: ...
+    line_size: int
+    column: int
+    """Column the next chunk continues from"""
+    crc: int
+    """CRC32 of the input encoded since the last reset()"""
+    bytes_in: int
+    bytes_out: int
+    ended: bool
+    """The last chunk was encoded with is_end"""
+
+    def encode(
+        self, data: ReadableBuffer, out: Optional[WriteableBuffer] = None, is_end: bool = False
+    ) -> Union[bytes, int]:
+        """Encode the next chunk, from any contiguous buffer.
+
+        With `out`, which needs max_length(len(data)) bytes and must not overlap `data`,
+        the output is written to its start and the count written is returned; without it
+        the output is returned as bytes. `is_end` marks the last chunk of the article, so
+        that a space or tab ending it is escaped; it may be an empty chunk, as a chunk
+        ending in a space or tab keeps it back until the next call.
+        """
+
+    def reset(self) -> None:
+        """Start the next article at column 0 with the CRC cleared."""
+
+    def max_length(self, length: int) -> int:
+        """The size `out` needs to encode `length` bytes."""
+
+def build_article(
+    source: ReadableBuffer,
+    part: int,
+    total: int,
+    begin: int,
+    end: int,
+    name: Union[str, bytes],
+    headers: Optional[
+        Union[Mapping[Union[str, bytes], Union[str, bytes]], Iterable[Tuple[Union[str, bytes], Union[str, bytes]]]]
+    ] = None,
+    crc: Optional[int] = None,
+    size: Optional[int] = None,
+    line_size: int = 128,
+) -> Tuple[bytes, int, int]:
+    """Encode source[begin:end] as part `part` of `total`, as a complete article.
+
+    `source` is the whole file (an mmap, say) and the offsets are 0-based. The result
+    holds the NNTP headers and blank line (none when `headers` is None), =ybegin, =ypart,
+    the body, =yend with pcrc32 (and crc32 on the last part) and the "." terminator.
+
+    `crc` is the CRC32 of source[:begin], as returned for the previous part; when None
+    it is computed from the source. Returns (article, pcrc32, crc32 of source[:end]).
+    """
+
+class FileEncoder(Iterator[Tuple[bytes, int, int, int, int]]):
+    """A file encoded into articles on a pool of threads, yielded in order as
+    (article, part, begin, end, pcrc32).
+
+    Each article is what build_article() returns for the same part, encoded on up to 64
+    threads. At most `window` parts (default twice the threads) are read and encoded
+    ahead of the caller.
+    `headers` is None, a mapping, or a callable(part, total) returning either.
+    """
+
+    def __init__(
+        self,
+        path: Union[str, bytes, PathLike],
+        part_size: int = 716800,
+        line_size: int = 128,
+        threads: int = 0,
+        window: int = 0,
+        name: Optional[Union[str, bytes]] = None,
+        headers: Optional[
+            Union[
+                Mapping[Union[str, bytes], Union[str, bytes]],
+                Callable[[int, int], Optional[Mapping[Union[str, bytes], Union[str, bytes]]]],
+            ]
+        ] = None,
+    ) -> None: ...
+    parts: int
+    yielded: int
+    size: int
+    crc: int
+    """CRC32 of the parts yielded so far; the whole file's once all have been"""
+    threads: int
+    window: int
+    path: Union[str, bytes]
+    def __iter__(self) -> FileEncoder: ...
+    def __next__(self) -> Tuple[bytes, int, int, int, int]: ...
+    def close(self) -> None:
+        """Stop the workers, drop the articles not yielded yet and close the file."""
+
+    def __enter__(self) -> FileEncoder: ...
+    def __exit__(
+        self,
+        exc_type: Optional[Type[BaseException]],
+        exc_value: Optional[BaseException],
+        traceback: Optional[TracebackType],
+    ) -> None: ...
+
+def encode_file(
+    path: Union[str, bytes, PathLike],
+    part_size: int = 716800,
+    line_size: int = 128,
+    threads: int = 0,
+    window: int = 0,
+    name: Optional[Union[str, bytes]] = None,
+    headers: Optional[
+        Union[
+            Mapping[Union[str, bytes], Union[str, bytes]],
+            Callable[[int, int], Optional[Mapping[Union[str, bytes], Union[str, bytes]]]],
+        ]
+    ] = None,
+) -> FileEncoder:
+    """Same as FileEncoder(path, ...)"""
+
 def unlocked_ssl_recv_into(ssl_socket: SSLSocket, buffer: WriteableBuffer) -> int: ...
+def unlocked_ssl_send(ssl_socket: SSLSocket, buffer: ReadableBuffer) -> int:
+    """Send from any buffer on a non-blocking SSLSocket with the GIL released.
+
+    Returns the bytes sent. Raises SSLWantWriteError (or SSLWantReadError) when nothing
+    could be sent; retry with the same data."""
+
+def unlocked_ssl_decrypt_into(ssl_object: SSLObject, ciphertext: ReadableBuffer, buffer: WriteableBuffer) -> int:
+    """Feed ciphertext read from the raw socket into a wrap_bio() SSLObject and decrypt
+    into `buffer`, all with the GIL released.
+
+    Returns the plaintext bytes written, 0 once the peer has closed the TLS session.
+    Raises SSLWantReadError when more ciphertext is needed. Plaintext that did not fit
+    is kept and returned by a later call, which may pass empty ciphertext.
+
+    Any thread may decrypt a given SSLObject, but only one at a time: a second thread
+    calling in while the first is still decrypting gets RuntimeError."""
+
+def crc32(
+    data: Union[ReadableBuffer, str, PathLike],
+    offset: int = 0,
+    length: Optional[int] = None,
+    init: int = 0,
+    threads: int = 1,
+) -> int:
+    """CRC32 of a buffer, or of a file given by a str or os.PathLike path (bytes are data).
+
+    Covers `length` bytes from `offset`, to the end when None, continuing from `init` as
+    zlib.crc32's second argument does. With threads above 1 (0 for one per core) a large
+    range is split across threads and the pieces joined with crc32_combine. At most 64
+    threads are used, however many are asked for. Runs with the GIL released.
+    """
+
+class FileAssembler:
+    """Whole-file CRC32 from the CRCs of its parts, added in any order as they complete.
+
+    Adjacent parts are merged with crc32_combine as they arrive, so the file's CRC is
+    known when the last part lands, without reading the file back.
+    """
+
+    def __init__(self, size: int) -> None: ...
+    size: int
+    covered: int
+    """Bytes added so far"""
+    added: int
+    runs: int
+    """Contiguous runs the parts have merged into"""
+    complete: bool
+    crc: int
+    """CRC32 of the file, with the ranges not added yet taken as zeros"""
+    def add(self, begin: int, size: int, crc: int) -> Optional[int]:
+        """Record the CRC32 of file[begin:begin + size], as a response's part_begin,
+        part_size and crc. Returns the file's CRC32 once this completes it, else None.
+        Raises ValueError for a part outside the file or overlapping one already added."""
+
+    def missing(self) -> List[Tuple[int, int]]:
+        """The (begin, end) ranges not added yet, in order."""
+
 def crc32_combine(crc1: int, crc2: int, length: int) -> int: ...
 def crc32_multiply(crc1: int, crc2: int) -> int: ...
 def crc32_xpow8n(n: int) -> int: ...
 def crc32_xpown(n: int) -> int: ...
 def crc32_zero_unpad(crc1: int, length: int) -> int: ...
+def crc32_many(buffers: Iterable[ReadableBuffer]) -> List[int]:
+    """CRC32 of each buffer, hashed back to back under one release of the GIL."""
+
+def scan_blocks(
+    data: Union[ReadableBuffer, str, PathLike], block_size: int, crcs: Iterable[int]
+) -> List[Tuple[int, int]]:
+    """Find blocks of block_size bytes whose CRC32 is in crcs, at any byte offset.
+
+    A rolling CRC is slid over the buffer or file one byte at a time; each match is
+    confirmed with a full CRC and reported as (offset, index into crcs), with every
+    index sharing that CRC. The scan continues after a found block. Runs with the GIL
+    released.
+    """
+
 def sparse(file: Union[IO, int], length: int) -> None:
     """Deprecated in favour of FileWriter.preallocate, kept for existing callers."""
 
@@ -68,6 +263,34 @@ class NNTPResponse:
     An OSError for a real disk error, carrying its errno and the file it was writing -
     a full disk arrives as ENOSPC. A ValueError when the file had simply been closed,
     which is what a deleted job looks like. None when no write failed."""
+    overview: Optional["Overview"]
+    """Parsed lines of an OVER/XOVER/XZVER (224) response, None for anything else or
+    when an XZVER block could not be inflated"""
+
+class Overview:
+    """Columns of an overview response, one entry per article.
+
+    Text fields share one blob: entry i of a field is blob[field[i]:field[i + 1]]."""
+
+    number: memoryview
+    """Article numbers, as int64"""
+    bytes: memoryview
+    """The :bytes metadata, as int64, 0 when missing"""
+    lines: memoryview
+    """The :lines metadata, as int64, 0 when missing"""
+    blob: bytes
+    """UTF-8 (or latin-1) text of every text field, end to end"""
+    subject: memoryview
+    from_: memoryview
+    date: memoryview
+    message_id: memoryview
+    references: memoryview
+    skipped: int
+    """Lines that were dropped because they did not start with an article number"""
+
+    def __len__(self) -> int: ...
+    def __getitem__(self, index: int) -> Tuple[int, str, str, str, str, str, int, int]:
+        """(number, subject, from, date, message-id, references, bytes, lines) of one entry"""
 
 class Decoder:
     def __init__(self, size: int):
@@ -84,7 +307,7 @@ class Decoder:
     pending: Tuple[object, ...]
     """Contexts of the requests still awaiting a response, oldest first"""
 
-    def expect(self, context: object, sink: Optional["FileWriter"] = None) -> None:
+    def expect(self, context: object, sink: Optional["FileWriter"] = None, offset: int = 0) -> None:
         """Record that a request has been sent, so its response can be paired with it.
 
         `context` is returned untouched as NNTPResponse.context. Calls must be in the
@@ -93,12 +316,49 @@ class Decoder:
         When `sink` is given, the decoded body is written into it at the offset the
         yEnc headers declare rather than collected into a bytearray, and the response's
         `data` is left as None. Bodies larger than the internal staging buffer are
-        written in pieces. uu-encoded articles carry no offsets, so a sink is ignored
-        for those and `data` is populated as usual.
+        written in pieces. uu-encoded articles carry no offsets, so those are written
+        sequentially starting at `offset`: 0 for a single-part post, the size of the
+        parts before it for one part of a multi-part post. yEnc ignores `offset`.
+        """
+
+    def queue_requests(
+        self,
+        template: ReadableBuffer,
+        requests: List[
+            Union[
+                Tuple[Union[str, bytes], object],
+                Tuple[Union[str, bytes], object, Optional["FileWriter"]],
+                Tuple[Union[str, bytes], object, Optional["FileWriter"], int],
+            ]
+        ],
+    ) -> bytes:
+        """Build the commands for a batch of requests and expect() every one of them.
+
+        `template` is a whole command with one %s for the message-id, line ending
+        included, e.g. b"BODY <%s>\\r\\n". Each request is (message_id, context),
+        (message_id, context, sink) or (message_id, context, sink, offset). Every item is
+        checked first, so on error nothing is recorded. Returns the concatenated
+        commands, ready for sendall().
         """
 
     def clear_expected(self) -> None:
         """Forget every pending request, for a connection being reset."""
+    compressed: bool
+    """Whether enable_compression() has been called"""
+    compressed_bytes: int
+    """Deflated bytes inflated so far"""
+    decompressed_bytes: int
+    """Bytes those inflated to"""
+
+    def enable_compression(self, wbits: int = -15) -> None:
+        """Inflate everything received from now on, after a 206 reply to COMPRESS DEFLATE.
+
+        The buffer protocol then exports a separate buffer for the compressed bytes, and
+        process() inflates them into the internal buffer before decoding, so the read
+        loop is unchanged. Bytes already received past the 206 are treated as
+        compressed. Commands sent from then on have to be deflated by the caller.
+        Raises zlib.error from process() on a corrupt stream.
+        """
 
     def process(self, length: int) -> None:
         """Process `length` additional bytes of the internal buffer.
@@ -112,6 +372,54 @@ class Decoder:
         streaming decode of multiple NNTP responses.
         """
 
+class SessionCache:
+    """The newest resumable TLS session per (host, port), shared by every new connection.
+
+    Sessions are copied in and out, so a connection closed without close_notify does not
+    spoil the cached one for the next reconnect."""
+
+    def __init__(self) -> None: ...
+    def __len__(self) -> int: ...
+    hits: int
+    """apply() calls that found a session for the server"""
+    misses: int
+    """apply() calls that found none"""
+    resumed: int
+    """Connections passed to store() whose handshake resumed a session"""
+
+    def apply(self, ssl_socket: Union[SSLSocket, SSLObject], host: str, port: int) -> bool:
+        """Use the cached session for this server. Must come before the handshake, so
+        wrap with do_handshake_on_connect=False. True when a session was applied."""
+
+    def store(self, ssl_socket: Union[SSLSocket, SSLObject], host: str, port: int) -> bool:
+        """Keep this connection's session for the server. Call after the first read: a
+        TLS 1.3 ticket only arrives then. False when there was nothing resumable."""
+
+    def clear(self) -> None: ...
+
+class StatDecoder:
+    """Reply codes of pipelined STAT/HEAD requests, without an object per reply.
+
+    Filled like a Decoder: write into its buffer, then call process(length). The code of
+    the nth reply since reset() lands in codes[n]."""
+
+    def __init__(self, size: int): ...
+    def __buffer__(self, __flags: int) -> memoryview: ...
+    def __release_buffer__(self, __buffer: memoryview) -> None: ...
+    count: int
+    """Requests in the current batch"""
+    received: int
+    """Replies received for the current batch"""
+    codes: Optional[memoryview]
+    """int16 reply codes in request order; 0 until answered, -1 for a line that was not a
+    status line. The bodies of 220/221/222 replies are skipped."""
+
+    def reset(self, count: int) -> None:
+        """Start a batch of `count` requests. The previous `codes` view stays valid."""
+
+    def process(self, length: int) -> None:
+        """Parse `length` more bytes. Raises ValueError on more replies than requests."""
+
 class FileWriter:
     """A file opened for positional writes.
 
@@ -121,9 +429,33 @@ class FileWriter:
     Python itself has no equivalent for: os.pwrite is Unix only.
     """
 
-    def __init__(self, path: Union[str, bytes, PathLike]) -> None:
-        """Open path for writing, creating it if it does not exist."""
+    def __init__(
+        self, path: Union[str, bytes, PathLike], io_uring: bool = False, direct: bool = False, writeback: int = 0
+    ) -> None:
+        """Open path for writing, creating it if it does not exist.
+
+        With io_uring, bodies a Decoder streams here are written through a process-wide
+        io_uring, submitted without waiting and settled before the response is returned.
+        Linux only; elsewhere, or where the ring cannot be set up, writes use pwrite.
+
+        With direct, writes bypass the page cache: on Linux the 4 KB-aligned middle of
+        each write goes through O_DIRECT and the unaligned ends are written buffered; on
+        macOS the file is marked F_NOCACHE. Windows, and filesystems that refuse direct
+        I/O, stay buffered. Takes precedence over io_uring.
+
+        With a writeback window of that many bytes (Linux), each window written in full
+        has its writeback started with sync_file_range, and the windows started the time
+        before are waited for and dropped from the page cache. Completion is counted per
+        window, so writes may come in any order; dirty data stays at the windows still
+        being filled plus one round of writeback.
+        """
     closed: bool
+    direct: bool
+    """Whether writes actually bypass the page cache"""
+    writeback: int
+    """Bytes per writeback window, 0 when off or not supported"""
+    io_uring: bool
+    """Whether streamed writes actually go through io_uring"""
     path: Optional[str]
     size: int
     """Current length of the file, read from the owned handle"""
@@ -135,6 +467,15 @@ class FileWriter:
         len(data) unless an error was raised.
         """
 
+    def write_many(self, items: Iterable[Tuple[ReadableBuffer, int]]) -> List[bool]:
+        """Write (data, offset) pairs under one release of the GIL.
+
+        Items are written in offset order, and those that follow on exactly from one
+        another are merged into pwritev calls of up to IOV_MAX buffers. Returns, in the
+        order given, whether each item was written whole; write() the failures again to
+        see the error. Raises ValueError on a closed writer.
+        """
+
     def preallocate(self, length: int) -> None:
         """Set the file length, marking it sparse first where the filesystem requires it."""
 
@@ -148,3 +489,49 @@ class FileWriter:
         exc: Optional[BaseException],
         tb: Optional[TracebackType],
     ) -> None: ...
+
+class NNTPConnection:
+    """One NNTP session on a connected non-blocking socket, driven by the caller's event loop.
+
+    Logs in, keeps up to `pipeline` requests in flight and decodes with its own Decoder.
+    The caller watches fileno() for reading, and for writing while wants_write is set."""
+
+    def __init__(
+        self,
+        sock: Union[socket, SSLSocket],
+        username: Optional[str] = None,
+        password: Optional[str] = None,
+        pipeline: int = 1,
+        buffer_size: int = 262144,
+        command: str = "BODY",
+    ): ...
+    state: str
+    """greeting, authenticating, ready or closed"""
+    wants_write: bool
+    queued: int
+    """Requests waiting for room in the pipeline"""
+    in_flight: int
+    """Requests sent whose responses have not been returned yet"""
+    pipeline: int
+    bytes_received: int
+    bytes_sent: int
+    sock: Union[socket, SSLSocket]
+
+    def submit(
+        self, message_id: Union[str, bytes], context: object, sink: Optional[FileWriter] = None, offset: int = 0
+    ) -> None:
+        """Queue a BODY (or ARTICLE) request; context comes back as NNTPResponse.context."""
+
+    def group(self, name: Union[str, bytes], context: object = None) -> None:
+        """Queue a GROUP command, answered with a 211 response."""
+
+    def on_readable(self) -> List[NNTPResponse]:
+        """Read, decode and return the finished responses. Raises PermissionError or
+        ConnectionRefusedError when the login or greeting fails, ConnectionResetError
+        once the server has hung up."""
+
+    def on_writable(self) -> None: ...
+    def requeue(self) -> List[object]:
+        """Close, returning the contexts of every request not answered, oldest first."""
+
+    def fileno(self) -> int: ...
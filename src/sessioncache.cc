@@ -0,0 +1,249 @@
+/*
+ * Copyright 2007-2026 The SABnzbd-Team (sabnzbd.org)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "sessioncache.h"
+#include "unlocked_ssl.h"
+
+static PyObject *SessionCache_new(PyTypeObject *type, PyObject *args, PyObject *kwds) {
+    if (!openssl_sessions_linked()) {
+        PyErr_SetString(PyExc_OSError, "Failed to link with OpenSSL");
+        return NULL;
+    }
+
+    SessionCache *self = reinterpret_cast<SessionCache *>(type->tp_alloc(type, 0));
+    if (!self) return NULL;
+
+    new (&self->sessions) std::map<std::pair<std::string, int>, void *>();
+    new (&self->lock) std::mutex();
+    self->hits = 0;
+    self->misses = 0;
+    self->resumed = 0;
+    return reinterpret_cast<PyObject *>(self);
+}
+
+static void SessionCache_free_all(SessionCache *self) {
+    for (auto &entry : self->sessions) {
+        openssl_session_free(entry.second);
+    }
+    self->sessions.clear();
+}
+
+static void SessionCache_dealloc(SessionCache *self) {
+    SessionCache_free_all(self);
+    self->sessions.~map();
+    self->lock.~mutex();
+    Py_TYPE(self)->tp_free(reinterpret_cast<PyObject *>(self));
+}
+
+/*
+ * Sessions are copied both on the way in and on the way out, never shared with a live
+ * connection. A connection closed without a close_notify - every one of them, when a
+ * provider drops the lot - marks the SSL_SESSION it used as not resumable, and had
+ * that been the cached object, one dead connection would disable resumption for every
+ * reconnect to the server that followed.
+ */
+
+/*
+ * Give a new connection the cached session for its server, before its handshake.
+ *
+ * Has to come before the first byte of the handshake, so an SSLSocket must have been
+ * wrapped with do_handshake_on_connect=False. True when a session was applied; whether
+ * the server then accepts it only shows after the handshake, and store() counts that.
+ */
+static PyObject *SessionCache_apply(SessionCache *self, PyObject *args) {
+    PyObject *ssl_socket;
+    const char *host;
+    int port;
+    if (!PyArg_ParseTuple(args, "Osi:apply", &ssl_socket, &host, &port)) return NULL;
+
+    // Looked up before locking: nothing that can run Python code, and so switch
+    // threads, may happen while the lock is held
+    PyObject *owner = NULL;
+    void *ssl = openssl_get_ssl(ssl_socket, &owner);
+    if (!ssl) return NULL;
+
+    // Copied under the lock, so store() cannot free the cache's reference mid-copy
+    void *session = nullptr;
+    {
+        std::lock_guard<std::mutex> guard(self->lock);
+        auto found = self->sessions.find({host, port});
+        if (found == self->sessions.end()) {
+            self->misses++;
+        } else {
+            self->hits++;
+            session = openssl_session_dup(found->second);
+        }
+    }
+
+    bool applied = false;
+    if (session) {
+        applied = openssl_set_session(ssl, session);
+        // The connection holds its own reference now, if it took it
+        openssl_session_free(session);
+    }
+    Py_DECREF(owner);
+    return PyBool_FromLong(applied);
+}
+
+/*
+ * Keep the session of an established connection for the next one to its server.
+ *
+ * Call it after the first read rather than straight after the handshake: under TLS 1.3
+ * the session ticket follows the handshake as a separate message, which OpenSSL only
+ * processes while reading, so until then there is nothing resumable to keep. False
+ * when there was not. Replaces whatever was cached for the server, so an expired
+ * session the server turned down is overwritten by the one it issued instead.
+ */
+static PyObject *SessionCache_store(SessionCache *self, PyObject *args) {
+    PyObject *ssl_socket;
+    const char *host;
+    int port;
+    if (!PyArg_ParseTuple(args, "Osi:store", &ssl_socket, &host, &port)) return NULL;
+
+    PyObject *owner = NULL;
+    void *ssl = openssl_get_ssl(ssl_socket, &owner);
+    if (!ssl) return NULL;
+
+    const bool reused = openssl_session_reused(ssl);
+    void *session = nullptr;
+    void *live = openssl_get1_session(ssl);
+    Py_DECREF(owner);
+    if (live) {
+        if (openssl_session_resumable(live)) session = openssl_session_dup(live);
+        openssl_session_free(live);
+    }
+
+    void *previous = nullptr;
+    {
+        std::lock_guard<std::mutex> guard(self->lock);
+        if (reused) self->resumed++;
+        if (session) {
+            void *&slot = self->sessions[{host, port}];
+            previous = slot;
+            slot = session;
+        }
+    }
+    if (previous) openssl_session_free(previous);
+    return PyBool_FromLong(session != nullptr);
+}
+
+static PyObject *SessionCache_clear(SessionCache *self, PyObject *Py_UNUSED(ignored)) {
+    std::lock_guard<std::mutex> guard(self->lock);
+    SessionCache_free_all(self);
+    Py_RETURN_NONE;
+}
+
+static Py_ssize_t SessionCache_len(SessionCache *self) {
+    std::lock_guard<std::mutex> guard(self->lock);
+    return static_cast<Py_ssize_t>(self->sessions.size());
+}
+
+static PyObject *SessionCache_repr(SessionCache *self) {
+    std::lock_guard<std::mutex> guard(self->lock);
+    return PyUnicode_FromFormat("<SessionCache servers=%zd hits=%zd misses=%zd resumed=%zd>",
+                                static_cast<Py_ssize_t>(self->sessions.size()), self->hits, self->misses,
+                                self->resumed);
+}
+
+// Getters rather than members: the counters are written under the lock, and offsetof
+// is only conditionally supported on a type that holds a std::map
+static PyObject *SessionCache_get_hits(SessionCache *self, void *Py_UNUSED(closure)) {
+    std::lock_guard<std::mutex> guard(self->lock);
+    return PyLong_FromSsize_t(self->hits);
+}
+
+static PyObject *SessionCache_get_misses(SessionCache *self, void *Py_UNUSED(closure)) {
+    std::lock_guard<std::mutex> guard(self->lock);
+    return PyLong_FromSsize_t(self->misses);
+}
+
+static PyObject *SessionCache_get_resumed(SessionCache *self, void *Py_UNUSED(closure)) {
+    std::lock_guard<std::mutex> guard(self->lock);
+    return PyLong_FromSsize_t(self->resumed);
+}
+
+static PyGetSetDef SessionCache_getset[] = {
+    {"hits", (getter)SessionCache_get_hits, NULL,
+     PyDoc_STR("apply() calls that found a session for the server"), NULL},
+    {"misses", (getter)SessionCache_get_misses, NULL,
+     PyDoc_STR("apply() calls that found none"), NULL},
+    {"resumed", (getter)SessionCache_get_resumed, NULL,
+     PyDoc_STR("Connections passed to store() whose handshake resumed a session"), NULL},
+    {NULL}
+};
+
+static PyMethodDef SessionCache_methods[] = {
+    {"apply", (PyCFunction)SessionCache_apply, METH_VARARGS,
+     PyDoc_STR("apply(ssl_socket, host, port)\n\nUse the cached session for this server, before the handshake.")},
+    {"store", (PyCFunction)SessionCache_store, METH_VARARGS,
+     PyDoc_STR("store(ssl_socket, host, port)\n\nKeep this connection's session, after the first read.")},
+    {"clear", (PyCFunction)SessionCache_clear, METH_NOARGS,
+     PyDoc_STR("clear()\n\nDrop every cached session.")},
+    {NULL}
+};
+
+static PySequenceMethods SessionCache_as_sequence = {
+    (lenfunc)SessionCache_len,              // sq_length
+};
+
+PyTypeObject SessionCacheType = {
+    PyVarObject_HEAD_INIT(nullptr, 0)
+    "sabctools.SessionCache",               // tp_name
+    sizeof(SessionCache),                   // tp_basicsize
+    0,                                      // tp_itemsize
+    (destructor)SessionCache_dealloc,       // tp_dealloc
+    0,                                      // tp_vectorcall_offset
+    nullptr,                                // tp_getattr
+    nullptr,                                // tp_setattr
+    nullptr,                                // tp_as_async
+    (reprfunc)SessionCache_repr,            // tp_repr
+    nullptr,                                // tp_as_number
+    &SessionCache_as_sequence,              // tp_as_sequence
+    nullptr,                                // tp_as_mapping
+    nullptr,                                // tp_hash
+    nullptr,                                // tp_call
+    nullptr,                                // tp_str
+    nullptr,                                // tp_getattro
+    nullptr,                                // tp_setattro
+    nullptr,                                // tp_as_buffer
+    Py_TPFLAGS_DEFAULT,                     // tp_flags
+    PyDoc_STR("SessionCache()"),            // tp_doc
+    nullptr,                                // tp_traverse
+    nullptr,                                // tp_clear
+    nullptr,                                // tp_richcompare
+    0,                                      // tp_weaklistoffset
+    nullptr,                                // tp_iter
+    nullptr,                                // tp_iternext
+    SessionCache_methods,                   // tp_methods
+    nullptr,                                // tp_members
+    SessionCache_getset,                    // tp_getset
+    nullptr,                                // tp_base
+    nullptr,                                // tp_dict
+    nullptr,                                // tp_descr_get
+    nullptr,                                // tp_descr_set
+    0,                                      // tp_dictoffset
+    nullptr,                                // tp_init
+    PyType_GenericAlloc,                    // tp_alloc
+    SessionCache_new,                       // tp_new
+};
+
+bool sessioncache_init(PyObject *m) {
+    if (PyType_Ready(&SessionCacheType) < 0) return false;
+    if (PyModule_AddType(m, &SessionCacheType) < 0) return false;
+    return true;
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright 2007-2026 The SABnzbd-Team (sabnzbd.org)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef SABCTOOLS_SESSIONCACHE_H
+#define SABCTOOLS_SESSIONCACHE_H
+
+#include <Python.h>
+
+#include <map>
+#include <mutex>
+#include <new>
+#include <string>
+#include <utility>
+
+/*
+ * TLS sessions to resume, one per server.
+ *
+ * When a provider drops every connection at once, all of them reconnect at once, and
+ * each full handshake costs the server's key exchange and a signature - on our side
+ * the certificate chain check as well. Resuming skips both. Python can do this one
+ * socket at a time through SSLSocket.session, but nothing shares a session between
+ * connections; this holds the newest resumable session for each (host, port) and
+ * hands it to every new connection to that server.
+ *
+ * The sessions are OpenSSL's own SSL_SESSION objects, reference counted by OpenSSL,
+ * reached through the symbols unlocked_ssl.cc resolves from Python's _ssl module, so
+ * they are exactly the objects Python's own sockets use.
+ */
+typedef struct {
+    PyObject_HEAD
+
+    // (host, port) to an SSL_SESSION reference owned by the cache
+    std::map<std::pair<std::string, int>, void *> sessions;
+    // Guards the map and the counters. The GIL already serialises callers today; this
+    // keeps the cache correct on a free-threaded build, where it does not.
+    std::mutex lock;
+    Py_ssize_t hits;
+    Py_ssize_t misses;
+    Py_ssize_t resumed;
+} SessionCache;
+
+extern PyTypeObject SessionCacheType;
+
+bool sessioncache_init(PyObject *);
+
+#endif // SABCTOOLS_SESSIONCACHE_H
@@ -0,0 +1,247 @@
+/*
+ * Copyright 2007-2026 The SABnzbd-Team (sabnzbd.org)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "statdecoder.h"
+#include "yenc.h"
+
+#include <cstdint>
+#include <cstring>
+
+/* Reply codes whose status line is followed by a body ending in "." */
+static bool is_multiline(int code) {
+    return code == NNTP_ARTICLE || code == NNTP_HEAD || code == NNTP_BODY;
+}
+
+/* Three digits, or -1 for a line that is not a status line at all */
+static int parse_code(const char *line, Py_ssize_t length) {
+    if (length < 3) return -1;
+    int code = 0;
+    for (int i = 0; i < 3; i++) {
+        if (line[i] < '0' || line[i] > '9') return -1;
+        code = code * 10 + (line[i] - '0');
+    }
+    return code;
+}
+
+static bool StatDecoder_record(StatDecoder *self, const char *line, Py_ssize_t length) {
+    if (self->received >= self->count) {
+        PyErr_Format(PyExc_ValueError, "more replies than the %zd requests since reset()", self->count);
+        return false;
+    }
+    const int code = parse_code(line, length);
+    reinterpret_cast<int16_t *>(PyByteArray_AS_STRING(self->codes))[self->received++] = static_cast<int16_t>(code);
+    self->in_body = is_multiline(code);
+    return true;
+}
+
+static int StatDecoder_init(StatDecoder *self, PyObject *args, PyObject *kwds) {
+    if (self->data) {
+        PyErr_SetString(PyExc_RuntimeError, "StatDecoder cannot be reinitialized");
+        return -1;
+    }
+
+    Py_ssize_t size;
+    if (!PyArg_ParseTuple(args, "n", &size)) return -1;
+    if (size < YENC_MIN_BUFFER_SIZE) size = YENC_MIN_BUFFER_SIZE;
+
+    self->data = static_cast<char *>(malloc(size));
+    if (!self->data) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    self->size = size;
+    return 0;
+}
+
+static void StatDecoder_dealloc(StatDecoder *self) {
+    free(self->data);
+    Py_XDECREF(self->codes);
+    Py_TYPE(self)->tp_free(reinterpret_cast<PyObject *>(self));
+}
+
+static int StatDecoder_getbuffer(StatDecoder *self, Py_buffer *view, int flags) {
+    return PyBuffer_FillInfo(view, reinterpret_cast<PyObject *>(self), self->data + self->position,
+                             self->size - self->position, 0, flags);
+}
+
+static PyBufferProcs StatDecoder_bufferprocs = {
+    (getbufferproc)StatDecoder_getbuffer,
+    nullptr,
+};
+
+/*
+ * Start a new batch of count requests.
+ *
+ * The codes array is replaced rather than cleared, so a memoryview of the previous
+ * batch stays valid and unchanged. Parsing state is kept: the byte stream does not
+ * restart just because the batch did, and a body still being skipped stays skipped.
+ */
+static PyObject *StatDecoder_reset(StatDecoder *self, PyObject *arg) {
+    Py_ssize_t count = PyLong_AsSsize_t(arg);
+    if (count == -1 && PyErr_Occurred()) return NULL;
+    if (count < 0) {
+        PyErr_SetString(PyExc_ValueError, "count is < 0");
+        return NULL;
+    }
+
+    PyObject *codes = PyByteArray_FromStringAndSize(NULL, count * static_cast<Py_ssize_t>(sizeof(int16_t)));
+    if (!codes) return NULL;
+    // 0 is never a reply code, so it marks a request that has not been answered yet
+    memset(PyByteArray_AS_STRING(codes), 0, count * sizeof(int16_t));
+
+    Py_XSETREF(self->codes, codes);
+    self->count = count;
+    self->received = 0;
+    Py_RETURN_NONE;
+}
+
+/*
+ * Parse length more bytes written into the exported buffer.
+ *
+ * Lines are split on LF, with a CR before it ignored. A line that fills the whole
+ * buffer without ending has its code taken from what is there and the rest dropped
+ * as it arrives; only body lines are that long in practice, and of those nothing but
+ * the terminating "." matters.
+ */
+static PyObject *StatDecoder_process(StatDecoder *self, PyObject *arg) {
+    Py_ssize_t length = PyLong_AsSsize_t(arg);
+    if (length == -1 && PyErr_Occurred()) return NULL;
+    if (length <= 0) {
+        PyErr_SetString(PyExc_ValueError, "length is <= 0");
+        return NULL;
+    }
+    if (self->position + length > self->size) {
+        PyErr_SetString(PyExc_ValueError, "length exceeds buffer size");
+        return NULL;
+    }
+    self->position += length;
+
+    bool ok = true;
+    Py_ssize_t start = 0;
+    while (start < self->position) {
+        const char *line = self->data + start;
+        const char *newline = static_cast<const char *>(memchr(line, '\n', self->position - start));
+        if (!newline) break;
+
+        Py_ssize_t line_length = newline - line;
+        if (line_length && line[line_length - 1] == '\r') line_length--;
+        start = newline - self->data + 1;
+
+        if (self->skipping_line) {
+            self->skipping_line = false;
+        } else if (self->in_body) {
+            if (line_length == 1 && line[0] == '.') self->in_body = false;
+        } else if (!StatDecoder_record(self, line, line_length)) {
+            ok = false;
+            break;
+        }
+    }
+
+    if (ok && start == 0 && self->position == self->size) {
+        if (!self->skipping_line && !self->in_body) {
+            ok = StatDecoder_record(self, self->data, self->position);
+        }
+        self->skipping_line = true;
+        start = self->position;
+    }
+
+    // Even after an error, so the lines already counted are not counted again
+    self->position -= start;
+    memmove(self->data, self->data + start, self->position);
+
+    if (!ok) return NULL;
+    Py_RETURN_NONE;
+}
+
+static PyObject *StatDecoder_get_codes(StatDecoder *self, void *Py_UNUSED(closure)) {
+    if (!self->codes) Py_RETURN_NONE;
+    PyObject *view = PyMemoryView_FromObject(self->codes);
+    if (!view) return NULL;
+    PyObject *cast = PyObject_CallMethod(view, "cast", "s", "h");
+    Py_DECREF(view);
+    return cast;
+}
+
+static PyMemberDef StatDecoder_members[] = {
+    {"count", T_PYSSIZET, offsetof(StatDecoder, count), READONLY, PyDoc_STR("Requests in the current batch")},
+    {"received", T_PYSSIZET, offsetof(StatDecoder, received), READONLY,
+     PyDoc_STR("Replies received for the current batch")},
+    {NULL}
+};
+
+static PyGetSetDef StatDecoder_getset[] = {
+    {"codes", (getter)StatDecoder_get_codes, NULL,
+     PyDoc_STR("Reply codes of the current batch in request order as int16; 0 until answered, -1 if unparseable"),
+     NULL},
+    {NULL}
+};
+
+static PyMethodDef StatDecoder_methods[] = {
+    {"reset", (PyCFunction)StatDecoder_reset, METH_O,
+     PyDoc_STR("reset(count)\n\nStart a batch of count requests.")},
+    {"process", (PyCFunction)StatDecoder_process, METH_O,
+     PyDoc_STR("process(length)\n\nParse length more bytes written into the buffer.")},
+    {NULL}
+};
+
+PyTypeObject StatDecoderType = {
+    PyVarObject_HEAD_INIT(nullptr, 0)
+    "sabctools.StatDecoder",                // tp_name
+    sizeof(StatDecoder),                    // tp_basicsize
+    0,                                      // tp_itemsize
+    (destructor)StatDecoder_dealloc,        // tp_dealloc
+    0,                                      // tp_vectorcall_offset
+    nullptr,                                // tp_getattr
+    nullptr,                                // tp_setattr
+    nullptr,                                // tp_as_async
+    nullptr,                                // tp_repr
+    nullptr,                                // tp_as_number
+    nullptr,                                // tp_as_sequence
+    nullptr,                                // tp_as_mapping
+    nullptr,                                // tp_hash
+    nullptr,                                // tp_call
+    nullptr,                                // tp_str
+    nullptr,                                // tp_getattro
+    nullptr,                                // tp_setattro
+    &StatDecoder_bufferprocs,               // tp_as_buffer
+    Py_TPFLAGS_DEFAULT,                     // tp_flags
+    PyDoc_STR("StatDecoder"),               // tp_doc
+    nullptr,                                // tp_traverse
+    nullptr,                                // tp_clear
+    nullptr,                                // tp_richcompare
+    0,                                      // tp_weaklistoffset
+    nullptr,                                // tp_iter
+    nullptr,                                // tp_iternext
+    StatDecoder_methods,                    // tp_methods
+    StatDecoder_members,                    // tp_members
+    StatDecoder_getset,                     // tp_getset
+    nullptr,                                // tp_base
+    nullptr,                                // tp_dict
+    nullptr,                                // tp_descr_get
+    nullptr,                                // tp_descr_set
+    0,                                      // tp_dictoffset
+    (initproc)StatDecoder_init,             // tp_init
+    PyType_GenericAlloc,                    // tp_alloc
+    PyType_GenericNew,                      // tp_new
+};
+
+bool statdecoder_init(PyObject *m) {
+    if (PyType_Ready(&StatDecoderType) < 0) return false;
+    if (PyModule_AddType(m, &StatDecoderType) < 0) return false;
+    return true;
+}
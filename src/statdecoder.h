@@ -0,0 +1,54 @@
+/*
+ * Copyright 2007-2026 The SABnzbd-Team (sabnzbd.org)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef SABCTOOLS_STATDECODER_H
+#define SABCTOOLS_STATDECODER_H
+
+#include <Python.h>
+
+/*
+ * Status codes of pipelined STAT (or HEAD) replies, without an object per reply.
+ *
+ * Checking availability sends thousands of STATs back to back, and going through the
+ * Decoder turns every 223 or 430 into an NNTPResponse that is looked at once for its
+ * code and thrown away. Here the codes go straight into an int16 array, slot n for
+ * the nth request since reset(), and the only Python objects are the ones the caller
+ * asks for.
+ *
+ * Fed the same way as the Decoder: fill the exported buffer, then process(length).
+ * The bodies of 220/221/222 replies are skipped, so HEAD and ARTICLE can be mixed in,
+ * but their content is not kept.
+ */
+typedef struct {
+    PyObject_HEAD
+
+    char *data;
+    Py_ssize_t size;
+    Py_ssize_t position; // bytes in data, from the front; lines are consumed from there
+    PyObject *codes;     // bytearray of count int16, or NULL before reset()
+    Py_ssize_t count;
+    Py_ssize_t received;
+    bool in_body;       // inside a multi-line reply, waiting for its "."
+    bool skipping_line; // the current line outgrew the buffer and is being dropped
+} StatDecoder;
+
+extern PyTypeObject StatDecoderType;
+
+bool statdecoder_init(PyObject *);
+
+#endif // SABCTOOLS_STATDECODER_H
@@ -25,12 +25,26 @@
 
 #include "unlocked_ssl.h"
 
+#include <unordered_set>
+
 static int (*SSL_read_ex)(void*, void*, size_t, size_t*) = NULL;
+static int (*SSL_write_ex)(void*, const void*, size_t, size_t*) = NULL;
 static int (*SSL_get_error)(void*, int) = NULL;
 static int (*SSL_get_shutdown)(void*) = NULL;
+// Memory BIO connections only; optional, so they do not count towards openssl_linked
+static void* (*SSL_get_rbio)(const void*) = NULL;
+static int (*BIO_write)(void*, const void*, int) = NULL;
+// Session resumption, likewise optional
+static void* (*SSL_get1_session)(void*) = NULL;
+static int (*SSL_set_session)(void*, void*) = NULL;
+static void (*SSL_SESSION_free)(void*) = NULL;
+static void* (*SSL_SESSION_dup)(const void*) = NULL;
+static int (*SSL_SESSION_is_resumable)(const void*) = NULL;
+static int (*SSL_session_reused)(const void*) = NULL;
 static PyObject *SSLWantReadError = NULL;
 static PyObject *SSLWantWriteError = NULL;
 static PyTypeObject *SSLSocketType = NULL;
+static PyTypeObject *SSLObjectType = NULL;
 
 typedef struct {
     int ssl; /* last seen error from SSL */
@@ -153,6 +167,9 @@ void openssl_init() {
     SSLSocketType = reinterpret_cast<PyTypeObject *>(PyObject_GetAttrString(ssl_module, "SSLSocket"));
     if(!SSLSocketType || !PyType_Check(SSLSocketType)) goto cleanup;
 
+    SSLObjectType = reinterpret_cast<PyTypeObject *>(PyObject_GetAttrString(ssl_module, "SSLObject"));
+    if(!SSLObjectType || !PyType_Check(SSLObjectType)) goto cleanup;
+
     SSLWantReadError = PyObject_GetAttrString(_ssl_module, "SSLWantReadError");
     if(!SSLWantReadError) goto cleanup;
 
@@ -169,8 +186,29 @@ void openssl_init() {
     if(!openssl_handle) goto cleanup;
 
     SSL_read_ex = reinterpret_cast<decltype(SSL_read_ex)>(GetProcAddress(openssl_handle, "SSL_read_ex"));
+    SSL_write_ex = reinterpret_cast<decltype(SSL_write_ex)>(GetProcAddress(openssl_handle, "SSL_write_ex"));
     SSL_get_error = reinterpret_cast<decltype(SSL_get_error)>(GetProcAddress(openssl_handle, "SSL_get_error"));
     SSL_get_shutdown = reinterpret_cast<decltype(SSL_get_shutdown)>(GetProcAddress(openssl_handle, "SSL_get_shutdown"));
+    SSL_get_rbio = reinterpret_cast<decltype(SSL_get_rbio)>(GetProcAddress(openssl_handle, "SSL_get_rbio"));
+    SSL_get1_session = reinterpret_cast<decltype(SSL_get1_session)>(GetProcAddress(openssl_handle, "SSL_get1_session"));
+    SSL_set_session = reinterpret_cast<decltype(SSL_set_session)>(GetProcAddress(openssl_handle, "SSL_set_session"));
+    SSL_SESSION_free = reinterpret_cast<decltype(SSL_SESSION_free)>(GetProcAddress(openssl_handle, "SSL_SESSION_free"));
+    SSL_SESSION_dup = reinterpret_cast<decltype(SSL_SESSION_dup)>(GetProcAddress(openssl_handle, "SSL_SESSION_dup"));
+    SSL_SESSION_is_resumable = reinterpret_cast<decltype(SSL_SESSION_is_resumable)>(GetProcAddress(openssl_handle, "SSL_SESSION_is_resumable"));
+    SSL_session_reused = reinterpret_cast<decltype(SSL_session_reused)>(GetProcAddress(openssl_handle, "SSL_session_reused"));
+
+    // BIO_write lives in libcrypto, which Windows keeps as a DLL of its own
+    {
+#ifdef _M_ARM64
+        HMODULE crypto_handle = GetModuleHandle(TEXT("libcrypto-3-arm64.dll"));
+#else
+        HMODULE crypto_handle = GetModuleHandle(TEXT("libcrypto-3.dll"));
+        if(!crypto_handle) crypto_handle = GetModuleHandle(TEXT("libcrypto-1_1.dll"));
+#endif
+        if(crypto_handle) {
+            BIO_write = reinterpret_cast<decltype(BIO_write)>(GetProcAddress(crypto_handle, "BIO_write"));
+        }
+    }
 #else
     // Find library at "import ssl; print(ssl._ssl.__file__)"
 
@@ -185,8 +223,18 @@ void openssl_init() {
     if(!openssl_handle) goto cleanup;
 
     *(void**)&SSL_read_ex = dlsym(openssl_handle, "SSL_read_ex");
+    *(void**)&SSL_write_ex = dlsym(openssl_handle, "SSL_write_ex");
     *(void**)&SSL_get_error = dlsym(openssl_handle, "SSL_get_error");
     *(void**)&SSL_get_shutdown = dlsym(openssl_handle, "SSL_get_shutdown");
+    // dlsym on a handle also searches what it depends on, which reaches libcrypto
+    *(void**)&SSL_get_rbio = dlsym(openssl_handle, "SSL_get_rbio");
+    *(void**)&BIO_write = dlsym(openssl_handle, "BIO_write");
+    *(void**)&SSL_get1_session = dlsym(openssl_handle, "SSL_get1_session");
+    *(void**)&SSL_set_session = dlsym(openssl_handle, "SSL_set_session");
+    *(void**)&SSL_SESSION_free = dlsym(openssl_handle, "SSL_SESSION_free");
+    *(void**)&SSL_SESSION_dup = dlsym(openssl_handle, "SSL_SESSION_dup");
+    *(void**)&SSL_SESSION_is_resumable = dlsym(openssl_handle, "SSL_SESSION_is_resumable");
+    *(void**)&SSL_session_reused = dlsym(openssl_handle, "SSL_session_reused");
 #endif
 
 cleanup:
@@ -197,15 +245,26 @@ cleanup:
         Py_CLEAR(SSLWantReadError);
         Py_CLEAR(SSLWantWriteError);
         Py_CLEAR(SSLSocketType);
+        Py_CLEAR(SSLObjectType);
         SSL_read_ex = NULL;
+        SSL_write_ex = NULL;
         SSL_get_error = NULL;
         SSL_get_shutdown = NULL;
+        SSL_get_rbio = NULL;
+        BIO_write = NULL;
+        SSL_get1_session = NULL;
+        SSL_set_session = NULL;
+        SSL_SESSION_free = NULL;
+        SSL_SESSION_dup = NULL;
+        SSL_SESSION_is_resumable = NULL;
+        SSL_session_reused = NULL;
         PyErr_Clear(); // linking is optional; any failure results in openssl_linked=False
     }
 }
 
 bool openssl_linked() {
     return SSL_read_ex &&
+        SSL_write_ex &&
         SSL_get_error &&
         SSL_get_shutdown &&
         SSLWantReadError &&
@@ -305,14 +364,43 @@ error:
     return NULL;
 }
 
+/*
+ * The _ssl object behind a non-blocking SSLSocket, as a new reference.
+ *
+ * Blocking sockets are refused because the GIL is dropped around the OpenSSL call:
+ * a blocking one would sit in it for as long as the peer likes, and Python's own
+ * timeout handling, which lives in the socket methods bypassed here, would not apply.
+ */
+static PyObject* get_nonblocking_sslobj(PyObject *ssl_socket) {
+    PyObject *Py_ssl_socket = PyObject_GetAttrString(ssl_socket, "_sslobj");
+    if (!Py_ssl_socket || Py_IsNone(Py_ssl_socket)) {
+        PyErr_Clear();
+        PyErr_SetString(PyExc_ValueError, "Could not find _sslobj attribute");
+        Py_XDECREF(Py_ssl_socket);
+        return NULL;
+    }
+
+    PyObject *blocking = PyObject_CallMethod(ssl_socket, "getblocking", NULL);
+    if (!blocking) {
+        Py_DECREF(Py_ssl_socket);
+        return NULL;
+    }
+    int is_blocking = PyObject_IsTrue(blocking);
+    Py_DECREF(blocking);
+    if (is_blocking) {
+        if (is_blocking > 0) PyErr_SetString(PyExc_ValueError, "Only non-blocking sockets are supported");
+        Py_DECREF(Py_ssl_socket);
+        return NULL;
+    }
+    return Py_ssl_socket;
+}
+
 PyObject* unlocked_ssl_recv_into(PyObject* self, PyObject* args) {
     PyObject *ssl_socket;
     PyObject *Py_ssl_socket;
     Py_ssize_t len;
     Py_buffer Py_buffer;
     PyObject *retval = NULL;
-    PyObject *blocking = NULL;
-    int is_blocking;
 
     if(!openssl_linked()) {
         PyErr_SetString(PyExc_OSError, "Failed to link with OpenSSL");
@@ -324,22 +412,9 @@ PyObject* unlocked_ssl_recv_into(PyObject* self, PyObject* args) {
         return NULL;
     }
 
-    Py_ssl_socket = PyObject_GetAttrString(ssl_socket, "_sslobj");
-    if (!Py_ssl_socket || Py_IsNone(Py_ssl_socket)) {
-        PyErr_SetString(PyExc_ValueError, "Could not find _sslobj attribute");
+    Py_ssl_socket = get_nonblocking_sslobj(ssl_socket);
+    if (!Py_ssl_socket)
         goto error;
-    }
-
-    blocking = PyObject_CallMethod(ssl_socket, "getblocking", NULL);
-    if (!blocking)
-        goto error; // call failed
-    is_blocking = PyObject_IsTrue(blocking);
-    if (is_blocking < 0)
-        goto error;
-    if (is_blocking) {
-        PyErr_SetString(PyExc_ValueError, "Only non-blocking sockets are supported");
-        goto error;
-    }
 
     // Basic sanity check
     len = (Py_ssize_t)Py_buffer.len;
@@ -353,6 +428,305 @@ PyObject* unlocked_ssl_recv_into(PyObject* self, PyObject* args) {
 error:
     PyBuffer_Release(&Py_buffer);
     Py_XDECREF(Py_ssl_socket);
-    Py_XDECREF(blocking);
     return retval;
 }
+
+/*
+ * SSL_write_ex with the GIL released, for sending large buffers without a copy.
+ *
+ * Python's SSLSocket.send goes through the same OpenSSL call, but only after taking a
+ * Python-level bytes-like view and holding the socket's lock; for posting, where
+ * every article is several hundred KB of freshly encoded output, the copy is the
+ * cost that matters.
+ *
+ * Python does not enable SSL_MODE_ENABLE_PARTIAL_WRITE, so a write either goes out
+ * whole or fails with WANT_WRITE having committed nothing the caller can see; the
+ * retry must then pass the same data again, which SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER
+ * (which Python does set) allows from a different address. The loop still adds up
+ * short writes in case partial mode is ever enabled on the connection.
+ */
+static PyObject* unlocked_ssl_send_impl(PySSLSocket *self, Py_buffer *buffer) {
+    const char *mem = (const char *)buffer->buf;
+    size_t len = (size_t)buffer->len;
+    size_t count = 0;
+    size_t written = 0;
+    int retval;
+    _PySSLError err;
+
+    PySocketSockObject *sock = NULL;
+    if (get_socket(self, &sock) < 0) {
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS;
+    do {
+        retval = SSL_write_ex(self->ssl, mem + count, len - count, &written);
+        if (retval <= 0) {
+            break;
+        }
+        count += written;
+    } while (count < len);
+    err = _PySSL_errno(retval == 0, self->ssl, retval);
+    Py_END_ALLOW_THREADS;
+#if PY_VERSION_HEX < SABCTOOLS_PY_HEX(3, 15)
+    self->err = err;
+#endif
+    Py_XDECREF(sock);
+
+    if (count > 0) {
+        return PyLong_FromSize_t(count);
+    }
+
+    if (err.ssl == SSL_ERROR_WANT_WRITE) {
+        PyErr_SetString(SSLWantWriteError, "The operation did not complete (write)");
+    } else if (err.ssl == SSL_ERROR_WANT_READ) {
+        // Renegotiation, or a TLS 1.3 key update, needs to read before it can write
+        PyErr_SetString(SSLWantReadError, "The operation did not complete (read)");
+    } else {
+        PyErr_SetString(PyExc_ConnectionAbortedError, "Failed to send data");
+    }
+    return NULL;
+}
+
+PyObject* unlocked_ssl_send(PyObject* self, PyObject* args) {
+    PyObject *ssl_socket;
+    PyObject *Py_ssl_socket;
+    Py_buffer Py_buffer;
+    PyObject *retval = NULL;
+
+    if(!openssl_linked()) {
+        PyErr_SetString(PyExc_OSError, "Failed to link with OpenSSL");
+        return NULL;
+    }
+
+    if (!PyArg_ParseTuple(args, "O!y*:unlocked_ssl_send", SSLSocketType, &ssl_socket, &Py_buffer)) {
+        return NULL;
+    }
+
+    Py_ssl_socket = get_nonblocking_sslobj(ssl_socket);
+    if (!Py_ssl_socket)
+        goto error;
+
+    if (Py_buffer.len == 0) {
+        retval = PyLong_FromLong(0);
+        goto error;
+    }
+
+    retval = unlocked_ssl_send_impl((PySSLSocket*)Py_ssl_socket, &Py_buffer);
+
+error:
+    PyBuffer_Release(&Py_buffer);
+    Py_XDECREF(Py_ssl_socket);
+    return retval;
+}
+
+/*
+ * Decrypt TLS records that arrived on a memory BIO connection, with the GIL released.
+ *
+ * For an ssl.SSLObject made with wrap_bio(): the ciphertext the caller received from
+ * the raw socket goes into the incoming BIO and SSL_read_ex decrypts from it into any
+ * writable buffer, a Decoder included, all in one stretch without the GIL. Where
+ * unlocked_ssl_recv_into decrypts on whichever thread reads the socket, this lets the
+ * reading and the decrypting happen on different threads, so a pool of threads
+ * calling it spreads the AES work of many connections over as many cores - the pool
+ * the caller already has, rather than one of our own whose threads would have to hand
+ * results back through the GIL anyway.
+ *
+ * The whole of ciphertext is always taken: a memory BIO grows as needed. Plaintext
+ * that did not fit in buffer stays inside OpenSSL, and a call with empty ciphertext
+ * collects it. Anything OpenSSL has to send in response - a TLS 1.3 key update, for
+ * one - lands in the outgoing BIO, which the caller has to keep flushing to the socket
+ * as it would for SSLObject.read().
+ *
+ * One SSLObject is one TLS stream, so only one thread may decrypt it at a time: two
+ * pool threads feeding the same BIO would interleave records and corrupt it. Nothing
+ * in OpenSSL stops that, so the objects being decrypted are kept in a set, only
+ * touched while holding the GIL, and a second caller gets a RuntimeError.
+ */
+static std::unordered_set<void *> decrypting;
+
+static PyObject* unlocked_ssl_decrypt_into_impl(PySSLSocket *self, Py_buffer *ciphertext, Py_buffer *buffer) {
+    const char *input = (const char *)ciphertext->buf;
+    Py_ssize_t remaining = ciphertext->len;
+    char *mem = (char *)buffer->buf;
+    size_t len = (size_t)buffer->len;
+    size_t count = 0;
+    size_t readbytes = 0;
+    int retval = 1;
+    bool fed = true;
+    _PySSLError err = { 0 };
+
+    Py_BEGIN_ALLOW_THREADS;
+    void *rbio = SSL_get_rbio(self->ssl);
+    while (remaining > 0) {
+        const int chunk = remaining > INT_MAX ? INT_MAX : (int)remaining;
+        const int written = BIO_write(rbio, input, chunk);
+        if (written <= 0) {
+            fed = false;
+            break;
+        }
+        input += written;
+        remaining -= written;
+    }
+    if (fed) {
+        while (count < len) {
+            retval = SSL_read_ex(self->ssl, mem + count, len - count, &readbytes);
+            if (retval <= 0) {
+                break;
+            }
+            count += readbytes;
+        }
+        err = _PySSL_errno(retval == 0, self->ssl, retval);
+    }
+    Py_END_ALLOW_THREADS;
+#if PY_VERSION_HEX < SABCTOOLS_PY_HEX(3, 15)
+    self->err = err;
+#endif
+
+    if (!fed) {
+        PyErr_SetString(PyExc_MemoryError, "Failed to queue ciphertext");
+        return NULL;
+    }
+
+    if (count > 0) {
+        return PyLong_FromSize_t(count);
+    }
+
+    if (err.ssl == SSL_ERROR_WANT_READ) {
+        PyErr_SetString(SSLWantReadError, "The operation did not complete (read)");
+    } else if (err.ssl == SSL_ERROR_WANT_WRITE) {
+        PyErr_SetString(SSLWantWriteError, "The operation did not complete (write)");
+    } else if (err.ssl == SSL_ERROR_ZERO_RETURN && SSL_get_shutdown(self->ssl) == SSL_RECEIVED_SHUTDOWN) {
+        return PyLong_FromLong(0);
+    } else {
+        PyErr_SetString(PyExc_ConnectionAbortedError, "Failed to read data");
+    }
+    return NULL;
+}
+
+PyObject* unlocked_ssl_decrypt_into(PyObject* self, PyObject* args) {
+    PyObject *ssl_object;
+    PyObject *Py_ssl_object = NULL;
+    Py_buffer Py_ciphertext;
+    Py_buffer Py_buffer;
+    PyObject *retval = NULL;
+
+    if(!openssl_linked() || !SSLObjectType || !SSL_get_rbio || !BIO_write) {
+        PyErr_SetString(PyExc_OSError, "Failed to link with OpenSSL");
+        return NULL;
+    }
+
+    if (!PyArg_ParseTuple(args, "O!y*w*:unlocked_ssl_decrypt_into", SSLObjectType, &ssl_object, &Py_ciphertext, &Py_buffer)) {
+        return NULL;
+    }
+
+    Py_ssl_object = PyObject_GetAttrString(ssl_object, "_sslobj");
+    if (!Py_ssl_object || Py_IsNone(Py_ssl_object)) {
+        PyErr_Clear();
+        PyErr_SetString(PyExc_ValueError, "Could not find _sslobj attribute");
+        goto error;
+    }
+
+    if (Py_buffer.len <= 0) {
+        PyErr_SetString(PyExc_ValueError, "No space left in buffer");
+        goto error;
+    }
+
+    if (!decrypting.insert(((PySSLSocket*)Py_ssl_object)->ssl).second) {
+        PyErr_SetString(PyExc_RuntimeError, "SSLObject is being decrypted by another thread");
+        goto error;
+    }
+    retval = unlocked_ssl_decrypt_into_impl((PySSLSocket*)Py_ssl_object, &Py_ciphertext, &Py_buffer);
+    decrypting.erase(((PySSLSocket*)Py_ssl_object)->ssl);
+
+error:
+    PyBuffer_Release(&Py_ciphertext);
+    PyBuffer_Release(&Py_buffer);
+    Py_XDECREF(Py_ssl_object);
+    return retval;
+}
+
+bool openssl_sessions_linked() {
+    return openssl_linked() &&
+        SSLObjectType &&
+        SSL_get1_session &&
+        SSL_set_session &&
+        SSL_SESSION_free &&
+        SSL_SESSION_dup &&
+        SSL_SESSION_is_resumable &&
+        SSL_session_reused;
+}
+
+void* openssl_get_ssl(PyObject *ssl_socket, PyObject **owner) {
+    if (!PyObject_TypeCheck(ssl_socket, SSLSocketType) && !PyObject_TypeCheck(ssl_socket, SSLObjectType)) {
+        PyErr_Format(PyExc_TypeError, "expected SSLSocket or SSLObject, not %s", Py_TYPE(ssl_socket)->tp_name);
+        return NULL;
+    }
+    PyObject *Py_ssl_socket = PyObject_GetAttrString(ssl_socket, "_sslobj");
+    if (!Py_ssl_socket || Py_IsNone(Py_ssl_socket)) {
+        PyErr_Clear();
+        PyErr_SetString(PyExc_ValueError, "Could not find _sslobj attribute");
+        Py_XDECREF(Py_ssl_socket);
+        return NULL;
+    }
+    *owner = Py_ssl_socket;
+    return ((PySSLSocket *)Py_ssl_socket)->ssl;
+}
+
+void* openssl_get1_session(void *ssl) {
+    return SSL_get1_session(ssl);
+}
+
+bool openssl_set_session(void *ssl, void *session) {
+    return SSL_set_session(ssl, session) == 1;
+}
+
+bool openssl_session_reused(void *ssl) {
+    return SSL_session_reused(ssl) == 1;
+}
+
+bool openssl_session_resumable(void *session) {
+    return SSL_SESSION_is_resumable(session) == 1;
+}
+
+void openssl_session_free(void *session) {
+    SSL_SESSION_free(session);
+}
+
+void* openssl_session_dup(void *session) {
+    return SSL_SESSION_dup(session);
+}
+
+bool unlocked_ssl_is_ssl_socket(PyObject *sock) {
+    return SSLSocketType && PyObject_TypeCheck(sock, SSLSocketType);
+}
+
+/* SSLWant*Error into UNLOCKED_SSL_WOULD_BLOCK, any other exception into -1 */
+static Py_ssize_t unlocked_ssl_result(PyObject *result) {
+    if (result) {
+        const Py_ssize_t count = PyLong_AsSsize_t(result);
+        Py_DECREF(result);
+        return count;
+    }
+    if (PyErr_ExceptionMatches(SSLWantReadError) || PyErr_ExceptionMatches(SSLWantWriteError)) {
+        PyErr_Clear();
+        return UNLOCKED_SSL_WOULD_BLOCK;
+    }
+    return -1;
+}
+
+PyObject* unlocked_ssl_nonblocking_sslobj(PyObject *ssl_socket) {
+    return get_nonblocking_sslobj(ssl_socket);
+}
+
+Py_ssize_t unlocked_ssl_recv_raw(PyObject *sslobj, char *buf, Py_ssize_t len) {
+    Py_buffer buffer;
+    if (PyBuffer_FillInfo(&buffer, NULL, buf, len, 0, PyBUF_WRITABLE) < 0) return -1;
+    return unlocked_ssl_result(unlocked_ssl_recv_into_impl((PySSLSocket *)sslobj, len, &buffer));
+}
+
+Py_ssize_t unlocked_ssl_send_raw(PyObject *sslobj, const char *buf, Py_ssize_t len) {
+    Py_buffer buffer;
+    if (PyBuffer_FillInfo(&buffer, NULL, const_cast<char *>(buf), len, 1, PyBUF_SIMPLE) < 0) return -1;
+    return unlocked_ssl_result(unlocked_ssl_send_impl((PySSLSocket *)sslobj, &buffer));
+}
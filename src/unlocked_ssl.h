@@ -25,6 +25,7 @@
 #include <stdio.h>
 #include <fcntl.h>
 #include <string.h>
+#include <limits.h>
 
 /* OpenSSL link */
 #if defined(_WIN32) || defined(__CYGWIN__)
@@ -53,6 +54,39 @@ extern "C" {
 void openssl_init();
 bool openssl_linked();
 PyObject *unlocked_ssl_recv_into(PyObject *, PyObject*);
+PyObject *unlocked_ssl_send(PyObject *, PyObject*);
+PyObject *unlocked_ssl_decrypt_into(PyObject *, PyObject*);
+
+/*
+ * The unlocked recv/send on a raw pointer, for the NNTPConnection engine. The _ssl
+ * object behind the SSLSocket is looked up once, by unlocked_ssl_nonblocking_sslobj,
+ * which returns a new reference or NULL with an exception set; after that each call
+ * goes straight to OpenSSL. Both return a byte count, UNLOCKED_SSL_WOULD_BLOCK when
+ * OpenSSL wants the socket to become readable or writable first, or -1 with an
+ * exception set.
+ */
+#define UNLOCKED_SSL_WOULD_BLOCK (-2)
+bool unlocked_ssl_is_ssl_socket(PyObject *sock);
+PyObject *unlocked_ssl_nonblocking_sslobj(PyObject *ssl_socket);
+Py_ssize_t unlocked_ssl_recv_raw(PyObject *sslobj, char *buf, Py_ssize_t len);
+Py_ssize_t unlocked_ssl_send_raw(PyObject *sslobj, const char *buf, Py_ssize_t len);
+
+/*
+ * Session resumption, for the SessionCache; only usable when openssl_sessions_linked().
+ * Connections are SSL* and sessions SSL_SESSION*, both opaque here.
+ */
+bool openssl_sessions_linked();
+// The SSL* behind an SSLSocket or SSLObject, kept alive by the new reference left in
+// owner. NULL with an exception set if there is none.
+void *openssl_get_ssl(PyObject *ssl_socket, PyObject **owner);
+// A session reference the caller frees, or NULL if the connection has none
+void *openssl_get1_session(void *ssl);
+bool openssl_set_session(void *ssl, void *session);
+bool openssl_session_reused(void *ssl);
+bool openssl_session_resumable(void *session);
+void openssl_session_free(void *session);
+// An independent copy, or NULL when out of memory
+void *openssl_session_dup(void *session);
 
 #ifdef __cplusplus
 }
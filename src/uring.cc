@@ -0,0 +1,238 @@
+/*
+ * Copyright 2007-2026 The SABnzbd-Team (sabnzbd.org)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "uring.h"
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+// The probe for IORING_OP_WRITE arrived in the same release (5.6) as this flag, so its
+// presence says the headers know everything used below
+#ifdef IORING_FEAT_RW_CUR_POS
+#define SABCTOOLS_HAVE_URING 1
+#endif
+#endif
+#endif
+
+#ifdef SABCTOOLS_HAVE_URING
+
+#include <errno.h>
+#include <mutex>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/*
+ * Submission entries are handed to the kernel as soon as they are queued, so the
+ * submission queue only has to absorb the writes queued between two io_uring_enter
+ * calls. The completion queue has to hold every write in flight at once - one per
+ * streaming connection - and is sized well past any connection count SABnzbd allows.
+ * The kernel keeps any overflow rather than dropping it (IORING_FEAT_NODROP).
+ */
+#define URING_SQ_ENTRIES 256
+#define URING_CQ_ENTRIES 4096
+
+/* The result field of a completion is an int, so longer writes do not fit */
+#define URING_MAX_WRITE ((size_t)0x3FFFF000)
+
+namespace {
+
+struct Ring {
+    int fd = -1;
+    unsigned sq_entries = 0;
+    unsigned *sq_head = nullptr;
+    unsigned *sq_tail = nullptr;
+    unsigned *sq_mask = nullptr;
+    unsigned *sq_array = nullptr;
+    struct io_uring_sqe *sqes = nullptr;
+    unsigned *cq_head = nullptr;
+    unsigned *cq_tail = nullptr;
+    unsigned *cq_mask = nullptr;
+    struct io_uring_cqe *cqes = nullptr;
+    // One thread fills the submission queue at a time, and one drains the completion
+    // queue; the two sides do not need each other's lock
+    std::mutex submit_lock;
+    std::mutex reap_lock;
+};
+
+Ring ring;
+std::once_flag ring_once;
+
+int ring_enter(unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return (int)syscall(__NR_io_uring_enter, ring.fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+bool ring_can_write(int fd) {
+    const size_t size = sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op);
+    struct io_uring_probe *probe = (struct io_uring_probe *)calloc(1, size);
+    if (!probe) return false;
+    bool supported = syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, 256) == 0 &&
+                     probe->last_op >= IORING_OP_WRITE &&
+                     (probe->ops[IORING_OP_WRITE].flags & IO_URING_OP_SUPPORTED);
+    free(probe);
+    return supported;
+}
+
+void ring_setup() {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = URING_CQ_ENTRIES;
+
+    int fd = (int)syscall(__NR_io_uring_setup, URING_SQ_ENTRIES, &params);
+    if (fd < 0) return;
+
+    // Without NODROP a completion that finds the queue full is lost, and with it the
+    // thread waiting for it
+    if (!(params.features & IORING_FEAT_NODROP) || !(params.features & IORING_FEAT_SINGLE_MMAP) ||
+        !ring_can_write(fd)) {
+        close(fd);
+        return;
+    }
+
+    size_t rings_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    const size_t cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (cq_size > rings_size) rings_size = cq_size;
+    const size_t sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    void *rings = mmap(NULL, rings_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (rings == MAP_FAILED) {
+        close(fd);
+        return;
+    }
+    void *sqes = mmap(NULL, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        munmap(rings, rings_size);
+        close(fd);
+        return;
+    }
+
+    // Never unmapped: the ring lives as long as the process
+    char *base = (char *)rings;
+    ring.sq_entries = params.sq_entries;
+    ring.sq_head = (unsigned *)(base + params.sq_off.head);
+    ring.sq_tail = (unsigned *)(base + params.sq_off.tail);
+    ring.sq_mask = (unsigned *)(base + params.sq_off.ring_mask);
+    ring.sq_array = (unsigned *)(base + params.sq_off.array);
+    ring.sqes = (struct io_uring_sqe *)sqes;
+    ring.cq_head = (unsigned *)(base + params.cq_off.head);
+    ring.cq_tail = (unsigned *)(base + params.cq_off.tail);
+    ring.cq_mask = (unsigned *)(base + params.cq_off.ring_mask);
+    ring.cqes = (struct io_uring_cqe *)(base + params.cq_off.cqes);
+    ring.fd = fd;
+}
+
+/* Record every completion the kernel has posted. Called with reap_lock held. */
+void ring_reap() {
+    unsigned head = *ring.cq_head;
+    const unsigned tail = __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE);
+    while (head != tail) {
+        const struct io_uring_cqe *cqe = &ring.cqes[head & *ring.cq_mask];
+        UringWrite *op = (UringWrite *)(uintptr_t)cqe->user_data;
+        // Read before done is set: from then on op belongs to its owner again, and may
+        // be reused or freed
+        std::atomic<long> *pending = op->pending;
+        op->result = cqe->res;
+        if (pending) pending->fetch_sub(1, std::memory_order_release);
+        op->done.store(true, std::memory_order_release);
+        head++;
+    }
+    __atomic_store_n(ring.cq_head, head, __ATOMIC_RELEASE);
+}
+
+/* Reap, sleeping in the kernel for more completions, until ready() holds */
+template <typename Ready>
+void ring_wait(Ready ready) {
+    while (!ready()) {
+        std::lock_guard<std::mutex> guard(ring.reap_lock);
+        ring_reap();
+        if (ready()) return;
+        // Also submits whatever a failed enter left queued, so it cannot wait forever
+        const unsigned unsubmitted =
+            __atomic_load_n(ring.sq_tail, __ATOMIC_ACQUIRE) - __atomic_load_n(ring.sq_head, __ATOMIC_ACQUIRE);
+        ring_enter(unsubmitted, 1, IORING_ENTER_GETEVENTS);
+        ring_reap();
+    }
+}
+
+} // namespace
+
+bool uring_available() {
+    std::call_once(ring_once, ring_setup);
+    return ring.fd >= 0;
+}
+
+bool uring_submit_write(UringWrite *op, int fd, const void *buffer, size_t length, long long offset) {
+    if (length > URING_MAX_WRITE || !uring_available()) return false;
+
+    std::lock_guard<std::mutex> guard(ring.submit_lock);
+    const unsigned tail = *ring.sq_tail;
+    const unsigned head = __atomic_load_n(ring.sq_head, __ATOMIC_ACQUIRE);
+    if (tail - head >= ring.sq_entries) return false;
+
+    const unsigned index = tail & *ring.sq_mask;
+    struct io_uring_sqe *sqe = &ring.sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_WRITE;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t)(uintptr_t)buffer;
+    sqe->len = (uint32_t)length;
+    sqe->off = (uint64_t)offset;
+    sqe->user_data = (uint64_t)(uintptr_t)op;
+    ring.sq_array[index] = index;
+
+    op->result = 0;
+    op->done.store(false, std::memory_order_relaxed);
+    if (op->pending) op->pending->fetch_add(1, std::memory_order_relaxed);
+    __atomic_store_n(ring.sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+    // Once published the entry is committed, whatever enter says: one that failed here
+    // stays queued and goes with the next enter, from a submitter or a waiter
+    int result;
+    do {
+        result = ring_enter(tail + 1 - head, 0, 0);
+    } while (result < 0 && errno == EINTR);
+    return true;
+}
+
+void uring_wait(UringWrite *op) {
+    ring_wait([op] { return op->done.load(std::memory_order_acquire); });
+}
+
+void uring_drain(std::atomic<long> *pending) {
+    ring_wait([pending] { return pending->load(std::memory_order_acquire) == 0; });
+}
+
+#else
+
+bool uring_available() {
+    return false;
+}
+
+bool uring_submit_write(UringWrite *, int, const void *, size_t, long long) {
+    return false;
+}
+
+void uring_wait(UringWrite *) {}
+
+void uring_drain(std::atomic<long> *) {}
+
+#endif
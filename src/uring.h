@@ -0,0 +1,62 @@
+/*
+ * Copyright 2007-2026 The SABnzbd-Team (sabnzbd.org)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef SABCTOOLS_URING_H
+#define SABCTOOLS_URING_H
+
+#include <atomic>
+#include <cstddef>
+
+/*
+ * A process-wide io_uring for positional file writes, Linux only.
+ *
+ * One ring serves every FileWriter that asks for it. Submitting a write costs one
+ * io_uring_enter that does not wait for the data to land: a write the page cache can
+ * take at once completes inline, one that would block is handed to a kernel worker.
+ * Completions are reaped from the shared completion queue without a syscall, by
+ * whichever thread next looks, and recorded in the UringWrite they belong to - so a
+ * thread waiting on its own write settles everyone else's along the way.
+ *
+ * Nothing here needs the GIL. Where the ring cannot be had - another platform, an
+ * older kernel, a seccomp profile that refuses io_uring_setup - uring_available() says
+ * so once, and callers keep to pwrite.
+ */
+
+typedef struct {
+    // Bytes written, or -errno. Only meaningful once done is set.
+    int result;
+    // Decremented when the write completes, before done is set, so whoever counts
+    // writes in flight sees them drain without waiting on each one
+    std::atomic<long> *pending;
+    std::atomic<bool> done;
+} UringWrite;
+
+/* Set up the ring on first use. False where it cannot be had, after which it never is. */
+bool uring_available();
+
+/* Queue a write of length bytes (at most 2 GB) at offset. False if the ring refused it,
+   in which case op is untouched and pending was not counted; write it synchronously. */
+bool uring_submit_write(UringWrite *op, int fd, const void *buffer, size_t length, long long offset);
+
+/* Block until op has completed */
+void uring_wait(UringWrite *op);
+
+/* Block until *pending, as counted by the writes that carry it, drops to zero */
+void uring_drain(std::atomic<long> *pending);
+
+#endif // SABCTOOLS_URING_H
@@ -19,9 +19,26 @@
 #include "yenc.h"
 #include "filewriter.h"
 #include "unlocked_ssl.h"
+#include "inflate.h"
+#include "overview.h"
 
 #include "rapidyenc/rapidyenc.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SABCTOOLS_UU_SSE2
+#elif defined(__ARM_NEON) || defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define SABCTOOLS_UU_NEON
+#endif
+
+/* A UU post is rarely fewer lines than this, so the first allocation usually suffices */
+#define UU_LINES_ESTIMATE 4096
+/* Bytes uu_decode_groups may store past the end of what it decodes */
+#define UU_STORE_SLACK 8
+/* The most one line can decode to, whatever its length: 85 bytes with the workaround, rounded up to a group */
+#define UU_MAX_LINE_BYTES 87
+
 /* Global objects */
 
 static PyObject* ENCODING_FORMAT_YENC = nullptr;
@@ -178,7 +195,7 @@ std::optional<uint32_t> parse_crc32(std::string_view crc32) {
  * 
  * Note: Clears Python errors internally when decoding fails.
  */
-static PyObject* decode_utf8_with_fallback(std::string_view line) {
+PyObject* decode_utf8_with_fallback(std::string_view line) {
     auto try_decode = [&](auto decoder, const char* errors = nullptr) -> PyObject* {
         PyObject* result = decoder(line.data(), line.size(), errors);
         if (!result) PyErr_Clear();
@@ -458,6 +475,7 @@ static int NNTPResponse_traverse(NNTPResponse* self, visitproc visit, void* arg)
     Py_VISIT(self->format);
     Py_VISIT(self->file_name);
     Py_VISIT(self->message);
+    Py_VISIT(self->overview);
     return 0;
 }
 
@@ -471,6 +489,7 @@ static int NNTPResponse_clear(NNTPResponse* self)
     Py_CLEAR(self->format);
     Py_CLEAR(self->file_name);
     Py_CLEAR(self->message);
+    Py_CLEAR(self->overview);
     return 0;
 }
 
@@ -485,6 +504,8 @@ static void NNTPResponse_dealloc(NNTPResponse* self)
     Py_XDECREF(self->format);
     Py_XDECREF(self->file_name);
     Py_XDECREF(self->message);
+    Py_XDECREF(self->overview);
+    delete self->overview_columns;
     Py_TYPE(self)->tp_free((PyObject*)self);
 }
 
@@ -603,6 +624,23 @@ static PyObject* NNTPResponse_get_format(NNTPResponse* self, void *closure)
     return self->format;
 }
 
+/**
+ * Property getter for the 'overview' attribute. The parsed columns of an
+ * OVER/XOVER/XZVER response.
+ *
+ * @param self The NNTPResponse instance
+ * @param closure Unused closure parameter
+ * @return Overview object, or None for any other response
+ */
+static PyObject* NNTPResponse_get_overview(NNTPResponse* self, void *closure)
+{
+    if (self->overview == NULL) {
+        Py_RETURN_NONE;
+    }
+    Py_INCREF(self->overview);
+    return self->overview;
+}
+
 /**
  * Decode yEnc-encoded body data in streaming fashion.
  * This is the core decoding function that processes encoded data incrementally.
@@ -626,14 +664,93 @@ static PyObject* NNTPResponse_get_format(NNTPResponse* self, void *closure)
  * - Detects end conditions (control line, article terminator) and adjusts read position
  * - Releases GIL during decoding for parallel processing
  */
+/*
+ * Record a failed write on the response it belongs to.
+ *
+ * Not an error for the connection, and it must not be raised here.
+ *
+ * The obvious handling - raise and let the caller deal with it - abandons the decoder
+ * in the middle of a response. The remainder of the article is still in the
+ * connection's buffer and would then be parsed as the start of the next one, so a
+ * failed write would cost the whole connection rather than one article. That also puts
+ * it out of reach of the Python caller, since by the time the exception surfaces the
+ * damage is done.
+ *
+ * So the response is consumed to its end with the body discarded, and the failure is
+ * reported to Python as sink_failed once the response completes. The article is lost
+ * either way and has to be fetched again; the connection does not have to be.
+ */
+static void NNTPResponse_fail_sink(NNTPResponse *instance, FileWriter *writer, bool was_closed,
+                                   unsigned long error_code) {
+    instance->sink_failed = true;
+
+    // Build the error but hold it rather than raising: the caller needs to know whether
+    // this was a full disk or a file that was closed underneath us, and those want
+    // opposite handling. Requires the GIL.
+    if (!instance->sink_error) {
+        filewriter_raise(writer, was_closed, error_code);
+#if PY_VERSION_HEX >= SABCTOOLS_PY_HEX(3, 12)
+        instance->sink_error = PyErr_GetRaisedException();
+#else
+        PyObject *error_type = NULL, *error_value = NULL, *error_traceback = NULL;
+        PyErr_Fetch(&error_type, &error_value, &error_traceback);
+        PyErr_NormalizeException(&error_type, &error_value, &error_traceback);
+        Py_XDECREF(error_type);
+        Py_XDECREF(error_traceback);
+        instance->sink_error = error_value;
+#endif
+    }
+}
+
+/*
+ * Wait for the write submitted to io_uring, if there is one, and settle its response.
+ *
+ * Called before the spare buffer it writes from is needed again, and before the
+ * response it belongs to is delivered, so sink_failed is final by the time Python
+ * sees it. A short write, which the ring may return like pwrite can, is finished
+ * synchronously.
+ */
+static void Decoder_settle_write(Decoder *owner) {
+    NNTPResponse *instance = owner->write_response;
+    if (!instance) return;
+
+    FileWriter *writer = reinterpret_cast<FileWriter *>(instance->sink);
+    bool was_closed = false;
+    unsigned long error_code = 0;
+
+    Py_BEGIN_ALLOW_THREADS;
+    uring_wait(&owner->write);
+    const int result = owner->write.result;
+    if (result < 0) {
+        error_code = static_cast<unsigned long>(-result);
+    } else if (result < owner->write_length) {
+        filewriter_write_raw(writer, owner->staging_spare + result, owner->write_length - result,
+                             owner->write_offset + result, &was_closed, &error_code);
+    } else {
+        filewriter_written(writer, owner->write_offset, owner->write_length);
+    }
+    Py_END_ALLOW_THREADS;
+
+    owner->write_response = nullptr;
+    if (was_closed || error_code) NNTPResponse_fail_sink(instance, writer, was_closed, error_code);
+    Py_DECREF(instance);
+}
+
 /*
  * Hand the staged bytes to the sink and start the buffer over.
  *
  * The write runs with the GIL released, so nothing here touches the Python API until
  * the error is raised. sink_offset carries the absolute position across fills, so a
  * body larger than the staging buffer is written in pieces that still land contiguously.
+ *
+ * A FileWriter using io_uring takes the bytes without waiting for them: the buffer is
+ * swapped for a spare and decoding carries on while the kernel writes. One write per
+ * connection is in flight at a time, settled by Decoder_settle_write.
  */
 static bool NNTPResponse_flush_sink(Decoder *owner, NNTPResponse *instance) {
+    // First, since a failure it reports may be this response's
+    Decoder_settle_write(owner);
+
     // Already given up on this response's sink, so keep decoding and throw the bytes
     // away rather than retrying a write that is going to fail again
     if (instance->sink_failed) {
@@ -644,48 +761,44 @@ static bool NNTPResponse_flush_sink(Decoder *owner, NNTPResponse *instance) {
     if (owner->staging_used == 0) return true;
 
     FileWriter *writer = reinterpret_cast<FileWriter *>(instance->sink);
+    const long long offset = static_cast<long long>(instance->sink_offset);
+
+    if (writer->uring) {
+        // The spare is only worth its memory on connections that stream through the ring
+        if (!owner->staging_spare) {
+            owner->staging_spare = static_cast<char*>(malloc(owner->staging_size));
+            if (!owner->staging_spare) {
+                PyErr_NoMemory();
+                return false;
+            }
+        }
+        bool submitted;
+        Py_BEGIN_ALLOW_THREADS;
+        submitted = filewriter_submit(writer, &owner->write, owner->staging, owner->staging_used, offset);
+        Py_END_ALLOW_THREADS;
+        if (submitted) {
+            Py_INCREF(instance);
+            owner->write_response = instance;
+            owner->write_length = owner->staging_used;
+            owner->write_offset = offset;
+            std::swap(owner->staging, owner->staging_spare);
+            instance->sink_offset += owner->staging_used;
+            owner->staging_used = 0;
+            return true;
+        }
+    }
+
     Py_ssize_t written = 0;
     bool was_closed = false;
     unsigned long error_code = 0;
 
     Py_BEGIN_ALLOW_THREADS;
-    written = filewriter_write_raw(writer, owner->staging, owner->staging_used,
-                                   static_cast<long long>(instance->sink_offset), &was_closed, &error_code);
+    written = filewriter_write_raw(writer, owner->staging, owner->staging_used, offset, &was_closed, &error_code);
     Py_END_ALLOW_THREADS;
 
     if (was_closed || error_code) {
-        // Not an error for the connection, and it must not be raised here.
-        //
-        // The obvious handling - raise and let the caller deal with it - abandons the
-        // decoder in the middle of a response. The remainder of the article is still
-        // in the connection's buffer and would then be parsed as the start of the next
-        // one, so a failed write would cost the whole connection rather than one
-        // article. That also puts it out of reach of the Python caller, since by the
-        // time the exception surfaces the damage is done.
-        //
-        // So the response is consumed to its end with the body discarded, and the
-        // failure is reported to Python as sink_failed once the response completes.
-        // The article is lost either way and has to be fetched again; the connection
-        // does not have to be.
-        instance->sink_failed = true;
+        NNTPResponse_fail_sink(instance, writer, was_closed, error_code);
         owner->staging_used = 0;
-
-        // Build the error but hold it rather than raising: the caller needs to know
-        // whether this was a full disk or a file that was closed underneath us, and
-        // those want opposite handling. The GIL is back by now, so this is safe.
-        if (!instance->sink_error) {
-            filewriter_raise(writer, was_closed, error_code);
-#if PY_VERSION_HEX >= SABCTOOLS_PY_HEX(3, 12)
-            instance->sink_error = PyErr_GetRaisedException();
-#else
-            PyObject *error_type = NULL, *error_value = NULL, *error_traceback = NULL;
-            PyErr_Fetch(&error_type, &error_value, &error_traceback);
-            PyErr_NormalizeException(&error_type, &error_value, &error_traceback);
-            Py_XDECREF(error_type);
-            Py_XDECREF(error_traceback);
-            instance->sink_error = error_value;
-#endif
-        }
         return true;
     }
 
@@ -694,6 +807,19 @@ static bool NNTPResponse_flush_sink(Decoder *owner, NNTPResponse *instance) {
     return true;
 }
 
+/* The staging buffer is only allocated once a response actually streams to a sink */
+static bool Decoder_reserve_staging(Decoder *owner) {
+    if (owner->staging) return true;
+    owner->staging = static_cast<char*>(malloc(YENC_STAGING_SIZE));
+    if (!owner->staging) {
+        PyErr_NoMemory();
+        return false;
+    }
+    owner->staging_size = YENC_STAGING_SIZE;
+    owner->staging_used = 0;
+    return true;
+}
+
 /*
  * Decode a yEnc body straight into the sink.
  *
@@ -727,20 +853,18 @@ static bool NNTPResponse_decode_yenc_sink(Decoder *owner, NNTPResponse *instance
 
         Py_BEGIN_ALLOW_THREADS;
 
-        end = rapidyenc_decode_incremental(
+        // Decodes and hashes in one pass, while each block's output is still in L1
+        end = rapidyenc_decode_incremental_crc(
             reinterpret_cast<const void **>(&src),
             reinterpret_cast<void **>(&dst),
             chunk_in,
-            &instance->state
+            &instance->state,
+            &instance->crc
         );
 
         consumed = src - (buf + read);
         produced = dst - dst_start;
 
-        if (produced > 0) {
-            instance->crc = rapidyenc_crc(dst_start, produced, instance->crc);
-        }
-
         Py_END_ALLOW_THREADS;
 
         read += consumed;
@@ -786,16 +910,10 @@ static bool NNTPResponse_decode_yenc(Decoder *owner, NNTPResponse *instance, con
     // Streaming to a sink: decode through a buffer shared by every response on this
     // connection and write it out, instead of building a bytearray per article. The
     // sizing rules below do not apply, because nothing here is handed to Python.
-    if (instance->sink) {
-        if (owner->staging == nullptr) {
-            owner->staging = static_cast<char*>(malloc(YENC_STAGING_SIZE));
-            if (!owner->staging) {
-                PyErr_NoMemory();
-                return false;
-            }
-            owner->staging_size = YENC_STAGING_SIZE;
-            owner->staging_used = 0;
-        }
+    //
+    // Never for XZVER, whose yEnc body is a deflated overview and not part of a file.
+    if (instance->sink && instance->status_code != NNTP_OVERVIEW) {
+        if (!Decoder_reserve_staging(owner)) return false;
         if (instance->bytes_decoded == 0) {
             // Where this article belongs in the file, straight from its =ypart header
             instance->sink_offset = instance->part_begin;
@@ -882,20 +1000,18 @@ static bool NNTPResponse_decode_yenc(Decoder *owner, NNTPResponse *instance, con
         // Release GIL during CPU-intensive decode operation for better parallelism
         Py_BEGIN_ALLOW_THREADS;
 
-        end = rapidyenc_decode_incremental(
+        // Decodes and hashes in one pass, while each block's output is still in L1
+        end = rapidyenc_decode_incremental_crc(
             reinterpret_cast<const void **>(&src),
             reinterpret_cast<void **>(&dst),
             chunk_in,
-            &instance->state
+            &instance->state,
+            &instance->crc
         );
 
         consumed = src - (buf + read);
         produced = dst - dst_start;
 
-        if (produced > 0) {
-            instance->crc = rapidyenc_crc(dst_start, produced, instance->crc);
-        }
-
         Py_END_ALLOW_THREADS;
 
         read += consumed;
@@ -938,6 +1054,123 @@ static bool NNTPResponse_decode_yenc(Decoder *owner, NNTPResponse *instance, con
     return true;
 }
 
+/*
+ * Decode `groups` whole UU groups, 4 characters into 3 bytes each. Returns the new end.
+ *
+ * SSE2 and NEON are baseline on x86-64 and ARM64, so neither needs a compiler flag or
+ * a runtime check. SSE2 has no byte shuffle, so each group is assembled in its own
+ * 32-bit lane and the lanes are then packed with 64-bit shifts; the two 8-byte stores
+ * that follow write 2 bytes past the 12 decoded, into room NNTPResponse_reserve_uu
+ * always leaves. NEON's de-interleaving load and store do the packing by themselves.
+ * AVX2 would need the same runtime dispatch rapidyenc does for a line of only 15
+ * groups, so it is not worth having here.
+ *
+ * Characters are taken modulo 64 after subtracting the space, exactly as
+ * NNTPResponse_decode_uu_char does, '`' included.
+ */
+static char* uu_decode_groups(const char* src, std::size_t groups, char* dst) {
+#if defined(SABCTOOLS_UU_SSE2)
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i low6 = _mm_set1_epi32(0x3F);
+    for (; groups >= 4; groups -= 4, src += 16, dst += 12) {
+        const __m128i c = _mm_sub_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src)), space);
+        const __m128i c0 = _mm_and_si128(c, low6);
+        const __m128i c1 = _mm_and_si128(_mm_srli_epi32(c, 8), low6);
+        const __m128i c2 = _mm_and_si128(_mm_srli_epi32(c, 16), low6);
+        const __m128i c3 = _mm_and_si128(_mm_srli_epi32(c, 24), low6);
+        const __m128i b0 = _mm_or_si128(_mm_slli_epi32(c0, 2), _mm_srli_epi32(c1, 4));
+        const __m128i b1 = _mm_or_si128(_mm_and_si128(_mm_slli_epi32(c1, 4), _mm_set1_epi32(0xF0)), _mm_srli_epi32(c2, 2));
+        const __m128i b2 = _mm_or_si128(_mm_and_si128(_mm_slli_epi32(c2, 6), _mm_set1_epi32(0xC0)), c3);
+        // Three bytes at the bottom of each lane
+        const __m128i lanes = _mm_or_si128(b0, _mm_or_si128(_mm_slli_epi32(b1, 8), _mm_slli_epi32(b2, 16)));
+        // Close the gap in each 64-bit half: 6 bytes at the bottom of both
+        const __m128i packed = _mm_or_si128(_mm_and_si128(lanes, _mm_set_epi32(0, 0xFFFFFF, 0, 0xFFFFFF)),
+                                            _mm_srli_epi64(_mm_andnot_si128(_mm_set_epi32(0, 0xFFFFFFFF, 0, 0xFFFFFFFF), lanes), 8));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst), packed);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + 6), _mm_unpackhi_epi64(packed, packed));
+    }
+#elif defined(SABCTOOLS_UU_NEON)
+    const uint8x8_t space = vdup_n_u8(' ');
+    const uint8x8_t low6 = vdup_n_u8(0x3F);
+    for (; groups >= 8; groups -= 8, src += 32, dst += 24) {
+        // De-interleaved: val[n] holds character n of each of 8 groups
+        const uint8x8x4_t c = vld4_u8(reinterpret_cast<const uint8_t*>(src));
+        const uint8x8_t c0 = vand_u8(vsub_u8(c.val[0], space), low6);
+        const uint8x8_t c1 = vand_u8(vsub_u8(c.val[1], space), low6);
+        const uint8x8_t c2 = vand_u8(vsub_u8(c.val[2], space), low6);
+        const uint8x8_t c3 = vand_u8(vsub_u8(c.val[3], space), low6);
+        uint8x8x3_t out;
+        out.val[0] = vorr_u8(vshl_n_u8(c0, 2), vshr_n_u8(c1, 4));
+        out.val[1] = vorr_u8(vshl_n_u8(c1, 4), vshr_n_u8(c2, 2));
+        out.val[2] = vorr_u8(vshl_n_u8(c2, 6), c3);
+        vst3_u8(reinterpret_cast<uint8_t*>(dst), out);
+    }
+#endif
+    for (; groups > 0; groups--, src += 4, dst += 3) {
+        // All four characters as one word, so each output byte is a shift and a mask
+        // away instead of a decode per character
+        const uint32_t word = (static_cast<uint32_t>(static_cast<unsigned char>(src[0])) << 24 |
+                               static_cast<uint32_t>(static_cast<unsigned char>(src[1])) << 16 |
+                               static_cast<uint32_t>(static_cast<unsigned char>(src[2])) << 8 |
+                               static_cast<uint32_t>(static_cast<unsigned char>(src[3])));
+        // Per-byte "minus space, modulo 64" without borrows: adding 0x20 to a 6-bit
+        // value is the same modulo 64, and cannot carry out of its byte
+        const uint32_t sextets = ((word & 0x3F3F3F3F) + 0x20202020) & 0x3F3F3F3F;
+        const uint32_t bits = (sextets >> 24) << 18 | ((sextets >> 16) & 0x3F) << 12 |
+                              ((sextets >> 8) & 0x3F) << 6 | (sextets & 0x3F);
+        dst[0] = static_cast<char>(bits >> 16);
+        dst[1] = static_cast<char>(bits >> 8);
+        dst[2] = static_cast<char>(bits);
+    }
+    return dst;
+}
+
+/*
+ * Make room for a UU line that decodes to `length` bytes, as its length character says.
+ *
+ * The bytearray grows geometrically and is only trimmed to bytes_decoded once the
+ * response is complete, so a body costs a few reallocations instead of one per line.
+ * The first allocation is sized for UU_LINES_ESTIMATE lines like this one, which
+ * covers a typical post in one go. Going by the length character rather than the
+ * characters on the line keeps a long first line - junk, or a broken encoder - from
+ * reserving hundreds of megabytes.
+ */
+static bool NNTPResponse_reserve_uu(NNTPResponse* instance, std::size_t length)
+{
+    // Past the decoded bytes: uu_decode_groups may store up to this much beyond them
+    const Py_ssize_t needed = instance->bytes_decoded + static_cast<Py_ssize_t>(length) + UU_STORE_SLACK;
+    if (!instance->data) {
+        const Py_ssize_t estimate = static_cast<Py_ssize_t>(length) * UU_LINES_ESTIMATE;
+        instance->data = PyByteArray_FromStringAndSize(nullptr, std::max(needed, estimate));
+        return instance->data != nullptr;
+    }
+    const Py_ssize_t capacity = PyByteArray_GET_SIZE(instance->data);
+    if (needed <= capacity) return true;
+    return PyByteArray_Resize(instance->data, std::max(needed, capacity * 2)) == 0;
+}
+
+/*
+ * Where the `length` decoded bytes of a UU line go.
+ *
+ * With a sink that is the connection's staging buffer, flushed first if the line might
+ * not fit. UU lines are decoded and staged one at a time, so the body reaches the sink
+ * in order at a running offset starting from the one given to expect(), and memory
+ * stays at the staging buffer however large the post.
+ */
+static char* NNTPResponse_uu_destination(Decoder* owner, NNTPResponse* instance, std::size_t length)
+{
+    if (instance->sink) {
+        if (!Decoder_reserve_staging(owner)) return nullptr;
+        const Py_ssize_t needed = static_cast<Py_ssize_t>(length) + UU_STORE_SLACK;
+        if (owner->staging_size - owner->staging_used < needed && !NNTPResponse_flush_sink(owner, instance)) {
+            return nullptr;
+        }
+        return owner->staging + owner->staging_used;
+    }
+    if (!NNTPResponse_reserve_uu(instance, length)) return nullptr;
+    return PyByteArray_AS_STRING(instance->data) + instance->bytes_decoded;
+}
+
 /**
  * Decode a single UUEncoded line and update the Decoder's state and buffer.
  *
@@ -952,28 +1185,21 @@ static bool NNTPResponse_decode_yenc(Decoder *owner, NNTPResponse *instance, con
  * - End detection: lines starting with "end " or "`" terminate UU decoding.
  * - Body decoding: uses the leading length character followed by groups of 4 printable
  *   characters to reconstruct up to 3 bytes per group, appending to the bytearray.
- * - Storage: lazily allocates/resizes the output bytearray and advances data_position.
+ *   Whole groups go through uu_decode_groups, the short last one through scalar code.
+ * - Storage: grows the output bytearray geometrically, see NNTPResponse_reserve_uu,
+ *   or stages for the sink, see NNTPResponse_uu_destination.
  *
  * Notes:
  * - CRC/permissions from UU are not validated here.
  * - Expects a single logical line without trailing CRLF.
  *
- * @param instance The Decoder instance to update.
+ * @param owner    The Decoder whose staging buffer a sink is written through.
+ * @param instance The response to update.
  * @param line     The current input line (without CRLF).
  * @return true on success, false on allocation/resize failure.
  */
-static bool NNTPResponse_decode_uu(NNTPResponse* instance, std::string_view line)
+static bool NNTPResponse_decode_uu(Decoder* owner, NNTPResponse* instance, std::string_view line)
 {
-    // Allocate or resize bytearray
-    if (!instance->data) {
-        instance->data = PyByteArray_FromStringAndSize(nullptr, line.size());
-        if (!instance->data) {
-            return false;
-        }
-    } else if (PyByteArray_Resize(instance->data, instance->bytes_decoded + line.size()) == -1) {
-        return false;
-    }
-
     // Detect 'begin' line and extract filename
     if (!instance->body) {
         if (starts_with(line, "begin ")) {
@@ -1007,7 +1233,7 @@ static bool NNTPResponse_decode_uu(NNTPResponse* instance, std::string_view line
     if (instance->body && one_of(line, "`", "end")) {
         instance->body = false;
         instance->file_size = instance->bytes_decoded;
-        return true;
+        return !instance->sink || NNTPResponse_flush_sink(owner, instance);
     }
 
     // Decode body lines
@@ -1034,9 +1260,20 @@ static bool NNTPResponse_decode_uu(NNTPResponse* instance, std::string_view line
         }
 
         line.remove_prefix(1); // skip length byte
-        char* dst = PyByteArray_AsString(instance->data) + instance->bytes_decoded;
+
+        // The length character bounds the output, however long the line: at most effLen
+        // bytes are decoded, plus what uu_decode_groups may store past them
+        char* dst = NNTPResponse_uu_destination(owner, instance, effLen);
+        if (!dst) return false;
         char* dst_start = dst;
-        auto it = line.begin();
+
+        // Whole groups first, several at a time; only the last group of a line can be
+        // short, and that one is left to the loop below
+        const std::size_t whole = std::min(effLen / 3, line.size() / 4);
+        dst = uu_decode_groups(line.data(), whole, dst);
+        effLen -= whole * 3;
+
+        auto it = line.begin() + whole * 4;
         const auto end = line.end();
 
         while (effLen > 0 && std::distance(it, end) >= 4) {
@@ -1057,11 +1294,14 @@ static bool NNTPResponse_decode_uu(NNTPResponse* instance, std::string_view line
                 *dst++ = static_cast<char>(c2 << 6 | c3);
             }
 
-            effLen -= 3;
+            // Not 3: a short last group would wrap effLen round and decode the rest of
+            // the line, past what was reserved for it
+            effLen -= chunk;
         }
 
         Py_ssize_t produced = dst - dst_start;
         instance->bytes_decoded += produced;
+        if (instance->sink) owner->staging_used += produced;
         if (produced > 0) {
             instance->crc = rapidyenc_crc(dst_start, produced, instance->crc);
         }
@@ -1134,6 +1374,10 @@ static Py_ssize_t NNTPResponse_decode_buffer(Decoder *owner, NNTPResponse *insta
         if (line == ".") {
             // NNTP article terminator
             instance->eof = true;
+            // A UU body cut short before its end line still has its last lines staged
+            if (instance->sink && instance->format == ENCODING_FORMAT_UU && !NNTPResponse_flush_sink(owner, instance)) {
+                return -1;
+            }
             return read;
         }
 
@@ -1149,10 +1393,27 @@ static Py_ssize_t NNTPResponse_decode_buffer(Decoder *owner, NNTPResponse *insta
                     instance->eof = true;
                     break;
                 }
+                if (instance->status_code == NNTP_OVERVIEW) {
+                    instance->overview_columns = new OverviewColumns();
+                }
                 continue;
             }
 
-            NNTPResponse_detect_format(instance, line);
+            if (instance->status_code == NNTP_OVERVIEW) {
+                // XZVER deflates the overview and yEnc encodes the result, so it arrives
+                // as a single-part yEnc body. Decode it like one and inflate it once the
+                // response is complete.
+                if (!starts_with(line, "=ybegin ")) {
+                    if (starts_with(line, "..")) line.remove_prefix(1);
+                    overview_parse_line(instance->overview_columns, line);
+                    continue;
+                }
+                Py_XDECREF(instance->format);
+                instance->format = ENCODING_FORMAT_YENC;
+                Py_INCREF(ENCODING_FORMAT_YENC);
+            } else {
+                NNTPResponse_detect_format(instance, line);
+            }
         }
 
         if (instance->format == nullptr) {
@@ -1168,7 +1429,7 @@ static Py_ssize_t NNTPResponse_decode_buffer(Decoder *owner, NNTPResponse *insta
                 if (instance->eof) return read;   // Decoder consumed the article terminator
             }
         } else if (instance->format == ENCODING_FORMAT_UU) {
-            if (!NNTPResponse_decode_uu(instance, line)) return -1;
+            if (!NNTPResponse_decode_uu(owner, instance, line)) return -1;
         }
     }
 
@@ -1200,7 +1461,7 @@ PyObject* yenc_encode(PyObject* self, PyObject* Py_input_string)
     char *output_buffer = NULL;
     size_t input_len = 0;
     size_t output_len = 0;
-    uint32_t crc;
+    uint32_t crc = 0;
 
     // Verify the input is a bytes string
     if(!PyBytes_Check(Py_input_string)) {
@@ -1220,8 +1481,7 @@ PyObject* yenc_encode(PyObject* self, PyObject* Py_input_string)
 
     // Encode result
     int column = 0;
-    output_len = rapidyenc_encode_ex(YENC_LINESIZE, &column, input_buffer, output_buffer, input_len, 1);
-    crc = rapidyenc_crc(input_buffer, input_len, 0);
+    output_len = rapidyenc_encode_ex_crc(YENC_LINESIZE, &column, input_buffer, output_buffer, input_len, 1, &crc);
 
     // Restore GIL so we can build Python strings
     Py_END_ALLOW_THREADS;
@@ -1249,6 +1509,8 @@ static PyObject* NNTPResponse_new(PyTypeObject* type, PyObject* args, PyObject*
     instance->format = nullptr;
     instance->file_name = nullptr;
     instance->message = nullptr;
+    instance->overview_columns = nullptr;
+    instance->overview = nullptr;
     instance->bytes_decoded = 0;
     instance->bytes_read = 0;
     instance->file_size = 0;
@@ -1315,6 +1577,7 @@ static PyGetSetDef NNTPResponse_gets_sets[] = {
     {"crc", (getter)NNTPResponse_get_crc, NULL, NULL, NULL},
     {"crc_expected", (getter)NNTPResponse_get_crc_expected, NULL, NULL, NULL},
     {"format", (getter)NNTPResponse_get_format, NULL, NULL, NULL},
+    {"overview", (getter)NNTPResponse_get_overview, NULL, NULL, NULL},
     {nullptr, nullptr, nullptr, nullptr, nullptr}
 };
 
@@ -1374,11 +1637,13 @@ PyTypeObject NNTPResponseType = {
  */
 static int Decoder_getbuffer(Decoder* self, Py_buffer *view, int flags)
 {
+    Py_ssize_t available;
+    char* free_space = decoder_free_space(self, available);
     return PyBuffer_FillInfo(
         view,
         reinterpret_cast<PyObject *>(self),
-        self->data + self->position,
-        self->size - self->position,
+        free_space,
+        available,
         0,
         flags);
 }
@@ -1411,15 +1676,8 @@ static PyObject* Decoder_iter(Decoder *self)
 
 static PyObject* Decoder_iternext(Decoder *self)
 {
-    if (self->deque.empty()) {
-        return NULL;
-    }
-
-    NNTPResponse* item = self->deque.front();
-    self->deque.pop_front();
-
     // Transfer ownership from deque to Python.
-    return reinterpret_cast<PyObject*>(item);
+    return reinterpret_cast<PyObject*>(decoder_next(self));
 }
 
 static int Decoder_init(Decoder *self, PyObject *args, PyObject *kwds)
@@ -1467,6 +1725,16 @@ static PyObject* Decoder_new(PyTypeObject* type, PyObject* args, PyObject* kwds)
     self->staging = nullptr;
     self->staging_size = 0;
     self->staging_used = 0;
+    self->staging_spare = nullptr;
+    self->write_response = nullptr;
+    self->write_length = 0;
+    self->write_offset = 0;
+    new (&self->write) UringWrite();
+    self->inflater = nullptr;
+    self->compressed = nullptr;
+    self->compressed_used = 0;
+    self->compressed_bytes = 0;
+    self->decompressed_bytes = 0;
 
     return reinterpret_cast<PyObject *>(self);
 }
@@ -1476,15 +1744,18 @@ static int Decoder_traverse(Decoder *self, visitproc visit, void* arg)
     for (NNTPResponse* item : self->deque)
         Py_VISIT(item);
     Py_VISIT(self->response);
+    Py_VISIT(self->write_response);
     for (PendingRequest& request : self->pending) {
         Py_VISIT(request.context);
         Py_VISIT(request.sink);
     }
+    Py_VISIT(self->inflater);
     return 0;
 }
 
 static int Decoder_clear(Decoder *self)
 {
+    Decoder_settle_write(self);
     for (NNTPResponse* item : self->deque)
         Py_XDECREF(item);
     self->deque.clear();
@@ -1494,12 +1765,15 @@ static int Decoder_clear(Decoder *self)
         Py_XDECREF(request.sink);
     }
     self->pending.clear();
+    Py_CLEAR(self->inflater);
     return 0;
 }
 
 static void Decoder_dealloc(Decoder *self)
 {
     PyObject_GC_UnTrack(self);
+    // The kernel may still be reading the spare buffer
+    Decoder_settle_write(self);
     // DECREF all remaining items
     for (NNTPResponse* item : self->deque)
         Py_XDECREF(item);
@@ -1510,8 +1784,11 @@ static void Decoder_dealloc(Decoder *self)
     }
     self->deque.~deque();
     self->pending.~deque();
+    Py_XDECREF(self->inflater);
     free(self->data);
     free(self->staging);
+    free(self->staging_spare);
+    free(self->compressed);
     Py_TYPE(self)->tp_free((PyObject*)self);
 }
 
@@ -1566,6 +1843,7 @@ Py_ssize_t Decoder_decode(Decoder *self, const char* data, const Py_ssize_t size
             // References are transferred from the queue
             instance->context = request.context;
             instance->sink = request.sink;
+            instance->sink_offset = request.offset;
         }
         // Defensive, and deliberately so. A response that ran to the end of its body
         // has already flushed, so this is normally a no-op - but tp_clear drops a
@@ -1578,6 +1856,61 @@ Py_ssize_t Decoder_decode(Decoder *self, const char* data, const Py_ssize_t size
     return NNTPResponse_decode_buffer(self, instance, data, size);
 }
 
+/*
+ * Settle a response that has just received its last byte, before it is queued.
+ *
+ * Overview responses are only turned into columns here. An XZVER body has to be
+ * complete before it can be inflated, and a plain one is cheaper to hand over in one
+ * piece than to rebuild as it grows.
+ */
+static bool NNTPResponse_finish(NNTPResponse *instance) {
+    if (instance->data && PyByteArray_GET_SIZE(instance->data) != instance->bytes_decoded) {
+        // Adjust the Python-size of the bytearray-object
+        // This will only do a real resize if the data shrunk by half, so rarely in our case!
+        // Resizing a bytes object always does a real resize, so more costly
+        PyByteArray_Resize(instance->data, instance->bytes_decoded);
+    }
+
+    if (!instance->overview_columns) return true;
+
+    bool usable = true;
+    if (instance->format == ENCODING_FORMAT_YENC) {
+        // XZVER. The deflated bytes were never the caller's data, so they go once
+        // inflated; a block that will not inflate is corrupt, and is reported as
+        // baddata with no overview rather than raised, because raising from process()
+        // would lose every later response already in the buffer.
+        PyObject *inflated = nullptr;
+        if (instance->data && instance->bytes_decoded) {
+            inflated = inflate_block(PyByteArray_AS_STRING(instance->data), instance->bytes_decoded);
+        }
+        if (inflated) {
+            overview_parse_block(instance->overview_columns,
+                                 std::string_view(PyBytes_AS_STRING(inflated), PyBytes_GET_SIZE(inflated)));
+            Py_DECREF(inflated);
+        } else {
+            PyErr_Clear();
+            usable = false;
+        }
+        Py_CLEAR(instance->data);
+        Py_CLEAR(instance->format);
+    }
+
+    if (usable) {
+        instance->overview = overview_build(instance->overview_columns);
+        if (!instance->overview) return false;
+    }
+    if (!usable || instance->overview_columns->skipped) {
+        instance->has_baddata = true;
+    }
+
+    delete instance->overview_columns;
+    instance->overview_columns = nullptr;
+    return true;
+}
+
+static bool Decoder_consume(Decoder *self);
+static bool Decoder_inflate(Decoder *self);
+
 /*
  * Advance decoding for data previously written via the buffer protocol.
  *
@@ -1609,20 +1942,70 @@ static PyObject* Decoder_process(Decoder *self, PyObject *arg)
         return NULL;
     }
 
-    if (self->position + length > self->size) {
+    const Py_ssize_t filled = self->inflater ? self->compressed_used : self->position;
+    if (filled + length > self->size) {
         PyErr_SetString(PyExc_ValueError, "length exceeds buffer size");
         return NULL;
     }
 
+    if (!decoder_process(self, length)) return NULL;
+    Py_RETURN_NONE;
+}
+
+bool decoder_process(Decoder *self, Py_ssize_t length)
+{
+    if (self->inflater) {
+        self->compressed_used += length;
+        return Decoder_inflate(self);
+    }
     self->position += length;
+    return Decoder_consume(self);
+}
+
+char* decoder_free_space(Decoder *self, Py_ssize_t &available)
+{
+    if (self->inflater) {
+        available = self->size - self->compressed_used;
+        return self->compressed + self->compressed_used;
+    }
+    available = self->size - self->position;
+    return self->data + self->position;
+}
+
+void decoder_expect(Decoder *self, PyObject *context, PyObject *sink, Py_ssize_t offset)
+{
+    PendingRequest request;
+    request.context = context;
+    request.sink = sink;
+    request.offset = offset;
+    Py_XINCREF(request.context);
+    Py_XINCREF(request.sink);
+    self->pending.push_back(request);
+}
+
+NNTPResponse* decoder_next(Decoder *self)
+{
+    if (self->deque.empty()) return nullptr;
+    NNTPResponse* item = self->deque.front();
+    self->deque.pop_front();
+    // Not delivered while its last write may yet fail
+    if (self->write_response == item) Decoder_settle_write(self);
+    return item;
+}
 
+/*
+ * Decode everything between consumed and position in the ring, queueing each response
+ * that completes.
+ */
+static bool Decoder_consume(Decoder *self)
+{
     while (self->position > self->consumed) {
         auto read = Decoder_decode(
             self,
             self->data + self->consumed,
             self->position - self->consumed
         );
-        if (read == -1) return NULL;
+        if (read == -1) return false;
 
         self->consumed += read;
         self->response->bytes_read += read;
@@ -1631,12 +2014,7 @@ static PyObject* Decoder_process(Decoder *self, PyObject *arg)
 
         // Case 1: EOF for the current decoder
         if (self->response->eof) {
-            if (self->response->bytes_decoded && self->response->data) {
-                // Adjust the Python-size of the bytearray-object
-                // This will only do a real resize if the data shrunk by half, so never in our case!
-                // Resizing a bytes object always does a real resize, so more costly
-                PyByteArray_Resize(self->response->data, self->response->bytes_decoded);
-            }
+            if (!NNTPResponse_finish(self->response)) return false;
 
             // Push completed decoder
             self->deque.push_back(self->response);
@@ -1672,7 +2050,73 @@ static PyObject* Decoder_process(Decoder *self, PyObject *arg)
         break;
     }
 
-    Py_RETURN_NONE;
+    return true;
+}
+
+/*
+ * Inflate the compressed buffer into the free tail of the ring, decoding as it fills.
+ *
+ * Output is bounded by the free tail, so a burst that inflates twenty-fold never needs
+ * more than the ring: zlib keeps the input it could not use, it moves to the front of
+ * the compressed buffer, and the loop decodes what was produced and goes round again.
+ * The loop ends only once zlib returns less than it was allowed, which is the one sign
+ * that it has nothing more to give for this input - output it still holds internally
+ * does not show up as unconsumed input.
+ */
+static bool Decoder_inflate(Decoder *self)
+{
+    while (true) {
+        const Py_ssize_t room = self->size - self->position;
+        if (room <= 0) {
+            // Cannot happen while the ring compacts below YENC_COMPACT_THRESHOLD, and
+            // a max_length of 0 would mean unlimited to zlib
+            PyErr_SetString(PyExc_BufferError, "no room to inflate into");
+            return false;
+        }
+
+        Py_ssize_t used = 0;
+        Py_ssize_t written = 0;
+        if (!inflate_stream(self->inflater, self->compressed, self->compressed_used,
+                            self->data + self->position, room, used, written)) {
+            return false;
+        }
+
+        if (used) {
+            self->compressed_used -= used;
+            memmove(self->compressed, self->compressed + used, self->compressed_used);
+        }
+        self->compressed_bytes += used;
+        self->decompressed_bytes += written;
+
+        if (written) {
+            self->position += written;
+            if (!Decoder_consume(self)) return false;
+        }
+
+        if (written < room) return true;
+    }
+}
+
+/*
+ * Checked rather than duck-typed: the write happens from C with the GIL released, so
+ * it needs the real structure, not an object that merely has a write method.
+ */
+bool decoder_check_sink(PyObject *sink)
+{
+    if (sink && !PyObject_TypeCheck(sink, &FileWriterType)) {
+        PyErr_Format(PyExc_TypeError, "sink must be a FileWriter or None, not %s", Py_TYPE(sink)->tp_name);
+        return false;
+    }
+    return true;
+}
+
+bool decoder_check_offset(Py_ssize_t offset)
+{
+    if (offset < 0) {
+        PyErr_SetString(PyExc_ValueError, "offset must not be negative");
+        return false;
+    }
+    return true;
 }
 
 /*
@@ -1681,39 +2125,204 @@ static PyObject* Decoder_process(Decoder *self, PyObject *arg)
  * ``context`` is returned untouched as NNTPResponse.context. ``sink`` is an optional
  * FileWriter: when given, the decoded body is streamed into it at the offset the yEnc
  * headers declare instead of being collected into a bytearray, and response.data is
- * left as None.
+ * left as None. A UU body has no such header and is written sequentially from
+ * ``offset``, which is 0 for a single-part post and the caller's running total for
+ * the parts of a multi-part one. yEnc ignores it.
  *
  * Calls must be in the order the requests were sent. Nothing here can check that, but
  * keeping the queue on this side means it cannot drift against the responses the way
  * a second queue in Python could.
  */
-static PyObject* Decoder_expect(Decoder *self, PyObject *args)
+static PyObject* Decoder_expect(Decoder *self, PyObject *args, PyObject *kwds)
 {
+    static const char* kwlist[] = {"context", "sink", "offset", nullptr};
     PyObject* context = nullptr;
     PyObject* sink = nullptr;
+    Py_ssize_t offset = 0;
 
-    if (!PyArg_ParseTuple(args, "O|O:expect", &context, &sink))
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|On:expect", const_cast<char **>(kwlist), &context, &sink, &offset))
         return NULL;
 
     if (sink == Py_None) sink = nullptr;
+    if (!decoder_check_sink(sink) || !decoder_check_offset(offset)) return NULL;
 
-    // Checked rather than duck-typed: the write happens from C with the GIL released,
-    // so it needs the real structure, not an object that merely has a write method
-    if (sink && !PyObject_TypeCheck(sink, &FileWriterType)) {
-        PyErr_Format(PyExc_TypeError, "sink must be a FileWriter or None, not %s", Py_TYPE(sink)->tp_name);
+    decoder_expect(self, context, sink, offset);
+    Py_RETURN_NONE;
+}
+
+/*
+ * Treat everything received from here on as one deflate stream (RFC 8054).
+ *
+ * Called once the server has answered COMPRESS DEFLATE with 206. From then on the
+ * buffer protocol exports a second buffer for the compressed bytes, and process()
+ * inflates them into the ring before decoding, so the caller's read loop does not
+ * change. The server sends nothing after the 206 until the next command, but anything
+ * already in the ring past the 206 line arrived after it, so it is compressed too and
+ * is moved across rather than decoded.
+ *
+ * Only the receive side is handled here: commands have to be deflated by the caller.
+ */
+static PyObject* Decoder_enable_compression(Decoder *self, PyObject *args, PyObject *kwds)
+{
+    static const char* kwlist[] = {"wbits", nullptr};
+    int wbits = INFLATE_WBITS_RAW;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|i:enable_compression", const_cast<char **>(kwlist), &wbits))
+        return NULL;
+
+    if (self->inflater) {
+        PyErr_SetString(PyExc_ValueError, "compression is already enabled");
         return NULL;
     }
 
-    PendingRequest request;
-    request.context = context;
-    request.sink = sink;
-    Py_XINCREF(request.context);
-    Py_XINCREF(request.sink);
-    self->pending.push_back(request);
+    char* compressed = static_cast<char*>(malloc(self->size));
+    if (!compressed) return PyErr_NoMemory();
+
+    PyObject* inflater = inflate_stream_new(wbits);
+    if (!inflater) {
+        free(compressed);
+        return NULL;
+    }
+
+    const Py_ssize_t unprocessed = self->position - self->consumed;
+    if (unprocessed > 0) {
+        memcpy(compressed, self->data + self->consumed, unprocessed);
+    }
+    self->compressed_used = unprocessed;
+    self->position = 0;
+    self->consumed = 0;
+
+    free(self->compressed);
+    self->compressed = compressed;
+    self->inflater = inflater;
+
+    if (unprocessed > 0 && !Decoder_inflate(self)) return NULL;
 
     Py_RETURN_NONE;
 }
 
+/* A message-id as bytes to splice into a command, without copying it */
+bool decoder_message_id(PyObject *item, std::string_view &message_id)
+{
+    const char *data;
+    Py_ssize_t length;
+    if (PyUnicode_Check(item)) {
+        data = PyUnicode_AsUTF8AndSize(item, &length);
+        if (!data) return false;
+    } else if (PyBytes_Check(item)) {
+        data = PyBytes_AS_STRING(item);
+        length = PyBytes_GET_SIZE(item);
+    } else {
+        PyErr_Format(PyExc_TypeError, "message-id must be str or bytes, not %s", Py_TYPE(item)->tp_name);
+        return false;
+    }
+    // Anything that ends a line would let one message-id smuggle in a second command,
+    // and the response to it would then be paired with the wrong request
+    if (memchr(data, '\r', length) || memchr(data, '\n', length)) {
+        PyErr_SetString(PyExc_ValueError, "message-id must not contain CR or LF");
+        return false;
+    }
+    message_id = std::string_view(data, length);
+    return true;
+}
+
+/*
+ * Build the commands for a whole batch of requests and record every one of them.
+ *
+ * ``template`` is one complete command with a single %s where the message-id goes,
+ * line ending included, such as b"BODY <%s>\r\n". Each item is (message_id, context),
+ * (message_id, context, sink) or (message_id, context, sink, offset), with the same
+ * meaning as for expect().
+ *
+ * Every item is checked before anything is recorded, so a bad one leaves the queue as
+ * it was: the batch is either all pending or none of it is, and nothing is left
+ * recorded for a command the caller never got to send. Returns the commands as one
+ * bytes object, ready for a single sendall().
+ */
+static PyObject* Decoder_queue_requests(Decoder *self, PyObject *args)
+{
+    Py_buffer command;
+    PyObject* items = nullptr;
+
+    if (!PyArg_ParseTuple(args, "y*O:queue_requests", &command, &items))
+        return NULL;
+
+    PyObject* result = nullptr;
+    PyObject* sequence = nullptr;
+    std::vector<std::string_view> message_ids;
+    std::vector<Py_ssize_t> offsets;
+    std::string_view prefix, suffix;
+
+    {
+        const std::string_view format(static_cast<const char*>(command.buf), command.len);
+        const size_t marker = format.find("%s");
+        if (marker == std::string_view::npos || format.find("%s", marker + 2) != std::string_view::npos) {
+            PyErr_SetString(PyExc_ValueError, "template must contain exactly one %s");
+            goto done;
+        }
+        prefix = format.substr(0, marker);
+        suffix = format.substr(marker + 2);
+    }
+
+    sequence = PySequence_Fast(items, "requests must be a sequence");
+    if (!sequence) goto done;
+
+    {
+        const Py_ssize_t count = PySequence_Fast_GET_SIZE(sequence);
+        PyObject** entries = PySequence_Fast_ITEMS(sequence);
+        message_ids.reserve(count);
+        offsets.assign(count, 0);
+
+        Py_ssize_t total = 0;
+        for (Py_ssize_t i = 0; i < count; i++) {
+            PyObject* entry = entries[i];
+            if (!PyTuple_Check(entry) || PyTuple_GET_SIZE(entry) < 2 || PyTuple_GET_SIZE(entry) > 4) {
+                PyErr_SetString(PyExc_TypeError, "each request must be (message_id, context[, sink[, offset]])");
+                goto done;
+            }
+            PyObject* sink = PyTuple_GET_SIZE(entry) >= 3 ? PyTuple_GET_ITEM(entry, 2) : nullptr;
+            if (sink == Py_None) sink = nullptr;
+            if (!decoder_check_sink(sink)) goto done;
+            if (PyTuple_GET_SIZE(entry) == 4) {
+                offsets[i] = PyLong_AsSsize_t(PyTuple_GET_ITEM(entry, 3));
+                if (offsets[i] == -1 && PyErr_Occurred()) goto done;
+                if (!decoder_check_offset(offsets[i])) goto done;
+            }
+
+            std::string_view message_id;
+            if (!decoder_message_id(PyTuple_GET_ITEM(entry, 0), message_id)) goto done;
+            message_ids.push_back(message_id);
+            total += static_cast<Py_ssize_t>(prefix.size() + message_id.size() + suffix.size());
+        }
+
+        result = PyBytes_FromStringAndSize(NULL, total);
+        if (!result) goto done;
+
+        char* out = PyBytes_AS_STRING(result);
+        for (const std::string_view& message_id : message_ids) {
+            memcpy(out, prefix.data(), prefix.size());
+            out += prefix.size();
+            memcpy(out, message_id.data(), message_id.size());
+            out += message_id.size();
+            memcpy(out, suffix.data(), suffix.size());
+            out += suffix.size();
+        }
+
+        // Nothing past this point can fail
+        for (Py_ssize_t i = 0; i < count; i++) {
+            PyObject* entry = entries[i];
+            PyObject* sink = PyTuple_GET_SIZE(entry) >= 3 ? PyTuple_GET_ITEM(entry, 2) : nullptr;
+            if (sink == Py_None) sink = nullptr;
+            decoder_expect(self, PyTuple_GET_ITEM(entry, 1), sink, offsets[i]);
+        }
+    }
+
+done:
+    Py_XDECREF(sequence);
+    PyBuffer_Release(&command);
+    return result;
+}
+
 /* Drop every pending request, for a connection being reset */
 static PyObject* Decoder_clear_expected(Decoder *self, PyObject *Py_UNUSED(ignored))
 {
@@ -1781,20 +2390,45 @@ static PyObject* Decoder_get_pending(Decoder *self, void* closure)
     return result;
 }
 
+static PyObject* Decoder_get_compressed(Decoder *self, void* closure)
+{
+    return PyBool_FromLong(self->inflater != nullptr);
+}
+
+static PyObject* Decoder_get_compressed_bytes(Decoder *self, void* closure)
+{
+    return PyLong_FromSsize_t(self->compressed_bytes);
+}
+
+static PyObject* Decoder_get_decompressed_bytes(Decoder *self, void* closure)
+{
+    return PyLong_FromSsize_t(self->decompressed_bytes);
+}
+
 static PyGetSetDef Decoder_getsetters[] = {
     {"expected", (getter)Decoder_get_expected, NULL,
      PyDoc_STR("Requests sent whose responses have not been decoded yet"), NULL},
     {"pending", (getter)Decoder_get_pending, NULL,
      PyDoc_STR("Contexts of the requests still awaiting a response, oldest first"), NULL},
+    {"compressed", (getter)Decoder_get_compressed, NULL,
+     PyDoc_STR("Whether enable_compression() has been called"), NULL},
+    {"compressed_bytes", (getter)Decoder_get_compressed_bytes, NULL,
+     PyDoc_STR("Deflated bytes inflated so far"), NULL},
+    {"decompressed_bytes", (getter)Decoder_get_decompressed_bytes, NULL,
+     PyDoc_STR("Bytes those inflated to"), NULL},
     {NULL}
 };
 
 static PyMethodDef Decoder_methods[] = {
     {"process", (PyCFunction)Decoder_process, METH_O, ""},
-    {"expect", (PyCFunction)Decoder_expect, METH_VARARGS,
-     PyDoc_STR("expect(context, sink=None)\n\nRecord a sent request and how its response should be handled.")},
+    {"expect", (PyCFunction)(void(*)(void))Decoder_expect, METH_VARARGS | METH_KEYWORDS,
+     PyDoc_STR("expect(context, sink=None, offset=0)\n\nRecord a sent request and how its response should be handled.")},
+    {"queue_requests", (PyCFunction)Decoder_queue_requests, METH_VARARGS,
+     PyDoc_STR("queue_requests(template, requests)\n\nBuild the commands for a batch of requests and record them all.")},
     {"clear_expected", (PyCFunction)Decoder_clear_expected, METH_NOARGS,
      PyDoc_STR("clear_expected()\n\nForget every pending request.")},
+    {"enable_compression", (PyCFunction)(void(*)(void))Decoder_enable_compression, METH_VARARGS | METH_KEYWORDS,
+     PyDoc_STR("enable_compression(wbits=-15)\n\nInflate everything received from now on (COMPRESS DEFLATE).")},
     {NULL}
 };
 
@@ -1917,6 +2551,8 @@ bool yenc_init(PyObject *m) {
     rapidyenc_decode_init();
     rapidyenc_crc_init();
 
+    if (!inflate_init()) return false;
+
     // Create EncodingFormat enum
     static EnumEntry encoding_entries[] = {
         {"YENC", 0},
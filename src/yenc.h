@@ -28,9 +28,12 @@
 #include <charconv>
 #include <optional>
 #include <deque>
+#include <vector>
 #include <algorithm>
 
 #include "rapidyenc/rapidyenc.h"
+#include "overview.h"
+#include "uring.h"
 
 /* Constants */
 #define YENC_LINESIZE    128
@@ -43,7 +46,8 @@
 #define NNTP_HEAD                     221
 #define NNTP_BODY                     222
 #define NNTP_STAT                     223
-#define NNTP_MULTILINE                NNTP_BODY, NNTP_ARTICLE, NNTP_HEAD, NNTP_CAPABILITIES
+#define NNTP_OVERVIEW                 224
+#define NNTP_MULTILINE                NNTP_BODY, NNTP_ARTICLE, NNTP_HEAD, NNTP_CAPABILITIES, NNTP_OVERVIEW
 
 /* The =yend line cannot be crazy long */
 #define YENC_MAX_TAIL_BYTES 256
@@ -103,6 +107,7 @@
 /* Functions */
 bool yenc_init(PyObject *);
 PyObject* yenc_encode(PyObject *, PyObject*);
+PyObject* decode_utf8_with_fallback(std::string_view line);
 
 /*
  * A request that has been sent and whose response has not yet been decoded.
@@ -115,6 +120,7 @@ PyObject* yenc_encode(PyObject *, PyObject*);
 typedef struct {
 	PyObject* context; // opaque to us, handed back as NNTPResponse.context
 	PyObject* sink;    // FileWriter to stream into, or NULL to build a bytearray
+	Py_ssize_t offset; // where a UU body starts in the sink; yEnc carries its own
 } PendingRequest;
 
 typedef struct {
@@ -142,6 +148,10 @@ typedef struct {
 	Py_ssize_t total;
 	std::optional<uint32_t> crc_expected;
 	PyObject* message;
+	// Columns of an overview (224) response while it arrives, and the Overview they
+	// become once it is complete. Only ever set for overview responses.
+	OverviewColumns* overview_columns;
+	PyObject* overview;
 	RapidYencDecoderState state;
 	int status_code;
 	uint32_t crc;
@@ -174,6 +184,37 @@ typedef struct {
 	char* staging;
 	Py_ssize_t staging_size;
 	Py_ssize_t staging_used;
+	// With a FileWriter on io_uring, the flush in flight writes from the spare while
+	// decoding fills staging. write_response is held until the write is settled.
+	char* staging_spare;
+	NNTPResponse* write_response;
+	Py_ssize_t write_length;
+	long long write_offset;
+	UringWrite write;
+	// COMPRESS DEFLATE. Once enabled the buffer protocol exports the compressed buffer
+	// instead of the ring, and process() inflates from one into the other. The input
+	// zlib could not take yet stays at the front of it for the next call.
+	PyObject* inflater; // zlib.decompressobj, NULL while the stream is uncompressed
+	char* compressed;
+	Py_ssize_t compressed_used;
+	Py_ssize_t compressed_bytes; // totals, for the compression ratio
+	Py_ssize_t decompressed_bytes;
 } Decoder;
 
+extern PyTypeObject DecoderType;
+extern PyTypeObject NNTPResponseType;
+
+/*
+ * The Decoder as seen from C++, for the NNTPConnection engine that drives one without
+ * going through Python. The same operations as the buffer protocol, process(),
+ * expect() and iteration, minus the argument checking.
+ */
+char* decoder_free_space(Decoder *self, Py_ssize_t &available);
+bool decoder_process(Decoder *self, Py_ssize_t length); // false with an exception set
+void decoder_expect(Decoder *self, PyObject *context, PyObject *sink, Py_ssize_t offset = 0);
+NNTPResponse* decoder_next(Decoder *self); // new reference, or NULL when none is complete
+bool decoder_check_sink(PyObject *sink); // a FileWriter or NULL, else TypeError
+bool decoder_check_offset(Py_ssize_t offset); // not negative, else ValueError
+bool decoder_message_id(PyObject *item, std::string_view &message_id); // borrows from item
+
 #endif //SABCTOOLS_YENC_H
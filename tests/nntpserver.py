@@ -0,0 +1,334 @@
+"""A stand-in NNTP server for tests and benchmarks, serving synthetic articles from memory.
+
+Runs an asyncio server on a background thread, so a test can drive a real socket
+against it from the main thread:
+
+    with NNTPServer({"part1@x": yenc_article(data, "file.bin")}) as server:
+        sock = socket.create_connection(server.address)
+
+Latency, bandwidth caps, missing articles and truncated bodies can be switched on to
+load-test a client, and `python -m tests.nntpserver` serves synthetic articles from a
+process of its own, so the server's CPU stays out of the client's measurements.
+"""
+
+import argparse
+import asyncio
+import binascii
+import random
+import re
+import ssl
+import sys
+import threading
+from typing import Dict, List, Mapping, Optional, Tuple
+
+import sabctools
+
+HOST = "127.0.0.1"
+
+
+def yenc_article(data: bytes, name: str, part: int = 0, begin: int = 0, size: Optional[int] = None) -> bytes:
+    """The body of a yEnc article, lines CRLF-terminated, before dot-stuffing.
+    A part number makes it a multipart article starting at `begin` within a file
+    of `size` bytes."""
+    encoded, crc = sabctools.yenc_encode(data)
+    if part:
+        head = b"=ybegin part=%d line=128 size=%d name=%s\r\n" % (part, size or len(data), name.encode())
+        head += b"=ypart begin=%d end=%d\r\n" % (begin + 1, begin + len(data))
+        tail = b"=yend size=%d part=%d pcrc32=%08x\r\n" % (len(data), part, crc)
+    else:
+        head = b"=ybegin line=128 size=%d name=%s\r\n" % (len(data), name.encode())
+        tail = b"=yend size=%d crc32=%08x\r\n" % (len(data), crc)
+    return head + encoded + b"\r\n" + tail
+
+
+def uu_article(data: bytes, name: str) -> bytes:
+    """The body of a UU-encoded article, before dot-stuffing. A last line of 14 bytes
+    starts with a '.', so some sizes exercise dot-stuffing by themselves."""
+    lines = [b"begin 644 %s" % name.encode()]
+    for start in range(0, len(data), 45):
+        lines.append(binascii.b2a_uu(data[start : start + 45], backtick=True).rstrip(b"\n"))
+    lines += [b"`", b"end", b""]
+    return b"\r\n".join(lines)
+
+
+def leading_dots(body: bytes) -> bytes:
+    """Un-escape every "=n" that starts a yEnc line back to a bare '.'. Both decode to
+    the same byte, but only the bare form needs dot-stuffing on the wire, which the
+    encoder otherwise always avoids."""
+    return re.sub(rb"(?m)^=n", b".", body)
+
+
+def dot_stuff(body: bytes) -> bytes:
+    stuffed = body.replace(b"\r\n.", b"\r\n..")
+    return b"." + stuffed if stuffed.startswith(b".") else stuffed
+
+
+class SyntheticArticles(Mapping):
+    """`count` articles of `size` bytes each, parts of one file, without holding them all.
+
+    Message-ids are "<n>@synthetic" for n from 0. Only `distinct` payloads are encoded,
+    and cycled through, so a soak run of many gigabytes costs a few megabytes here;
+    payloads() gives the file they add up to. yEnc articles are multipart, so a client
+    can write them at their offsets; `kind="uu"` gives single-part UU articles instead.
+    With `dot_lines`, yEnc lines that start with an escaped '.' send it bare instead.
+    """
+
+    def __init__(
+        self, count: int, size: int, kind: str = "yenc", distinct: int = 8, dot_lines: bool = False, seed: int = 0
+    ):
+        if kind not in ("yenc", "uu"):
+            raise ValueError("kind must be yenc or uu")
+        self.count = count
+        self.size = size
+        self.kind = kind
+        generator = random.Random(seed)
+        self._payloads = [generator.randbytes(size) for _ in range(distinct)]
+        self._encoded = []
+        for payload in self._payloads:
+            if kind == "uu":
+                self._encoded.append((uu_article(payload, "synthetic.bin"), 0))
+            else:
+                encoded, crc = sabctools.yenc_encode(payload)
+                if dot_lines:
+                    encoded = leading_dots(encoded)
+                self._encoded.append((encoded, crc))
+
+    def payload(self, number: int) -> bytes:
+        return self._payloads[number % len(self._payloads)]
+
+    def payloads(self):
+        for number in range(self.count):
+            yield self.payload(number)
+
+    def __getitem__(self, message_id: str) -> bytes:
+        number, _, domain = message_id.partition("@")
+        if domain != "synthetic" or not number.isdigit() or int(number) >= self.count:
+            raise KeyError(message_id)
+        number = int(number)
+        encoded, crc = self._encoded[number % len(self._encoded)]
+        if self.kind == "uu":
+            return encoded
+        begin = number * self.size
+        return (
+            b"=ybegin part=%d total=%d line=128 size=%d name=synthetic.bin\r\n"
+            % (number + 1, self.count, self.count * self.size)
+            + b"=ypart begin=%d end=%d\r\n" % (begin + 1, begin + self.size)
+            + encoded
+            + b"\r\n=yend size=%d part=%d pcrc32=%08x\r\n" % (self.size, number + 1, crc)
+        )
+
+    def __iter__(self):
+        return ("%d@synthetic" % number for number in range(self.count))
+
+    def __len__(self):
+        return self.count
+
+
+class NNTPServer:
+    """Answers AUTHINFO, GROUP, BODY, ARTICLE, STAT and QUIT.
+
+    `articles` maps message-ids, without angle brackets, to article bodies. Unknown
+    ones get a 430. With an `ssl_context` it speaks TLS from the first byte. Every
+    command received is recorded in `commands`, and `connections` counts the sessions
+    accepted.
+
+    To behave more like a provider under load: `latency` delays every response by that
+    many seconds, `bandwidth` caps each connection at that many bytes per second,
+    `missing_rate` answers that fraction of article requests with 430 whether or not
+    the article exists, and `truncate_rate` cuts that fraction of bodies short and hangs
+    up mid-way, as a dropped connection would. The random choices follow `seed`.
+    """
+
+    def __init__(
+        self,
+        articles: Mapping[str, bytes],
+        username: Optional[str] = None,
+        password: Optional[str] = None,
+        greeting: bytes = b"200 sabctools test server ready",
+        groups: Optional[Dict[str, Tuple[int, int]]] = None,
+        ssl_context: Optional[ssl.SSLContext] = None,
+        latency: float = 0.0,
+        bandwidth: int = 0,
+        missing_rate: float = 0.0,
+        truncate_rate: float = 0.0,
+        seed: int = 0,
+        port: int = 0,
+    ):
+        self.articles = articles
+        self.username = username
+        self.password = password
+        self.greeting = greeting
+        self.groups = groups or {}
+        self.ssl_context = ssl_context
+        self.latency = latency
+        self.bandwidth = bandwidth
+        self.missing_rate = missing_rate
+        self.truncate_rate = truncate_rate
+        self.random = random.Random(seed)
+        self.port = port
+        self.commands: List[bytes] = []
+        self.connections = 0
+        self.bytes_sent = 0
+        self.address: Tuple[str, int] = (HOST, 0)
+        self._loop: Optional[asyncio.AbstractEventLoop] = None
+        self._server: Optional[asyncio.AbstractServer] = None
+        self._thread: Optional[threading.Thread] = None
+        self._started = threading.Event()
+
+    def __enter__(self):
+        self._thread = threading.Thread(target=self._run, daemon=True)
+        self._thread.start()
+        self._started.wait()
+        return self
+
+    def __exit__(self, *args):
+        asyncio.run_coroutine_threadsafe(self._shutdown(), self._loop).result()
+        self._loop.call_soon_threadsafe(self._loop.stop)
+        self._thread.join()
+
+    async def _shutdown(self):
+        self._server.close()
+        sessions = [task for task in asyncio.all_tasks() if task is not asyncio.current_task()]
+        for task in sessions:
+            task.cancel()
+        await asyncio.gather(*sessions, return_exceptions=True)
+        await self._server.wait_closed()
+
+    def _run(self):
+        self._loop = asyncio.new_event_loop()
+        self._server = self._loop.run_until_complete(
+            asyncio.start_server(self._session, HOST, self.port, ssl=self.ssl_context)
+        )
+        self.address = self._server.sockets[0].getsockname()[:2]
+        self._started.set()
+        self._loop.run_forever()
+        self._loop.close()
+
+    def respond(self, command: bytes, state: dict) -> Tuple[bytes, bool]:
+        """The response to one command line, and whether to hang up after it"""
+        verb, _, argument = command.partition(b" ")
+        verb = verb.upper()
+
+        if verb == b"AUTHINFO":
+            kind, _, value = argument.partition(b" ")
+            if kind.upper() == b"USER":
+                state["user"] = value.decode()
+                return b"381 Password required\r\n", False
+            if kind.upper() == b"PASS":
+                if state.get("user") == self.username and value.decode() == self.password:
+                    state["authenticated"] = True
+                    return b"281 Authentication accepted\r\n", False
+                return b"481 Authentication failed\r\n", False
+            return b"501 Syntax error\r\n", False
+
+        if verb == b"QUIT":
+            return b"205 Bye\r\n", True
+
+        if self.username is not None and not state.get("authenticated"):
+            return b"480 Authentication required\r\n", False
+
+        if verb == b"GROUP":
+            name = argument.decode()
+            if name not in self.groups:
+                return b"411 No such group\r\n", False
+            first, last = self.groups[name]
+            return b"211 %d %d %d %s\r\n" % (last - first + 1, first, last, argument), False
+
+        if verb in (b"BODY", b"ARTICLE", b"HEAD", b"STAT"):
+            message_id = argument.strip(b"<>").decode()
+            body = self.articles.get(message_id)
+            if body is None or (self.missing_rate and self.random.random() < self.missing_rate):
+                return b"430 No such article\r\n", False
+            if verb in (b"BODY", b"ARTICLE") and self.truncate_rate and self.random.random() < self.truncate_rate:
+                return b"222 0 %s\r\n%s" % (argument, dot_stuff(body)[: self.random.randrange(len(body))]), True
+            if verb == b"STAT":
+                return b"223 0 %s\r\n" % argument, False
+            headers = b"Message-ID: %s\r\nSubject: test\r\n" % argument
+            if verb == b"HEAD":
+                return b"221 0 %s\r\n%s.\r\n" % (argument, headers), False
+            if verb == b"ARTICLE":
+                return b"220 0 %s\r\n%s\r\n%s.\r\n" % (argument, headers, dot_stuff(body)), False
+            return b"222 0 %s\r\n%s.\r\n" % (argument, dot_stuff(body)), False
+
+        return b"500 Unknown command\r\n", False
+
+    async def _session(self, reader: asyncio.StreamReader, writer: asyncio.StreamWriter):
+        self.connections += 1
+        state = {}
+        try:
+            writer.write(self.greeting + b"\r\n")
+            while True:
+                line = await reader.readline()
+                if not line:
+                    break
+                command = line.rstrip(b"\r\n")
+                self.commands.append(command)
+                response, hang_up = self.respond(command, state)
+                if self.latency:
+                    await asyncio.sleep(self.latency)
+                await self._send(writer, response)
+                if hang_up:
+                    if self.ssl_context:
+                        # Without a close_notify, as a dropped connection would. Also
+                        # keeps asyncio from holding the session open for its
+                        # shutdown timeout while it waits for the client's reply.
+                        writer.transport.abort()
+                    break
+        except (ConnectionError, asyncio.CancelledError):
+            # A client that hung up, or the server shutting down
+            pass
+        finally:
+            writer.close()
+
+    async def _send(self, writer: asyncio.StreamWriter, response: bytes):
+        if not self.bandwidth:
+            writer.write(response)
+            await writer.drain()
+            self.bytes_sent += len(response)
+            return
+        # Tenths of a second's worth at a time, so the cap holds within a response too
+        step = max(1, self.bandwidth // 10)
+        for start in range(0, len(response), step):
+            if start:
+                await asyncio.sleep(0.1)
+            writer.write(response[start : start + step])
+            await writer.drain()
+            self.bytes_sent += len(response[start : start + step])
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Serve synthetic articles until stdin closes")
+    parser.add_argument("--port", type=int, default=0)
+    parser.add_argument("--articles", type=int, default=1000, help="count of <n>@synthetic articles")
+    parser.add_argument("--size", type=int, default=716800, help="decoded bytes per article")
+    parser.add_argument("--kind", choices=("yenc", "uu"), default="yenc")
+    parser.add_argument("--dot-lines", action="store_true", help="send yEnc line-leading dots bare")
+    parser.add_argument("--tls", nargs=2, metavar=("CERTFILE", "KEYFILE"))
+    parser.add_argument("--latency", type=float, default=0.0, help="seconds before each response")
+    parser.add_argument("--bandwidth", type=int, default=0, help="bytes per second per connection")
+    parser.add_argument("--missing-rate", type=float, default=0.0)
+    parser.add_argument("--truncate-rate", type=float, default=0.0)
+    args = parser.parse_args()
+
+    context = None
+    if args.tls:
+        context = ssl.create_default_context(ssl.Purpose.CLIENT_AUTH)
+        context.load_cert_chain(certfile=args.tls[0], keyfile=args.tls[1])
+    articles = SyntheticArticles(args.articles, args.size, args.kind, dot_lines=args.dot_lines)
+    server = NNTPServer(
+        articles,
+        ssl_context=context,
+        latency=args.latency,
+        bandwidth=args.bandwidth,
+        missing_rate=args.missing_rate,
+        truncate_rate=args.truncate_rate,
+        port=args.port,
+    )
+    with server:
+        # The port for whoever started us, once it is listening
+        print(server.address[1], flush=True)
+        sys.stdin.read()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,133 @@
+import zlib
+from io import BytesIO
+
+import pytest
+
+from tests.testsupport import *
+
+ARTICLES = ["test_regular.yenc", "test_regular_2.yenc", "test_article.yenc"]
+HEAD = b"221 0 <id@host>\r\nSubject: test\r\nFrom: someone\r\n.\r\n"
+
+
+def deflate(payload: bytes, chunk: int, wbits: int = -15) -> bytes:
+    """Deflate the way a server does under COMPRESS DEFLATE: one endless stream, sync
+    flushed after every write so each one can be inflated on arrival"""
+    compressor = zlib.compressobj(wbits=wbits)
+    out = b""
+    for start in range(0, len(payload), chunk):
+        out += compressor.compress(payload[start : start + chunk])
+        out += compressor.flush(zlib.Z_SYNC_FLUSH)
+    return out
+
+
+def feed(decoder, wire: bytes, chunk: int):
+    responses = []
+    source = BytesIO(wire)
+    while True:
+        view = memoryview(decoder)
+        n = source.readinto(view[:chunk])
+        view.release()
+        if not n:
+            break
+        decoder.process(n)
+        responses.extend(decoder)
+    return responses
+
+
+def summary(responses):
+    return [(r.status_code, bytes(r.data) if r.data else None, r.lines, r.crc) for r in responses]
+
+
+@pytest.fixture
+def payload() -> bytes:
+    return b"".join(bytes(read_plain_yenc_file(name)) for name in ARTICLES) + HEAD
+
+
+@pytest.mark.parametrize("read_size", [1, 97, 4096, 1 << 20])
+def test_same_responses_as_uncompressed(payload, read_size):
+    expected = summary(feed(sabctools.Decoder(64 * 1024), payload, 1 << 20))
+
+    decoder = sabctools.Decoder(64 * 1024)
+    decoder.enable_compression()
+    wire = deflate(payload, 16 * 1024)
+    assert summary(feed(decoder, wire, read_size)) == expected
+
+    assert decoder.compressed
+    assert decoder.compressed_bytes == len(wire)
+    assert decoder.decompressed_bytes == len(payload)
+
+
+def test_inflating_beyond_the_ring():
+    """A highly compressible burst inflates to several times the ring in one process()
+    call, so zlib has to be held back and the ring drained as it fills"""
+    lines = b"".join(b"%d\tsubject\tfrom\tdate\t<%d@x>\t\t100\t1\r\n" % (n, n) for n in range(20000))
+    payload = b"224 overview\r\n" + lines + b".\r\n"
+    wire = deflate(payload, len(payload))
+    assert len(payload) > 5 * len(wire)
+
+    decoder = sabctools.Decoder(4096)
+    decoder.enable_compression()
+    responses = feed(decoder, wire, 1 << 20)
+    assert len(responses) == 1
+    assert len(responses[0].overview) == 20000
+    assert decoder.decompressed_bytes == len(payload)
+
+
+def test_zlib_wrapped_stream(payload):
+    decoder = sabctools.Decoder(64 * 1024)
+    decoder.enable_compression(wbits=15)
+    responses = feed(decoder, deflate(payload, 4096, wbits=15), 1000)
+    assert [r.status_code for r in responses] == [222, 222, 220, 221]
+
+
+def test_bytes_after_the_206_are_compressed():
+    """They arrived after compression started, so they must be inflated, not decoded"""
+    payload = HEAD
+    wire = b"206 Compression active\r\n" + deflate(payload, 16)
+
+    decoder = sabctools.Decoder(4096)
+    view = memoryview(decoder)
+    view[: len(wire)] = wire
+    view.release()
+    decoder.process(len(wire))
+    # Only the 206 can be told apart: everything after it is noise until inflated
+    first = next(decoder)
+    assert first.status_code == 206
+
+    decoder.enable_compression()
+    responses = list(decoder)
+    assert [r.status_code for r in responses] == [221]
+    assert responses[0].lines == ["Subject: test", "From: someone"]
+
+
+def test_pending_requests_carry_over(payload):
+    decoder = sabctools.Decoder(64 * 1024)
+    for name in ARTICLES + ["head"]:
+        decoder.expect(name)
+    decoder.enable_compression()
+    responses = feed(decoder, deflate(payload, 8192), 5000)
+    assert [r.context for r in responses] == ARTICLES + ["head"]
+
+
+def test_corrupt_stream_raises():
+    decoder = sabctools.Decoder(4096)
+    decoder.enable_compression(wbits=15)
+    view = memoryview(decoder)
+    view[:8] = b"\xff" * 8
+    view.release()
+    with pytest.raises(zlib.error):
+        decoder.process(8)
+
+
+def test_enable_twice():
+    decoder = sabctools.Decoder(4096)
+    decoder.enable_compression()
+    with pytest.raises(ValueError):
+        decoder.enable_compression()
+
+
+def test_uncompressed_by_default():
+    decoder = sabctools.Decoder(4096)
+    assert not decoder.compressed
+    assert decoder.compressed_bytes == 0
+    assert decoder.decompressed_bytes == 0
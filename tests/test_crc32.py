@@ -1,3 +1,8 @@
+import array
+import os
+import random
+import zlib
+
 import pytest
 import sabctools
 
@@ -78,3 +83,127 @@ def test_crc32_xpown_expected(n, expected):
 )
 def test_crc32_xpow8n_expected(n, expected):
     assert sabctools.crc32_xpow8n(n) == expected
+
+
+def test_crc32_many():
+    buffers = [os.urandom(size) for size in (0, 1, 15, 64, 1000, 65536, 100_003)]
+    views = [bytearray(buffers[3]), memoryview(buffers[4])[7:], array.array("I", buffers[5])]
+    assert sabctools.crc32_many(buffers + views) == [zlib.crc32(b) for b in buffers + views]
+    assert sabctools.crc32_many(tuple(buffers)) == sabctools.crc32_many(buffers)
+    assert sabctools.crc32_many([]) == []
+
+
+def test_crc32_many_rejects_non_buffers():
+    with pytest.raises(TypeError):
+        sabctools.crc32_many([b"fine", "text"])
+    with pytest.raises(TypeError):
+        sabctools.crc32_many(5)
+
+
+@pytest.fixture(scope="module")
+def payload():
+    return os.urandom(9 * 1024 * 1024 + 123)
+
+
+@pytest.mark.parametrize("threads", [1, 2, 3, 0])
+def test_crc32_of_a_buffer(payload, threads):
+    assert sabctools.crc32(payload, threads=threads) == zlib.crc32(payload)
+    assert sabctools.crc32(bytearray(payload), 1000, 5_000_000, threads=threads) == zlib.crc32(payload[1000:5_001_000])
+    # A running CRC carries on, as zlib's value argument does
+    assert sabctools.crc32(payload, 100, init=0x12345678, threads=threads) == zlib.crc32(payload[100:], 0x12345678)
+
+
+@pytest.mark.parametrize("threads", [1, 4])
+def test_crc32_of_a_file(payload, tmp_path, threads):
+    path = tmp_path / "file.bin"
+    path.write_bytes(payload)
+    assert sabctools.crc32(path, threads=threads) == zlib.crc32(payload)
+    assert sabctools.crc32(str(path), offset=7, length=8_000_000, threads=threads) == zlib.crc32(payload[7:8_000_007])
+    assert sabctools.crc32(path, offset=len(payload)) == 0
+
+
+def test_crc32_small_and_empty(tmp_path):
+    assert sabctools.crc32(b"") == 0
+    assert sabctools.crc32(b"Hello world!") == 0x1B851995
+    assert sabctools.crc32(memoryview(b"Hello world!")[6:], threads=8) == zlib.crc32(b"world!")
+    empty = tmp_path / "empty"
+    empty.write_bytes(b"")
+    assert sabctools.crc32(empty, threads=4) == 0
+
+
+def test_crc32_argument_checks(tmp_path):
+    with pytest.raises(ValueError):
+        sabctools.crc32(b"abc", 4)
+    with pytest.raises(ValueError):
+        sabctools.crc32(b"abc", 1, 3)
+    with pytest.raises(ValueError):
+        sabctools.crc32(b"abc", -1)
+    with pytest.raises(ValueError):
+        sabctools.crc32(b"abc", length=-1)
+    with pytest.raises(ValueError):
+        sabctools.crc32(b"abc", threads=-1)
+    with pytest.raises(TypeError):
+        sabctools.crc32(5)
+    with pytest.raises(FileNotFoundError) as exc:
+        sabctools.crc32(tmp_path / "missing")
+    assert exc.value.filename == str(tmp_path / "missing")
+
+
+def displaced_blocks(block_size: int, count: int, size: int, seed: int = 0):
+    """Random data with `count` distinct blocks planted at unaligned offsets"""
+    rng = random.Random(seed)
+    data = bytearray(rng.randbytes(size))
+    blocks = [rng.randbytes(block_size) for _ in range(count)]
+    offsets = sorted(rng.sample(range(0, size - block_size, block_size + 1), count))
+    for offset, block in zip(offsets, blocks):
+        data[offset : offset + block_size] = block
+    return bytes(data), blocks, offsets
+
+
+@pytest.mark.parametrize("block_size", [1, 64, 1000, 65537])
+def test_scan_blocks_finds_displaced_blocks(block_size):
+    data, blocks, offsets = displaced_blocks(block_size, 6, 2_000_000 + 17)
+    crcs = [zlib.crc32(block) for block in blocks]
+    hits = sabctools.scan_blocks(data, block_size, list(reversed(crcs)))
+    expected = [(offset, len(crcs) - 1 - index) for index, offset in enumerate(offsets)]
+    assert [hit for hit in hits if hit in expected] == expected
+    # Anything else is a genuine chance match of the rolling window
+    for offset, index in hits:
+        assert zlib.crc32(data[offset : offset + block_size]) == crcs[len(crcs) - 1 - index]
+
+
+def test_scan_blocks_in_a_file(tmp_path):
+    """Larger than the read size, so blocks straddle refills"""
+    data, blocks, offsets = displaced_blocks(300_000, 20, 9_500_000, seed=1)
+    path = tmp_path / "joined.bin"
+    path.write_bytes(data)
+    crcs = [zlib.crc32(block) for block in blocks]
+    assert sabctools.scan_blocks(path, 300_000, crcs) == list(zip(offsets, range(len(crcs))))
+    assert sabctools.scan_blocks(str(path), 300_000, iter(crcs[:1])) == [(offsets[0], 0)]
+
+
+def test_scan_blocks_skips_past_a_hit():
+    block = b"\x55" * 100
+    data = os.urandom(50) + block * 3 + b"\x55" * 50
+    assert sabctools.scan_blocks(data, 100, [zlib.crc32(block), zlib.crc32(block)]) == [
+        (50, 0),
+        (50, 1),
+        (150, 0),
+        (150, 1),
+        (250, 0),
+        (250, 1),
+    ]
+
+
+def test_scan_blocks_edges(tmp_path):
+    assert sabctools.scan_blocks(b"short", 10, [0]) == []
+    assert sabctools.scan_blocks(b"exact", 5, [zlib.crc32(b"exact")]) == [(0, 0)]
+    assert sabctools.scan_blocks(os.urandom(1000), 10, []) == []
+    with pytest.raises(ValueError):
+        sabctools.scan_blocks(b"data", 0, [0])
+    with pytest.raises(OverflowError):
+        sabctools.scan_blocks(b"data", 2, [1 << 32])
+    with pytest.raises(TypeError):
+        sabctools.scan_blocks(b"data", 2, 5)
+    with pytest.raises(FileNotFoundError):
+        sabctools.scan_blocks(tmp_path / "missing", 2, [0])
@@ -273,6 +273,58 @@ def test_uu_length(length: int):
     assert response.data == expected
 
 
+@pytest.mark.parametrize("length", [46, 720, 4096 * 45 + 1, 700_000])
+@pytest.mark.parametrize("backtick", [False, True])
+def test_uu_multiline(length: int, backtick: bool):
+    """Long enough to go through the vector paths and to outgrow the first allocation"""
+    expected = os.urandom(length)
+    lines = [binascii.b2a_uu(expected[i : i + 45], backtick=backtick).rstrip(b"\n") for i in range(0, length, 45)]
+    body = b"\r\n".join(b"." + line if line.startswith(b".") else line for line in lines)
+    data_plain = b"222 0 <foo@bar>\r\nbegin 644 file.bin\r\n" + body + b"\r\n`\r\nend\r\n.\r\n"
+    decoder = sabctools.Decoder(len(data_plain))
+    n = io.BytesIO(data_plain).readinto(decoder)
+    decoder.process(n)
+    response = next(decoder)
+    assert response.format is sabctools.EncodingFormat.UU
+    assert response.bytes_decoded == length
+    assert response.data == expected
+    assert response.crc == crc32(expected)
+
+
+def test_uu_characters_are_taken_modulo_64():
+    """Out-of-range characters decode as the scalar code always has, vector path or not"""
+    line = bytes(range(0x41, 0x7D))
+    expected = bytearray()
+    for i in range(0, 60, 4):
+        c = [(ch - 0x20) & 0x3F for ch in line[i : i + 4]]
+        expected += bytes([(c[0] << 2 | c[1] >> 4) & 0xFF, (c[1] << 4 | c[2] >> 2) & 0xFF, (c[2] << 6 | c[3]) & 0xFF])
+    data_plain = b"222 0 <foo@bar>\r\nbegin 644 x\r\nM" + line + b"\r\nend\r\n.\r\n"
+    decoder = sabctools.Decoder(len(data_plain))
+    n = io.BytesIO(data_plain).readinto(decoder)
+    decoder.process(n)
+    assert next(decoder).data == expected
+
+
+def test_uu_a_long_first_line_reserves_by_its_length_character():
+    """A 200 KB line still decodes to at most 45 bytes, and is reserved for as such"""
+    import tracemalloc
+
+    data = os.urandom(45)
+    line = binascii.b2a_uu(data).rstrip(b"\n") + b"A" * 200_000
+    data_plain = b"222 0 <foo@bar>\r\nbegin 644 x\r\n" + line + b"\r\nend\r\n.\r\n"
+    decoder = sabctools.Decoder(len(data_plain))
+    n = io.BytesIO(data_plain).readinto(decoder)
+    tracemalloc.start()
+    try:
+        decoder.process(n)
+        response = next(decoder)
+        peak = tracemalloc.get_traced_memory()[1]
+    finally:
+        tracemalloc.stop()
+    assert response.data == data
+    assert peak < 64 << 20
+
+
 # Tests for super-invalid inputs to ensure decoder doesn't crash
 
 
@@ -545,3 +597,25 @@ class TestRingRewind:
         reference = self.feed(self.SIZE)[1]
         for read_size in (1024, 4096, 48 * 1024, 100_000):
             assert self.feed(read_size)[1] == reference, "read_size=%d decoded differently" % read_size
+
+
+@pytest.mark.parametrize("read_size", [997, 16383, 16384, 70001, 1 << 20])
+def test_crc_across_decode_blocks(read_size: int):
+    """The CRC is folded in as each block is decoded, so escapes, dot-stuffed lines and
+    reads that split either across a block boundary must not change it"""
+    from tests.nntpserver import dot_stuff, yenc_article
+
+    # 0x04, 0xd6, 0xe0, 0xe3 and 0x13 encode to ".", NUL, LF, CR and "="
+    data = b"".join(os.urandom(61) + b"\x04\xd6\xe0\xe3\x13" * (n % 7) for n in range(4000))
+    wire = b"222 0 <crc@test>\r\n" + dot_stuff(yenc_article(data, "crc.bin")) + b".\r\n"
+
+    decoder = sabctools.Decoder(1 << 20)
+    responses = []
+    for start in range(0, len(wire), read_size):
+        chunk = wire[start : start + read_size]
+        memoryview(decoder)[: len(chunk)] = chunk
+        decoder.process(len(chunk))
+        responses.extend(decoder)
+    assert len(responses) == 1
+    assert responses[0].data == data
+    assert responses[0].crc == responses[0].crc_expected == crc32(data)
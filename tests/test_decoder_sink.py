@@ -1,3 +1,4 @@
+import errno
 import gc
 import glob
 import os
@@ -7,6 +8,7 @@ from io import BytesIO
 import pytest
 
 from tests.testsupport import *
+from tests.nntpserver import dot_stuff, uu_article
 
 
 def build_article(
@@ -43,9 +45,13 @@ def feed(decoder, wire: bytes, chunk: int = 0):
     return responses
 
 
-@pytest.fixture
-def writer(tmp_path):
-    target = sabctools.FileWriter(str(tmp_path / "target.bin"))
+@pytest.fixture(
+    params=[{}, {"io_uring": True}, {"direct": True}, {"io_uring": True, "writeback": 64 * 1024}],
+    ids=["pwrite", "io_uring", "direct", "writeback"],
+)
+def writer(tmp_path, request):
+    """Every sink test runs against each way of writing; where one is unavailable it is pwrite again"""
+    target = sabctools.FileWriter(str(tmp_path / "target.bin"), **request.param)
     yield target
     target.close()
 
@@ -96,6 +102,58 @@ class TestPairing:
         assert decoder.expected == 1
 
 
+class TestQueueRequests:
+    """One call builds the commands for a batch and records all of it, so the request
+    side of a pipelined connection is a single native call and a single send"""
+
+    def test_builds_the_commands_and_pairs_the_responses(self, writer):
+        payload = os.urandom(3000)
+        decoder = sabctools.Decoder(65536)
+        wire = decoder.queue_requests(
+            b"BODY <%s>\r\n", [("a@b", "first", writer), (b"c@d", "second"), ("e@f", "third", None)]
+        )
+        assert wire == b"BODY <a@b>\r\nBODY <c@d>\r\nBODY <e@f>\r\n"
+        assert decoder.pending == ("first", "second", "third")
+
+        responses = feed(decoder, build_article(payload) * 3)
+        assert [response.context for response in responses] == ["first", "second", "third"]
+        assert responses[0].data is None, "the first went to its sink"
+        assert bytes(responses[1].data) == payload
+
+    def test_an_empty_batch(self):
+        decoder = sabctools.Decoder(4096)
+        assert decoder.queue_requests(b"STAT <%s>\r\n", []) == b""
+        assert decoder.expected == 0
+
+    @pytest.mark.parametrize(
+        "requests",
+        [
+            [("ok@x", "ctx"), ("bad@x", "ctx", object())],
+            [("ok@x", "ctx"), (123, "ctx")],
+            [("ok@x", "ctx"), ("a@b>\r\nQUIT\r\n<c@d", "ctx")],
+            [("ok@x", "ctx"), ("only the id",)],
+            [("ok@x", "ctx"), ["not", "a tuple"]],
+            [("ok@x", "ctx"), ("bad@x", "ctx", None, -1)],
+            [("ok@x", "ctx"), ("bad@x", "ctx", None, "zero")],
+            [("ok@x", "ctx"), ("bad@x", "ctx", None, 0, "extra")],
+        ],
+    )
+    def test_a_bad_item_records_nothing(self, requests):
+        """Checked before anything is recorded, so nothing is pending for commands the
+        caller never got to send"""
+        decoder = sabctools.Decoder(4096)
+        decoder.expect("earlier")
+        with pytest.raises((TypeError, ValueError)):
+            decoder.queue_requests(b"BODY <%s>\r\n", requests)
+        assert decoder.pending == ("earlier",)
+
+    @pytest.mark.parametrize("template", [b"BODY <msgid>\r\n", b"BODY <%s> %s\r\n"])
+    def test_template_needs_one_placeholder(self, template):
+        decoder = sabctools.Decoder(4096)
+        with pytest.raises(ValueError):
+            decoder.queue_requests(template, [("a@b", "ctx")])
+
+
 class TestSinkOutput:
     def test_matches_the_bytearray_path_exactly(self, writer):
         """The sink is only worth having if it produces the same bytes"""
@@ -266,18 +324,95 @@ class TestSinkErrors:
         assert response.bytes_decoded == len(payload)
         assert open(writer.path, "rb").read() == payload, "the data is still written, for par2"
 
-    def test_uu_falls_back_to_a_bytearray(self, writer):
-        """uu carries no offsets, so there is nowhere to stream it to. The sink is
-        ignored and the caller gets data as usual."""
+
+def uu_wire(data: bytes, name: str = "file.bin", end: bool = True) -> bytes:
+    body = dot_stuff(uu_article(data, name))
+    if not end:
+        body = body[: body.rindex(b"`\r\n")]
+    return b"222 0 <%s>\r\n" % name.encode() + body + b".\r\n"
+
+
+class TestUUSink:
+    """UU carries no offsets, so a body is written sequentially from the offset given
+    to expect(): the start of the file for a single-part post"""
+
+    def test_matches_the_bytearray_path(self, writer):
         data = read_uu_file("logo_full.nntp")
         decoder = sabctools.Decoder(len(data))
-        decoder.expect("article", writer)
-        response = feed(decoder, bytes(data))[0]
+        decoder.expect("bytearray")
+        decoder.expect("sink", writer)
+        plain, streamed = feed(decoder, bytes(data) * 2)
         writer.close()
 
-        assert response.format is sabctools.EncodingFormat.UU
-        assert response.data is not None
-        assert os.path.getsize(writer.path) == 0
+        assert streamed.format is sabctools.EncodingFormat.UU
+        assert streamed.data is None
+        assert streamed.bytes_decoded == plain.bytes_decoded
+        assert streamed.crc == plain.crc
+        with open(writer.path, "rb") as f:
+            assert f.read() == bytes(plain.data)
+
+    @pytest.mark.parametrize("chunk", [0, 1000])
+    def test_body_larger_than_the_staging_buffer(self, writer, chunk):
+        payload = os.urandom(1_500_000 + 7)
+        decoder = sabctools.Decoder(256 * 1024)
+        decoder.expect("big", writer)
+        response = feed(decoder, uu_wire(payload), chunk)[0]
+        writer.close()
+
+        assert response.data is None
+        assert response.bytes_decoded == len(payload)
+        assert response.crc == crc32(payload)
+        with open(writer.path, "rb") as f:
+            assert f.read() == payload
+
+    def test_parts_at_the_given_offsets(self, writer):
+        payload = os.urandom(100_000)
+        bounds = [0, 30_000, 70_000, 100_000]
+        decoder = sabctools.Decoder(65536)
+        wire = b""
+        # The last part first, and through queue_requests, which takes the offset too
+        for number in reversed(range(3)):
+            begin, end = bounds[number], bounds[number + 1]
+            decoder.queue_requests(b"BODY <%s>\r\n", [("part%d@uu" % number, number, writer, begin)])
+            wire += uu_wire(payload[begin:end], "part%d" % number)
+        feed(decoder, wire)
+        writer.close()
+
+        with open(writer.path, "rb") as f:
+            assert f.read() == payload
+
+    def test_a_body_without_an_end_line_is_still_written(self, writer):
+        payload = os.urandom(10_000)
+        decoder = sabctools.Decoder(65536)
+        decoder.expect("cut", writer, offset=5)
+        response = feed(decoder, uu_wire(payload, end=False))[0]
+        writer.close()
+
+        assert response.bytes_decoded == len(payload)
+        with open(writer.path, "rb") as f:
+            assert f.read() == bytes(5) + payload
+
+    def test_long_lines_decode_only_as_far_as_their_length_character(self, writer):
+        # Each line says it holds one byte but carries 4000 characters; only that byte
+        # may land in the staging buffer, however much of the line follows it
+        body = b"begin 644 x\r\n" + (b"!" + b"A" * 4000 + b"\r\n") * 200 + b"`\r\nend\r\n"
+        wire = b"222 0 <x>\r\n" + body + b".\r\n"
+        decoder = sabctools.Decoder(65536)
+        decoder.expect("plain")
+        decoder.expect("x", writer)
+        plain, streamed = feed(decoder, wire * 2)
+        writer.close()
+
+        assert plain.bytes_decoded == streamed.bytes_decoded == 200
+        assert bytes(plain.data) == bytes([0x86]) * 200
+        with open(writer.path, "rb") as f:
+            assert f.read() == bytes(plain.data)
+
+    def test_a_negative_offset_is_refused(self, writer):
+        decoder = sabctools.Decoder(4096)
+        with pytest.raises(ValueError):
+            decoder.expect("ctx", writer, -1)
+        assert decoder.expected == 0
 
 
 class TestGarbageCollection:
@@ -501,3 +636,77 @@ class TestSinkError:
         assert response.sink_error is not None
         gc.collect()
         assert str(response.sink_error)  # still usable after a collection
+
+
+@pytest.mark.skipif(not sys.platform.startswith("linux"), reason="io_uring is Linux only")
+class TestIoUring:
+    """Streamed writes are submitted and settled later, but a response must still not
+    reach the caller before its last write has succeeded or failed"""
+
+    @pytest.fixture(autouse=True)
+    def need_a_ring(self, tmp_path):
+        if not sabctools.FileWriter(str(tmp_path / "probe.bin"), io_uring=True).io_uring:
+            pytest.skip("io_uring is not available here")
+
+    def test_a_full_disk_is_reported_on_the_response(self):
+        target = sabctools.FileWriter("/dev/full", io_uring=True)
+        decoder = sabctools.Decoder(65536)
+        decoder.expect("article", target)
+        response = feed(decoder, build_article(b"x" * 5000))[0]
+        target.close()
+
+        assert response.sink_failed is True
+        assert isinstance(response.sink_error, OSError)
+        assert response.sink_error.errno == errno.ENOSPC
+
+    def test_a_failure_in_an_early_piece_is_not_lost(self):
+        """Every flush of a large body fails, and the response is delivered after the
+        last one; the failure of the first still has to show"""
+        target = sabctools.FileWriter("/dev/full", io_uring=True)
+        decoder = sabctools.Decoder(64 * 1024)
+        decoder.expect("big", target)
+        decoder.expect("next", target)
+        wire = build_article(b"y" * (1024 * 1024), name="a.bin") + build_article(b"z" * 1000, name="b.bin")
+        responses = feed(decoder, wire)
+        target.close()
+
+        assert [r.context for r in responses] == ["big", "next"]
+        assert all(r.sink_failed for r in responses)
+
+    def test_close_waits_for_submitted_writes(self, tmp_path):
+        target = sabctools.FileWriter(str(tmp_path / "target.bin"), io_uring=True)
+        payload = os.urandom(1024 * 1024)
+        decoder = sabctools.Decoder(8 << 20)
+        for index in range(4):
+            decoder.expect(index, target)
+        wire = b"".join(build_article(payload, begin=i * len(payload), total=4 * len(payload)) for i in range(4))
+
+        # Fed but not iterated, so the last write of the last article is still unsettled
+        view = memoryview(decoder)
+        view[: len(wire)] = wire
+        view.release()
+        decoder.process(len(wire))
+        target.close()
+
+        assert os.path.getsize(target.path) == 4 * len(payload)
+        assert all(not r.sink_failed for r in decoder)
+        with open(target.path, "rb") as f:
+            assert f.read() == payload * 4
+
+    def test_a_decoder_dropped_with_a_write_in_flight(self, tmp_path):
+        """The spare buffer is being written from, so it must outlive the write"""
+        target = sabctools.FileWriter(str(tmp_path / "target.bin"), io_uring=True)
+        payload = os.urandom(300_000)
+        decoder = sabctools.Decoder(1 << 20)
+        decoder.expect("article", target)
+        wire = build_article(payload)
+        view = memoryview(decoder)
+        view[: len(wire)] = wire
+        view.release()
+        decoder.process(len(wire))
+        del decoder
+        gc.collect()
+        target.close()
+
+        with open(target.path, "rb") as f:
+            assert f.read() == payload
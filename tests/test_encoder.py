@@ -1,3 +1,8 @@
+import mmap
+import os
+
+import pytest
+
 from tests.testsupport import *
 
 
@@ -5,3 +10,359 @@ def test_encoder():
     output, crc = sabctools.yenc_encode(b"Hello world!")
     assert output == b"r\x8f\x96\x96\x99J\xa1\x99\x9c\x96\x8eK"
     assert crc == 0x1B851995
+
+
+def awkward_payload(size: int) -> bytes:
+    """Random bytes heavy in the characters yEnc treats specially: the escaped ones,
+    and the whitespace that must not end a line"""
+    special = b"\x00\n\r=\t .\xd6\xe0\xe3\x13\x1f"
+    noise = os.urandom(size)
+    return bytes(special[b % len(special)] if b < 96 else b for b in noise)
+
+
+@pytest.mark.parametrize("chunk", [1, 7, 127, 128, 129, 4096, 100_000])
+@pytest.mark.parametrize("line_size", [128, 64, 997, 10])
+def test_chunks_match_a_single_call(chunk, line_size):
+    """Below 12 columns rapidyenc uses its generic encoder, above it the SIMD ones"""
+    data = awkward_payload(50_000)
+    whole = sabctools.Encoder(line_size)
+    expected = whole.encode(data, is_end=True)
+
+    encoder = sabctools.Encoder(line_size=line_size)
+    pieces = []
+    for start in range(0, len(data), chunk):
+        pieces.append(encoder.encode(data[start : start + chunk], is_end=start + chunk >= len(data)))
+    assert b"".join(pieces) == expected
+    assert encoder.crc == whole.crc == crc32(data)
+    assert encoder.bytes_in == len(data)
+    assert encoder.bytes_out == len(expected)
+    assert encoder.ended
+
+
+@pytest.mark.parametrize("offset", [0, 1, 63, 16383, 16385])
+def test_blocks_join_wherever_the_input_starts(offset):
+    """Large inputs are encoded and hashed block by block, with blocks aligned to the
+    source address; where that alignment falls must not show in the output"""
+    data = awkward_payload(60_000)
+    view = memoryview(data)[offset:]
+    encoder = sabctools.Encoder()
+    encoded = encoder.encode(view, is_end=True)
+
+    reference = sabctools.Encoder()
+    pieces = [
+        reference.encode(view[start : start + 4096], is_end=start + 4096 >= len(view))
+        for start in range(0, len(view), 4096)
+    ]
+    assert encoded == b"".join(pieces)
+    assert encoder.crc == crc32(view)
+
+
+def test_matches_yenc_encode():
+    data = awkward_payload(20_000)
+    encoded, crc = sabctools.yenc_encode(data)
+    encoder = sabctools.Encoder()
+    assert encoder.encode(memoryview(data)[:10_000]) + encoder.encode(memoryview(data)[10_000:], is_end=True) == encoded
+    assert encoder.crc == crc
+
+
+def test_into_a_caller_buffer():
+    data = awkward_payload(30_000)
+    expected = sabctools.Encoder().encode(data, is_end=True)
+
+    encoder = sabctools.Encoder()
+    out = bytearray(encoder.max_length(10_000))
+    received = b""
+    for start in range(0, len(data), 10_000):
+        written = encoder.encode(data[start : start + 10_000], out, is_end=start + 10_000 >= len(data))
+        received += out[:written]
+    assert received == expected
+
+
+def test_any_buffer_is_accepted(tmp_path):
+    data = awkward_payload(5000)
+    path = tmp_path / "source.bin"
+    path.write_bytes(data)
+    expected = sabctools.Encoder().encode(data, is_end=True)
+    with open(path, "rb") as f, mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ) as mapped:
+        assert sabctools.Encoder().encode(mapped, is_end=True) == expected
+    assert sabctools.Encoder().encode(bytearray(data), bytearray(20_000), True) > 0
+
+
+@pytest.mark.parametrize("empty_end", [False, True], ids=["last_chunk_ends", "empty_chunk_ends"])
+def test_round_trip_through_the_decoder(empty_end):
+    data = awkward_payload(100_000)
+    if empty_end:
+        # Ends on a byte encoded as a space, so the article only ends after it is out
+        data += b"\xf6"
+    encoder = sabctools.Encoder()
+    body = b"".join(
+        encoder.encode(data[start : start + 3333], is_end=not empty_end and start + 3333 >= len(data))
+        for start in range(0, len(data), 3333)
+    )
+    if empty_end:
+        body += encoder.encode(b"", is_end=True)
+        assert body == sabctools.Encoder().encode(data, is_end=True)
+    wire = (
+        b"222 0 <a@b>\r\n=ybegin line=128 size=%d name=a.bin\r\n" % len(data)
+        + body
+        + b"\r\n=yend size=%d crc32=%08x\r\n.\r\n" % (len(data), encoder.crc)
+    )
+    decoder = sabctools.Decoder(len(wire) + 1)
+    memoryview(decoder)[: len(wire)] = wire
+    decoder.process(len(wire))
+    response = next(decoder)
+    assert bytes(response.data) == data
+    assert response.crc == response.crc_expected == encoder.crc
+
+
+@pytest.mark.parametrize("last", [b"\xf6", b"\xdf"], ids=["space", "tab"])
+def test_an_empty_last_chunk_escapes_the_whitespace_before_it(last):
+    encoder = sabctools.Encoder(line_size=10)
+    first = encoder.encode(b"abc" + last)
+    assert first == b"\x8b\x8c\x8d", "the whitespace waits for the next call"
+    out = bytearray(encoder.max_length(0))
+    written = encoder.encode(b"", out, is_end=True)
+    assert first + out[:written] == sabctools.Encoder(line_size=10).encode(b"abc" + last, is_end=True)
+    assert out[:written] == b"=" + bytes([(last[0] + 42 + 64) % 256])
+    assert encoder.bytes_out == len(first) + written
+    assert encoder.crc == crc32(b"abc" + last)
+
+
+def test_reset_starts_a_new_article():
+    encoder = sabctools.Encoder()
+    first = encoder.encode(b"first article ", is_end=True)
+    with pytest.raises(ValueError):
+        encoder.encode(b"more")
+    encoder.reset()
+    assert (encoder.column, encoder.crc, encoder.bytes_in, encoder.ended) == (0, 0, 0, False)
+    assert encoder.encode(b"first article ", is_end=True) == first
+
+
+def test_column_carries_over():
+    encoder = sabctools.Encoder(line_size=10)
+    encoder.encode(b"a" * 25)
+    assert encoder.column == 5
+    assert "column=5" in repr(encoder)
+
+
+def test_argument_checks():
+    with pytest.raises(ValueError):
+        sabctools.Encoder(line_size=1)
+    encoder = sabctools.Encoder()
+    with pytest.raises(ValueError):
+        encoder.encode(b"x" * 1000, bytearray(100))
+    with pytest.raises(BufferError):
+        encoder.encode(b"x", b"read-only output")
+    shared = bytearray(10_000)
+    with pytest.raises(ValueError):
+        encoder.encode(memoryview(shared)[:100], memoryview(shared)[50:])
+    with pytest.raises(TypeError):
+        encoder.encode("text")
+    with pytest.raises(ValueError):
+        encoder.max_length(-1)
+    assert encoder.bytes_in == 0, "a refused call changes nothing"
+
+
+def split_parts(size: int, part_size: int):
+    return [(begin, min(begin + part_size, size)) for begin in range(0, size, part_size)]
+
+
+HEADERS = {"From": "poster <poster@example.com>", "Newsgroups": "alt.binaries.test", "Subject": "file.bin (1/1)"}
+
+
+def test_build_article_decodes_back():
+    data = awkward_payload(250_000)
+    parts = split_parts(len(data), 100_000)
+    decoder = sabctools.Decoder(1 << 20)
+    crc = None
+    decoded = bytearray(len(data))
+    for number, (begin, end) in enumerate(parts, start=1):
+        article, pcrc, crc = sabctools.build_article(
+            data, number, len(parts), begin, end, "file.bin", HEADERS | {"Message-ID": "<%d@test>" % number}, crc
+        )
+        assert pcrc == crc32(data[begin:end])
+        assert crc == crc32(data[:end])
+        assert article.endswith(b"\r\n.\r\n")
+        assert (b" crc32=%08x" % crc32(data) in article) == (number == len(parts))
+
+        wire = b"220 0 <%d@test>\r\n" % number + article
+        memoryview(decoder)[: len(wire)] = wire
+        decoder.process(len(wire))
+        response = next(decoder)
+        assert response.crc == response.crc_expected == pcrc
+        assert (response.part_begin, response.part_size, response.file_size) == (begin, end - begin, len(data))
+        assert response.file_name == "file.bin"
+        assert "Newsgroups: alt.binaries.test" in response.lines
+        decoded[begin:end] = response.data
+    assert decoded == data
+
+
+def test_build_article_layout():
+    article, pcrc, crc = sabctools.build_article(b"0123456789", 1, 1, 0, 10, "ten.bin", [("Subject", "ten")])
+    assert article == (
+        b"Subject: ten\r\n\r\n"
+        b"=ybegin part=1 total=1 line=128 size=10 name=ten.bin\r\n"
+        b"=ypart begin=1 end=10\r\n"
+        + sabctools.yenc_encode(b"0123456789")[0]
+        + b"\r\n=yend size=10 part=1 pcrc32=%08x crc32=%08x\r\n.\r\n" % (pcrc, crc)
+    )
+    assert pcrc == crc == crc32(b"0123456789")
+
+
+def test_build_article_without_headers_or_a_running_crc():
+    """Without the CRC of the earlier parts it is read from the source instead"""
+    data = os.urandom(3000)
+    article, pcrc, crc = sabctools.build_article(memoryview(data), 3, 3, 2000, 3000, b"f.bin", line_size=64)
+    assert article.startswith(b"=ybegin part=3 total=3 line=64 size=3000 name=f.bin\r\n=ypart begin=2001 end=3000\r\n")
+    assert crc == crc32(data)
+    assert b"crc32=%08x" % crc in article
+
+
+def test_build_article_with_a_larger_file_size():
+    data = os.urandom(1000)
+    article, _, _ = sabctools.build_article(data, 1, 5, 0, 1000, "big.bin", size=5000)
+    assert b" size=5000 " in article.split(b"\r\n")[0]
+
+
+@pytest.mark.parametrize(
+    "arguments",
+    [
+        dict(part=0),
+        dict(part=3, total=2),
+        dict(begin=500, end=500),
+        dict(end=20_000),
+        dict(name="two\r\nlines"),
+        dict(name=5),
+        dict(headers={"Subject": "x\r\n.\r\nQUIT"}),
+        dict(headers={"Bad: name": "x"}),
+        dict(headers=[("only one",)]),
+        dict(crc=1 << 32),
+        dict(line_size=1),
+    ],
+)
+def test_build_article_argument_checks(arguments):
+    call = dict(source=bytes(1000), part=1, total=1, begin=0, end=1000, name="f.bin") | arguments
+    with pytest.raises((ValueError, TypeError, OverflowError)):
+        sabctools.build_article(**call)
+
+
+@pytest.fixture
+def upload(tmp_path):
+    data = awkward_payload(1_000_003)
+    path = tmp_path / "upload.bin"
+    path.write_bytes(data)
+    return path, data
+
+
+@pytest.mark.parametrize("threads, window", [(1, 0), (4, 0), (3, 1), (8, 32)])
+def test_encode_file_matches_build_article(upload, threads, window):
+    path, data = upload
+    parts = split_parts(len(data), 100_000)
+    with sabctools.encode_file(path, part_size=100_000, threads=threads, window=window) as encoder:
+        assert encoder.parts == len(parts)
+        assert encoder.size == len(data)
+        crc = 0
+        for number, (article, part, begin, end, pcrc) in enumerate(encoder, start=1):
+            expected, expected_pcrc, crc = sabctools.build_article(
+                data, part, len(parts), begin, end, "upload.bin", crc=crc
+            )
+            assert (part, begin, end) == (number, *parts[number - 1])
+            assert pcrc == expected_pcrc
+            assert article == expected
+        assert encoder.yielded == len(parts)
+        assert encoder.crc == crc32(data)
+        assert encoder.threads == 0, "the workers are gone once the last part is out"
+
+
+def test_encode_file_headers_and_name(upload):
+    path, data = upload
+
+    def headers(part, total):
+        return {"Subject": "upload.bin (%d/%d)" % (part, total)}
+
+    encoder = sabctools.FileEncoder(str(path), part_size=400_000, line_size=64, name="other.bin", headers=headers)
+    articles = list(encoder)
+    assert [a[1] for a in articles] == [1, 2, 3]
+    for article, part, _, _, _ in articles:
+        assert article.startswith(
+            b"Subject: upload.bin (%d/3)\r\n\r\n=ybegin part=%d total=3 line=64 size=%d name=other.bin\r\n"
+            % (part, part, len(data))
+        )
+    fixed = next(iter(sabctools.encode_file(os.fsencode(path), headers={"From": "me"})))[0]
+    assert fixed.startswith(b"From: me\r\n\r\n=ybegin part=1 total=2 ")
+
+
+def test_encode_file_round_trip(upload):
+    path, data = upload
+    decoder = sabctools.Decoder(1 << 20)
+    decoded = bytearray(len(data))
+    for article, part, begin, end, pcrc in sabctools.encode_file(path, part_size=300_000):
+        wire = b"222 0 <%d@test>\r\n" % part + article
+        memoryview(decoder)[: len(wire)] = wire
+        decoder.process(len(wire))
+        response = next(decoder)
+        assert response.crc == response.crc_expected == pcrc
+        decoded[begin:end] = response.data
+    assert decoded == data
+
+
+def test_encode_file_close_mid_iteration(upload):
+    path, _ = upload
+    encoder = sabctools.encode_file(path, part_size=10_000, threads=4)
+    assert next(encoder)[1] == 1
+    encoder.close()
+    assert list(encoder) == []
+    assert encoder.yielded == 1
+    encoder.close()
+    # Dropped mid-way without a close, the workers are still joined
+    encoder = sabctools.encode_file(path, part_size=10_000, threads=4)
+    next(encoder)
+    del encoder
+
+
+def test_encode_file_caps_the_threads(upload):
+    path, data = upload
+    with sabctools.encode_file(path, part_size=1000, threads=100_000) as encoder:
+        assert encoder.threads == 64
+        assert encoder.window == 128
+        assert b"".join(article for article, *_ in encoder)
+    assert encoder.crc == crc32(data)
+
+
+def test_encode_file_closed_by_the_headers_callback(upload):
+    path, _ = upload
+
+    def headers(part, total):
+        encoder.close()
+
+    encoder = sabctools.encode_file(path, part_size=100_000, headers=headers)
+    with pytest.raises(ValueError, match="closed"):
+        next(encoder)
+
+
+def test_encode_file_empty_and_missing(tmp_path):
+    empty = tmp_path / "empty.bin"
+    empty.write_bytes(b"")
+    encoder = sabctools.encode_file(empty)
+    assert (encoder.parts, list(encoder)) == (0, [])
+    with pytest.raises(FileNotFoundError) as exc:
+        sabctools.encode_file(tmp_path / "missing.bin")
+    assert exc.value.filename == str(tmp_path / "missing.bin")
+
+
+@pytest.mark.parametrize(
+    "arguments",
+    [dict(part_size=0), dict(line_size=1), dict(threads=-1), dict(window=-1), dict(name="a\r\nb"), dict(name=1)],
+)
+def test_encode_file_argument_checks(upload, arguments):
+    path, _ = upload
+    with pytest.raises((ValueError, TypeError)):
+        sabctools.encode_file(path, **arguments)
+
+
+def test_encode_file_headers_errors_propagate(upload):
+    path, _ = upload
+    with pytest.raises(ZeroDivisionError):
+        next(sabctools.encode_file(path, headers=lambda part, total: 1 / 0))
+    with pytest.raises(ValueError):
+        next(sabctools.encode_file(path, headers={"Subject": "a\r\nb"}))
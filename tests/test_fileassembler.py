@@ -0,0 +1,86 @@
+import os
+import random
+import zlib
+
+import pytest
+
+from tests.testsupport import *
+
+
+def split(data: bytes, part_size: int):
+    return [
+        (begin, len(data[begin : begin + part_size]), zlib.crc32(data[begin : begin + part_size]))
+        for begin in range(0, len(data), part_size)
+    ]
+
+
+@pytest.mark.parametrize("seed", range(5))
+def test_parts_in_any_order(seed):
+    data = os.urandom(1_000_003)
+    parts = split(data, 7_777)
+    random.Random(seed).shuffle(parts)
+
+    assembler = sabctools.FileAssembler(len(data))
+    for number, part in enumerate(parts, start=1):
+        result = assembler.add(*part)
+        assert (result is None) == (number < len(parts))
+    assert result == assembler.crc == zlib.crc32(data)
+    assert assembler.complete
+    assert assembler.runs == 1
+    assert assembler.added == len(parts)
+    assert assembler.missing() == []
+
+
+def test_missing_parts_count_as_zeros():
+    data = bytearray(os.urandom(100_000))
+    parts = split(bytes(data), 10_000)
+    assembler = sabctools.FileAssembler(len(data))
+    for index, part in enumerate(parts):
+        if index not in (0, 4, 9):
+            assembler.add(*part)
+    for begin in (0, 40_000, 90_000):
+        data[begin : begin + 10_000] = bytes(10_000)
+
+    assert not assembler.complete
+    assert assembler.covered == 70_000
+    assert assembler.crc == zlib.crc32(data)
+    assert assembler.missing() == [(0, 10_000), (40_000, 50_000), (90_000, 100_000)]
+    assert assembler.runs == 2
+    assert sabctools.FileAssembler(50).crc == zlib.crc32(bytes(50))
+
+
+def test_keywords_and_a_response():
+    """The arguments are what a decoded article reports"""
+    data = os.urandom(3000)
+    wire = b"222 0 <a@b>\r\n=ybegin part=1 total=1 line=128 size=3000 name=f\r\n=ypart begin=1 end=3000\r\n"
+    encoded, _ = sabctools.yenc_encode(data)
+    wire += encoded + b"\r\n=yend size=3000 part=1 pcrc32=%08x\r\n.\r\n" % zlib.crc32(data)
+    decoder = sabctools.Decoder(len(wire))
+    memoryview(decoder)[: len(wire)] = wire
+    decoder.process(len(wire))
+    response = next(decoder)
+
+    assembler = sabctools.FileAssembler(response.file_size)
+    assert assembler.add(begin=response.part_begin, size=response.part_size, crc=response.crc) == zlib.crc32(data)
+
+
+@pytest.mark.parametrize(
+    "begin, size",
+    [(-1, 10), (0, 0), (0, -5), (95, 10), (100, 1), (15, 10), (5, 10), (19, 2), (0, 100)],
+)
+def test_refuses_what_does_not_fit(begin, size):
+    assembler = sabctools.FileAssembler(100)
+    assembler.add(10, 10, 0)
+    with pytest.raises(ValueError):
+        assembler.add(begin, size, 0)
+    assert (assembler.covered, assembler.added) == (10, 1), "a refused part changes nothing"
+
+
+def test_argument_checks():
+    with pytest.raises(ValueError):
+        sabctools.FileAssembler(-1)
+    assembler = sabctools.FileAssembler(10)
+    with pytest.raises(OverflowError):
+        assembler.add(0, 10, 1 << 32)
+    assert "size=10" in repr(assembler)
+    assert sabctools.FileAssembler(0).complete
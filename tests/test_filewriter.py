@@ -75,6 +75,158 @@ class TestOpen:
         finally:
             writer.close()
 
+    def test_io_uring_is_a_request(self, target):
+        """Where there is no ring the writer still opens, on pwrite"""
+        with sabctools.FileWriter(target, io_uring=True) as writer:
+            assert writer.io_uring in (True, False)
+            if not sys.platform.startswith("linux"):
+                assert writer.io_uring is False
+            assert writer.write(b"direct", 0) == 6
+        with sabctools.FileWriter(target) as writer:
+            assert writer.io_uring is False
+        assert open(target, "rb").read() == b"direct"
+
+
+class TestDirect:
+    """The aligned middle of each write goes around the page cache; what lands in the
+    file has to be exactly what a buffered write would have put there"""
+
+    @pytest.fixture
+    def direct(self, target):
+        writer = sabctools.FileWriter(target, direct=True)
+        if not writer.direct:
+            writer.close()
+            pytest.skip("the filesystem refuses direct I/O")
+        yield writer
+        writer.close()
+
+    def test_direct_is_a_request(self, target):
+        with sabctools.FileWriter(target, direct=True) as writer:
+            assert writer.direct in (True, False)
+            if sys.platform == "win32":
+                assert writer.direct is False
+        with sabctools.FileWriter(target) as writer:
+            assert writer.direct is False
+
+    @pytest.mark.parametrize(
+        "offset, length",
+        [(0, 4096), (0, 716800), (100, 10), (100, 5000), (4000, 300_000), (8192, 12288 + 17), (1, 2 << 20)],
+    )
+    def test_any_offset_and_length(self, direct, target, offset, length):
+        data = os.urandom(length)
+        assert direct.write(data, offset) == length
+        direct.close()
+        with open(target, "rb") as f:
+            contents = f.read()
+        assert contents[offset:] == data
+        assert contents[:offset] == b"\0" * offset
+
+    def test_source_memory_need_not_be_aligned(self, direct, target):
+        data = os.urandom(3 * 4096 + 3)
+        direct.write(memoryview(data)[3:], 4096)
+        direct.close()
+        with open(target, "rb") as f:
+            assert f.read()[4096:] == data[3:]
+
+    def test_neighbouring_writes_share_a_block(self, direct, target):
+        """Adjacent articles meet inside a block, where neither is aligned"""
+        parts = [os.urandom(size) for size in (5000, 3000, 9000, 4096, 1)]
+        offsets = [sum(len(part) for part in parts[:index]) for index in range(len(parts))]
+        for index in (3, 0, 4, 2, 1):
+            direct.write(parts[index], offsets[index])
+        direct.close()
+        with open(target, "rb") as f:
+            assert f.read() == b"".join(parts)
+
+    def test_a_decoder_streams_into_it(self, direct, target):
+        payload = os.urandom(716800)
+        encoded, crc = sabctools.yenc_encode(payload)
+        wire = (
+            b"222 0 <a@b>\r\n=ybegin part=2 line=128 size=%d name=a.bin\r\n=ypart begin=%d end=%d\r\n"
+            % (2 * len(payload), len(payload) + 1, 2 * len(payload))
+            + encoded
+            + b"\r\n=yend size=%d part=2 pcrc32=%08x\r\n.\r\n" % (len(payload), crc)
+        )
+        decoder = sabctools.Decoder(len(wire))
+        decoder.expect("article", direct)
+        view = memoryview(decoder)
+        view[: len(wire)] = wire
+        view.release()
+        decoder.process(len(wire))
+        response = next(decoder)
+        assert not response.sink_failed
+        direct.close()
+        with open(target, "rb") as f:
+            assert f.read()[len(payload) :] == payload
+
+
+class TestWriteback:
+    def test_the_window_is_reported(self, target):
+        with sabctools.FileWriter(target, writeback=1 << 20) as writer:
+            if sys.platform.startswith("linux"):
+                assert writer.writeback == 1 << 20
+            else:
+                assert writer.writeback == 0, "only Linux has sync_file_range"
+        with sabctools.FileWriter(target) as writer:
+            assert writer.writeback == 0
+
+    def test_negative_is_refused(self, target):
+        with pytest.raises(ValueError):
+            sabctools.FileWriter(target, writeback=-1)
+
+    @pytest.mark.parametrize("options", [{}, {"direct": True}])
+    def test_writes_out_of_order_survive(self, target, options):
+        """Late articles land in windows that were already pushed out and dropped"""
+        window = 64 * 1024
+        parts = [os.urandom(20_000) for _ in range(60)]
+        order = list(range(len(parts)))
+        for index in range(0, len(order) - 8, 8):
+            order[index], order[index + 7] = order[index + 7], order[index]
+        with sabctools.FileWriter(target, writeback=window, **options) as writer:
+            for index in order:
+                writer.write(parts[index], index * 20_000)
+            # Well past the windows above, so they are started, waited for and dropped
+            writer.write(b"end", 20 * window)
+        with open(target, "rb") as f:
+            contents = f.read()
+        assert contents[: len(parts) * 20_000] == b"".join(parts)
+        assert contents[20 * window :] == b"end"
+
+    def test_reopened_writer_starts_afresh(self, tmp_path):
+        """Windows counted for the first file say nothing about the second"""
+        window = 64 * 1024
+        parts = [os.urandom(window // 2) for _ in range(16)]
+        writer = sabctools.FileWriter(str(tmp_path / "first.bin"), writeback=window)
+        for index, part in enumerate(parts):
+            writer.write(part, index * len(part))
+        writer.close()
+
+        writer.__init__(str(tmp_path / "second.bin"), writeback=window)
+        # Last part first, as a par2 block or the final article might
+        for index in reversed(range(len(parts))):
+            writer.write(parts[index], index * len(parts[index]))
+        writer.close()
+        for name in ("first.bin", "second.bin"):
+            with open(tmp_path / name, "rb") as f:
+                assert f.read() == b"".join(parts)
+
+    def test_threads_share_the_windows(self, target):
+        window = 32 * 1024
+        payload = os.urandom(8192)
+        with sabctools.FileWriter(target, writeback=window) as writer:
+
+            def worker(first):
+                for block in range(first, 400, 4):
+                    writer.write(payload, block * len(payload))
+
+            threads = [threading.Thread(target=worker, args=(first,)) for first in range(4)]
+            for thread in threads:
+                thread.start()
+            for thread in threads:
+                thread.join()
+        with open(target, "rb") as f:
+            assert f.read() == payload * 400
+
 
 class TestWrite:
     def test_writes_at_an_absolute_offset(self, target):
@@ -117,6 +269,74 @@ class TestWrite:
                 writer.write("not bytes", 0)
 
 
+class TestWriteMany:
+    @pytest.mark.parametrize("options", [{}, {"direct": True}])
+    def test_writes_every_item_in_any_order(self, target, options):
+        parts = [os.urandom(size) for size in (5000, 700_000, 1, 4096, 33_333, 0, 12)]
+        offsets = [sum(len(part) for part in parts[:index]) for index in range(len(parts))]
+        items = [(parts[index], offsets[index]) for index in (3, 0, 6, 1, 5, 4, 2)]
+        with sabctools.FileWriter(target, **options) as writer:
+            assert writer.write_many(items) == [True] * len(items)
+        with open(target, "rb") as f:
+            assert f.read() == b"".join(parts)
+
+    def test_gaps_and_overlaps(self, target):
+        """Only exact neighbours are merged; the rest are written on their own, and at
+        one offset the later item wins"""
+        with sabctools.FileWriter(target) as writer:
+            result = writer.write_many([(b"bbbb", 10), (b"aaaa", 0), (b"cc", 12), (b"BB", 10), (b"dd", 4)])
+        assert result == [True] * 5
+        with open(target, "rb") as f:
+            assert f.read() == b"aaaadd\0\0\0\0BBcc"
+
+    def test_more_items_than_one_vector_takes(self, target):
+        """Past IOV_MAX a run is split, and the pieces still line up"""
+        blocks = [os.urandom(64) for _ in range(3000)]
+        with sabctools.FileWriter(target) as writer:
+            result = writer.write_many([(block, index * 64) for index, block in enumerate(blocks)])
+        assert result == [True] * len(blocks)
+        with open(target, "rb") as f:
+            assert f.read() == b"".join(blocks)
+
+    def test_accepts_any_buffer_and_iterable(self, target):
+        with sabctools.FileWriter(target) as writer:
+            items = ((data, offset) for data, offset in [(bytearray(b"ab"), 0), (memoryview(b"cd"), 2)])
+            assert writer.write_many(items) == [True, True]
+            assert writer.write_many([]) == []
+        with open(target, "rb") as f:
+            assert f.read() == b"abcd"
+
+    @pytest.mark.skipif(not sys.platform.startswith("linux"), reason="needs /dev/full")
+    def test_failures_are_reported_per_item(self):
+        with sabctools.FileWriter("/dev/full") as writer:
+            assert writer.write_many([(b"x", 0), (b"y", 1), (b"", 5)]) == [False, False, True]
+
+    def test_bad_items(self, target):
+        with sabctools.FileWriter(target) as writer:
+            with pytest.raises(TypeError):
+                writer.write_many([(b"ok", 0), b"not a pair"])
+            with pytest.raises(TypeError):
+                writer.write_many([("text", 0)])
+            with pytest.raises(ValueError):
+                writer.write_many([(b"ok", 0), (b"negative", -1)])
+            with pytest.raises(TypeError):
+                writer.write_many(5)
+        assert os.path.getsize(target) == 0, "nothing is written unless every item parses"
+        with pytest.raises(ValueError):
+            writer.write_many([(b"late", 0)])
+
+    def test_does_not_leak_the_buffers(self, target):
+        data = bytearray(b"x" * 100)
+        before = sys.getrefcount(data)
+        with sabctools.FileWriter(target) as writer:
+            for _ in range(100):
+                writer.write_many([(data, 0), (data, 100)])
+            with pytest.raises(ValueError):
+                writer.write_many([(data, 0), (data, -1)])
+        assert sys.getrefcount(data) == before
+        data.append(1)  # would raise BufferError if an export were still held
+
+
 class TestPreallocate:
     def test_sets_the_length(self, target):
         with sabctools.FileWriter(target) as writer:
@@ -169,6 +389,24 @@ class TestClose:
         with pytest.raises(ValueError):
             writer.preallocate(1024)
 
+    def test_a_writer_never_opened_is_closed(self, tmp_path):
+        """Made with __new__ alone, or left so by a failed __init__: no descriptor to use"""
+        fresh = sabctools.FileWriter.__new__(sabctools.FileWriter)
+        failed = sabctools.FileWriter.__new__(sabctools.FileWriter)
+        with pytest.raises(OSError):
+            failed.__init__(str(tmp_path / "missing" / "file.bin"))
+        for writer in (fresh, failed):
+            assert writer.closed is True
+            with pytest.raises(ValueError):
+                writer.write(b"x", 0)
+            with pytest.raises(ValueError):
+                writer.write_many([(b"x", 0)])
+            with pytest.raises(ValueError):
+                writer.preallocate(10)
+            with pytest.raises(ValueError):
+                writer.size
+            writer.close()
+
     def test_entering_a_closed_writer_raises(self, target):
         writer = sabctools.FileWriter(target)
         writer.close()
@@ -229,7 +467,7 @@ class TestConcurrency:
             assert contents[index * chunk : (index + 1) * chunk] == payloads[index]
 
     def test_close_waits_for_writes_in_flight(self, target):
-        """close() takes the lock exclusively, so a write already inside the C call
+        """close() waits for the writes counted in, so a write already inside the C call
         finishes rather than having the descriptor pulled out from under it.
 
         The writer loops until told to stop rather than for a fixed count, so close()
@@ -268,6 +506,37 @@ class TestConcurrency:
         assert writes, "no writes were actually issued"
         assert writer.closed is True
 
+    def test_reopening_while_writes_are_turned_away(self, tmp_path):
+        """A write that lost to close() leaves the count after __init__ reopened the
+        writer, and must not take away from the count of the new file's users"""
+        writer = sabctools.FileWriter(str(tmp_path / "0.bin"))
+        stop = threading.Event()
+
+        def write_repeatedly():
+            while not stop.is_set():
+                try:
+                    writer.write(b"x" * 512, 0)
+                    writer.size
+                except ValueError:
+                    pass
+
+        threads = [threading.Thread(target=write_repeatedly) for _ in range(4)]
+        for thread in threads:
+            thread.start()
+        for number in range(1, 200):
+            writer.close()
+            writer.__init__(str(tmp_path / ("%d.bin" % number)))
+        stop.set()
+        for thread in threads:
+            thread.join()
+
+        assert writer.closed is False
+        assert writer.write(b"still open", 0) == 10
+        closer = threading.Thread(target=writer.close)
+        closer.start()
+        closer.join(10)
+        assert not closer.is_alive(), "close() is waiting for users that already left"
+
     def test_closing_twice_from_threads_is_safe(self, target):
         writer = sabctools.FileWriter(target)
         threads = [threading.Thread(target=writer.close) for _ in range(8)]
@@ -0,0 +1,382 @@
+import gc
+import os
+import selectors
+import socket
+import ssl
+import tempfile
+import time
+
+import pytest
+
+from tests.testsupport import *
+from tests.nntpserver import NNTPServer, SyntheticArticles, dot_stuff, yenc_article
+from tests.test_unlocked_ssl import cert, key
+
+PAYLOADS = {"art%d@test" % n: os.urandom(5000 + 997 * n) for n in range(20)}
+ARTICLES = {message_id: yenc_article(data, message_id) for message_id, data in PAYLOADS.items()}
+
+
+def connect(server, **kwargs):
+    sock = socket.create_connection(server.address)
+    sock.setblocking(False)
+    return sabctools.NNTPConnection(sock, **kwargs)
+
+
+def run(connection, count: int, timeout: float = 10):
+    """Drive a connection the way an event loop would, until `count` responses arrive"""
+    responses = []
+    deadline = time.monotonic() + timeout
+    with selectors.DefaultSelector() as selector:
+        selector.register(connection, selectors.EVENT_READ)
+        while len(responses) < count:
+            assert time.monotonic() < deadline, "timed out with %d of %d responses" % (len(responses), count)
+            events = selectors.EVENT_READ | (selectors.EVENT_WRITE if connection.wants_write else 0)
+            selector.modify(connection, events)
+            for _, mask in selector.select(0.5):
+                if mask & selectors.EVENT_WRITE:
+                    connection.on_writable()
+                if mask & selectors.EVENT_READ:
+                    responses.extend(connection.on_readable())
+                assert connection.in_flight <= connection.pipeline
+    return responses
+
+
+@pytest.fixture
+def server():
+    with NNTPServer(ARTICLES, groups={"alt.binaries.test": (3000, 3999)}) as server:
+        yield server
+
+
+@pytest.mark.parametrize("pipeline", [1, 4, 50])
+def test_pipelined_bodies(server, pipeline):
+    connection = connect(server, pipeline=pipeline)
+    for message_id in PAYLOADS:
+        connection.submit(message_id, message_id)
+    assert connection.queued == len(PAYLOADS), "nothing is sent before the greeting"
+
+    responses = run(connection, len(PAYLOADS))
+    assert [r.context for r in responses] == list(PAYLOADS)
+    for response in responses:
+        assert response.status_code == 222
+        assert bytes(response.data) == PAYLOADS[response.context]
+        assert response.crc == response.crc_expected
+    assert connection.state == "ready"
+    assert (connection.queued, connection.in_flight) == (0, 0)
+    assert connection.bytes_received > sum(len(body) for body in ARTICLES.values())
+    assert server.commands == [b"BODY <%s>" % message_id.encode() for message_id in PAYLOADS]
+
+
+def test_article_command(server):
+    connection = connect(server, command="ARTICLE")
+    connection.submit("art3@test", "three")
+    response = run(connection, 1)[0]
+    assert response.status_code == 220
+    assert bytes(response.data) == PAYLOADS["art3@test"]
+    assert server.commands == [b"ARTICLE <art3@test>"]
+
+
+def test_missing_article(server):
+    connection = connect(server, pipeline=2)
+    connection.submit("missing@test", "missing")
+    connection.submit("art0@test", "present")
+    responses = run(connection, 2)
+    assert [(r.context, r.status_code) for r in responses] == [("missing", 430), ("present", 222)]
+
+
+def test_group(server):
+    connection = connect(server)
+    connection.group("alt.binaries.test", "group")
+    connection.submit("art1@test", "body")
+    responses = run(connection, 2)
+    assert responses[0].status_code == 211
+    assert responses[0].context == "group"
+    assert responses[0].message == "211 1000 3000 3999 alt.binaries.test"
+    assert responses[1].status_code == 222
+    with pytest.raises(ValueError):
+        connection.group("two words")
+
+
+def test_streams_into_a_sink(server, tmp_path):
+    data = os.urandom(300_000)
+    parts = {}
+    for number, begin in enumerate(range(0, len(data), 100_000), start=1):
+        chunk = data[begin : begin + 100_000]
+        parts["part%d@test" % number] = yenc_article(chunk, "file.bin", number, begin, len(data))
+    server.articles = parts
+
+    writer = sabctools.FileWriter(str(tmp_path / "file.bin"))
+    connection = connect(server, pipeline=3)
+    for message_id in reversed(parts):
+        connection.submit(message_id, message_id, writer)
+    responses = run(connection, len(parts))
+    writer.close()
+
+    assert all(r.data is None and r.crc == r.crc_expected for r in responses)
+    with open(writer.path, "rb") as f:
+        assert f.read() == data
+
+
+class TestAuthentication:
+    def test_accepted(self):
+        with NNTPServer(ARTICLES, username="user", password="secret") as server:
+            connection = connect(server, username="user", password="secret", pipeline=8)
+            connection.submit("art0@test", 0)
+            assert connection.state == "greeting"
+            response = run(connection, 1)[0]
+            assert response.status_code == 222
+            assert connection.state == "ready"
+            assert server.commands[:2] == [b"AUTHINFO USER user", b"AUTHINFO PASS secret"]
+
+    def test_rejected(self):
+        with NNTPServer(ARTICLES, username="user", password="secret") as server:
+            connection = connect(server, username="user", password="wrong")
+            connection.submit("art0@test", 0)
+            with pytest.raises(PermissionError, match="481"):
+                run(connection, 1)
+            assert connection.state == "closed"
+            assert connection.requeue() == [0]
+
+    def test_without_credentials(self):
+        """The server's 480 is the caller's to act on, like any other response"""
+        with NNTPServer(ARTICLES, username="user", password="secret") as server:
+            connection = connect(server)
+            connection.submit("art0@test", 0)
+            assert run(connection, 1)[0].status_code == 480
+
+    def test_no_cr_or_lf(self, server):
+        sock = socket.socket()
+        with pytest.raises(ValueError):
+            sabctools.NNTPConnection(sock, username="user\r\nBODY <x>")
+        sock.close()
+
+
+def test_greeting_refused():
+    with NNTPServer(ARTICLES, greeting=b"502 Too many connections") as server:
+        connection = connect(server)
+        with pytest.raises(ConnectionRefusedError, match="502"):
+            run(connection, 1)
+        assert connection.state == "closed"
+        with pytest.raises(ValueError):
+            connection.on_readable()
+
+
+class HangUpServer(NNTPServer):
+    def respond(self, command, state):
+        if command == b"BODY <hangup@test>":
+            return b"", True
+        return super().respond(command, state)
+
+
+def test_server_hangs_up():
+    """Responses that arrived before the close are still delivered"""
+    with HangUpServer(ARTICLES) as server:
+        connection = connect(server, pipeline=3)
+        for context in ("art0@test", "hangup@test", "art1@test"):
+            connection.submit(context, context)
+        responses = run(connection, 1)
+        with pytest.raises(ConnectionResetError):
+            run(connection, 2)
+        assert [r.context for r in responses] == ["art0@test"]
+        assert connection.state == "closed"
+        assert connection.requeue() == ["hangup@test", "art1@test"]
+
+
+def test_an_error_after_a_response_keeps_the_response():
+    """Once collected, a response is off the Decoder and in_flight, so requeue() could not
+    give it back: it is returned, and the error raised by the next call"""
+    ours, theirs = socket.socketpair()
+    ours.setblocking(False)
+    connection = sabctools.NNTPConnection(ours, pipeline=1)
+    connection.submit("art0@test", "first")
+    connection.submit("art1@test", "second")
+    theirs.sendall(b"200 Welcome\r\n")
+    assert connection.on_readable() == []
+    assert theirs.recv(100) == b"BODY <art0@test>\r\n"
+
+    # The answer arrives, but the server stops reading, so sending the next request fails
+    theirs.sendall(b"222 0 <art0@test>\r\n" + dot_stuff(ARTICLES["art0@test"]) + b".\r\n")
+    theirs.shutdown(socket.SHUT_RD)
+    responses = connection.on_readable()
+    assert [r.context for r in responses] == ["first"]
+    assert bytes(responses[0].data) == PAYLOADS["art0@test"]
+    with pytest.raises(BrokenPipeError):
+        connection.on_readable()
+    assert connection.requeue() == ["second"]
+    ours.close()
+    theirs.close()
+
+
+def test_requeue(server):
+    connection = connect(server, pipeline=2)
+    for message_id in PAYLOADS:
+        connection.submit(message_id, message_id)
+    done = run(connection, 3)
+
+    remaining = connection.requeue()
+    assert remaining == list(PAYLOADS)[len(done) :]
+    assert connection.state == "closed"
+    assert (connection.queued, connection.in_flight) == (0, 0)
+    assert not connection.wants_write
+    with pytest.raises(ValueError):
+        connection.submit("art0@test", "late")
+
+
+def test_tls():
+    with tempfile.TemporaryDirectory() as tmp:
+        certfile = os.path.join(tmp, "cert.pem")
+        keyfile = os.path.join(tmp, "key.pem")
+        with open(certfile, "w") as f:
+            f.write(cert)
+        with open(keyfile, "w") as f:
+            f.write(key)
+        server_context = ssl.create_default_context(ssl.Purpose.CLIENT_AUTH)
+        server_context.load_cert_chain(certfile=certfile, keyfile=keyfile)
+
+    client_context = ssl.create_default_context(ssl.Purpose.SERVER_AUTH)
+    client_context.check_hostname = False
+    client_context.verify_mode = ssl.VerifyMode.CERT_NONE
+
+    with NNTPServer(ARTICLES, ssl_context=server_context) as server:
+        sock = client_context.wrap_socket(socket.create_connection(server.address))
+        sock.setblocking(False)
+        connection = sabctools.NNTPConnection(sock, pipeline=10)
+        for message_id in PAYLOADS:
+            connection.submit(message_id, message_id)
+        responses = run(connection, len(PAYLOADS))
+        assert [bytes(r.data) for r in responses] == list(PAYLOADS.values())
+        sock.close()
+
+
+def test_argument_checks(server):
+    sock = socket.create_connection(server.address)
+    with pytest.raises(ValueError, match="non-blocking"):
+        sabctools.NNTPConnection(sock)
+    sock.setblocking(False)
+    with pytest.raises(ValueError):
+        sabctools.NNTPConnection(sock, pipeline=0)
+    with pytest.raises(ValueError):
+        sabctools.NNTPConnection(sock, command="HEAD")
+
+    connection = sabctools.NNTPConnection(sock)
+    with pytest.raises(ValueError):
+        connection.submit("a@b>\r\nQUIT\r\n<c@d", None)
+    with pytest.raises(TypeError):
+        connection.submit("a@b", None, sink=open(os.devnull, "wb"))
+    with pytest.raises(ValueError):
+        connection.submit("a@b", None, offset=-1)
+    with pytest.raises(ValueError):
+        connection.pipeline = 0
+    connection.pipeline = 4
+    assert connection.pipeline == 4
+    assert connection.fileno() == sock.fileno()
+    assert connection.sock is sock
+    assert "state=greeting" in repr(connection)
+    sock.close()
+
+
+class Job:
+    """A context that remembers the connection it went out on, as a downloader's would"""
+
+    def __init__(self, connection=None):
+        self.connection = connection
+
+
+class TestGarbageCollection:
+    @staticmethod
+    def live() -> int:
+        return sum(1 for obj in gc.get_objects() if type(obj) is sabctools.NNTPConnection)
+
+    def test_a_queued_context_cycle_is_collected(self, server):
+        gc.collect()
+        before = self.live()
+
+        connection = connect(server)
+        connection.submit("art0@test", Job(connection))  # connection -> queue -> job -> connection
+        assert connection.queued == 1
+        assert self.live() == before + 1, "a live instance is not being counted"
+
+        sock = connection.sock
+        del connection
+        gc.collect()
+        assert self.live() == before
+        sock.close()
+
+    def test_an_in_flight_context_cycle_is_collected(self, server):
+        gc.collect()
+        before = self.live()
+
+        connection = connect(server, pipeline=2)
+        connection.submit("art0@test", "first")
+        run(connection, 1)
+        connection.submit("art1@test", Job(connection))  # connection -> decoder -> job -> connection
+        assert connection.in_flight == 1
+        assert self.live() == before + 1, "a live instance is not being counted"
+
+        sock = connection.sock
+        del connection
+        gc.collect()
+        assert self.live() == before
+        sock.close()
+
+
+class TestSyntheticArticles:
+    """The load-test options of the stand-in server, end to end through a connection"""
+
+    @pytest.mark.parametrize("kind", ["yenc", "uu"])
+    @pytest.mark.parametrize("dot_lines", [False, True])
+    def test_decoded_payloads(self, kind, dot_lines):
+        articles = SyntheticArticles(12, 40_000, kind, distinct=3, dot_lines=dot_lines)
+        with NNTPServer(articles) as server:
+            connection = connect(server, pipeline=4)
+            for message_id in articles:
+                connection.submit(message_id, message_id)
+            responses = run(connection, len(articles))
+        assert [bytes(r.data) for r in responses] == list(articles.payloads())
+        assert all(not r.baddata for r in responses)
+        if kind == "yenc":
+            assert [r.part_begin for r in responses] == [n * 40_000 for n in range(12)]
+
+    def test_uu_parts_stream_at_the_given_offsets(self, tmp_path):
+        articles = SyntheticArticles(6, 40_000, "uu", distinct=6, dot_lines=True)
+        writer = sabctools.FileWriter(str(tmp_path / "file.bin"))
+        with NNTPServer(articles) as server:
+            connection = connect(server, pipeline=3)
+            for number, message_id in enumerate(articles):
+                connection.submit(message_id, number, writer, offset=number * 40_000)
+            responses = run(connection, len(articles))
+        writer.close()
+
+        assert all(r.data is None and not r.sink_failed for r in responses)
+        with open(writer.path, "rb") as f:
+            assert f.read() == b"".join(articles.payloads())
+
+    def test_dot_lines_are_stuffed_on_the_wire(self):
+        articles = SyntheticArticles(1, 200_000, dot_lines=True)
+        assert b"\r\n." in articles["0@synthetic"]
+        assert b"\r\n.." in dot_stuff(articles["0@synthetic"])
+
+    def test_missing_and_truncated(self):
+        articles = SyntheticArticles(40, 20_000)
+        with NNTPServer(articles, missing_rate=0.5, seed=1) as server:
+            connection = connect(server, pipeline=8)
+            for message_id in articles:
+                connection.submit(message_id, message_id)
+            codes = [r.status_code for r in run(connection, len(articles))]
+        assert set(codes) == {222, 430}
+
+        with NNTPServer(articles, truncate_rate=1.0) as server:
+            connection = connect(server)
+            connection.submit("0@synthetic", 0)
+            with pytest.raises(ConnectionResetError):
+                run(connection, 1)
+            assert connection.requeue() == [0]
+
+    def test_latency_and_bandwidth(self):
+        articles = SyntheticArticles(2, 10_000)
+        with NNTPServer(articles, latency=0.2, bandwidth=100_000) as server:
+            connection = connect(server)
+            start = time.monotonic()
+            connection.submit("0@synthetic", 0)
+            run(connection, 1)
+            assert time.monotonic() - start >= 0.3
+        assert server.bytes_sent > 10_000
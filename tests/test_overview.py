@@ -0,0 +1,197 @@
+import os
+import zlib
+
+import pytest
+
+from tests.testsupport import *
+
+ENTRIES = [
+    (
+        3000,
+        'Some post [01/10] - "file.rar" yEnc (1/50)',
+        "poster <p@example.com>",
+        "Sat, 01 Jan 2022 00:00:00 GMT",
+        "<a@b>",
+        "",
+        740059,
+        5768,
+    ),
+    (3001, "Another one", "Jörg <j@example.com>", "Sun, 02 Jan 2022 00:00:00 GMT", "<c@d>", "<a@b>", 123, 4),
+    (3005, ".starts with a dot", "x <x@y>", "Mon, 03 Jan 2022 00:00:00 GMT", "<e@f>", "", 0, 0),
+]
+
+
+def overview_lines(entries) -> bytes:
+    """Overview lines as a server sends them, dot-stuffed, CRLF-terminated"""
+    out = b""
+    for number, subject, author, date, message_id, references, size, lines in entries:
+        line = "\t".join((str(number), subject, author, date, message_id, references, str(size), str(lines)))
+        encoded = line.encode("utf-8")
+        if encoded.startswith(b"."):
+            encoded = b"." + encoded
+        out += encoded + b"\r\n"
+    return out
+
+
+def feed(decoder, wire: bytes, chunk: int = 0):
+    responses = []
+    view_of = memoryview(wire)
+    position = 0
+    while position < len(view_of):
+        buffer = memoryview(decoder)
+        count = min(len(buffer), len(view_of) - position)
+        if chunk:
+            count = min(count, chunk)
+        buffer[:count] = view_of[position : position + count]
+        buffer.release()
+        decoder.process(count)
+        position += count
+        responses.extend(decoder)
+    return responses
+
+
+def xover_response(entries) -> bytes:
+    return b"224 Overview information follows\r\n" + overview_lines(entries) + b".\r\n"
+
+
+def xzver_response(entries, raw: bool = False) -> bytes:
+    plain = overview_lines(entries) + b".\r\n"
+    if raw:
+        compressor = zlib.compressobj(wbits=-15)
+        compressed = compressor.compress(plain) + compressor.flush()
+    else:
+        compressed = zlib.compress(plain)
+    encoded, crc = sabctools.yenc_encode(compressed)
+    return (
+        b"224 compressed data follows (zlib version 1.2.3.3)\r\n"
+        + b"=ybegin line=128 size=%d name=xzver\r\n" % len(compressed)
+        + encoded
+        + b"\r\n=yend size=%d crc32=%08x\r\n.\r\n" % (len(compressed), crc)
+    )
+
+
+def text(overview, field: str, index: int) -> str:
+    offsets = getattr(overview, field)
+    return overview.blob[offsets[index] : offsets[index + 1]].decode("utf-8")
+
+
+def check_entries(overview, entries):
+    assert len(overview) == len(entries)
+    assert list(overview.number) == [entry[0] for entry in entries]
+    assert list(overview.bytes) == [entry[6] for entry in entries]
+    assert list(overview.lines) == [entry[7] for entry in entries]
+    for index, entry in enumerate(entries):
+        assert text(overview, "subject", index) == entry[1]
+        assert text(overview, "from_", index) == entry[2]
+        assert text(overview, "date", index) == entry[3]
+        assert text(overview, "message_id", index) == entry[4]
+        assert text(overview, "references", index) == entry[5]
+        assert overview[index] == entry
+
+
+class TestXover:
+    def test_columns(self):
+        wire = xover_response(ENTRIES)
+        response = feed(sabctools.Decoder(4096), wire)[0]
+
+        assert response.status_code == 224
+        assert response.lines is None, "overview lines must not also arrive as strings"
+        assert response.data is None
+        assert response.baddata is False
+        check_entries(response.overview, ENTRIES)
+
+    def test_offsets_cover_one_blob(self):
+        """Each text column has count + 1 offsets, so entry i is offsets[i]:offsets[i+1]"""
+        overview = feed(sabctools.Decoder(4096), xover_response(ENTRIES))[0].overview
+        for field in ("subject", "from_", "date", "message_id", "references"):
+            offsets = getattr(overview, field)
+            assert len(offsets) == len(ENTRIES) + 1
+            assert list(offsets) == sorted(offsets)
+        assert overview.references[-1] == len(overview.blob)
+
+    def test_split_across_reads(self):
+        wire = xover_response(ENTRIES * 50)
+        response = feed(sabctools.Decoder(4096), wire, chunk=7)[0]
+        check_entries(response.overview, ENTRIES * 50)
+
+    def test_empty_range(self):
+        response = feed(sabctools.Decoder(4096), b"224 Overview information follows\r\n.\r\n")[0]
+        assert len(response.overview) == 0
+        assert response.overview.blob == b""
+
+    def test_a_line_without_a_number_is_skipped(self):
+        wire = (
+            b"224 follows\r\n"
+            + overview_lines(ENTRIES[:1])
+            + b"garbage\tline\r\n"
+            + overview_lines(ENTRIES[1:])
+            + b".\r\n"
+        )
+        response = feed(sabctools.Decoder(4096), wire)[0]
+        assert response.baddata is True
+        assert response.overview.skipped == 1
+        check_entries(response.overview, ENTRIES)
+
+    def test_missing_trailing_fields_are_empty(self):
+        wire = b"224 follows\r\n12\tsubject only\r\n.\r\n"
+        overview = feed(sabctools.Decoder(4096), wire)[0].overview
+        assert overview[0] == (12, "subject only", "", "", "", "", 0, 0)
+
+    def test_extra_fields_are_ignored(self):
+        wire = b"224 follows\r\n1\ts\tf\td\t<m>\t\t10\t2\tXref: host alt.binaries.test:1\r\n.\r\n"
+        overview = feed(sabctools.Decoder(4096), wire)[0].overview
+        assert overview[0] == (1, "s", "f", "d", "<m>", "", 10, 2)
+
+    def test_index_out_of_range(self):
+        overview = feed(sabctools.Decoder(4096), xover_response(ENTRIES))[0].overview
+        with pytest.raises(IndexError):
+            overview[len(ENTRIES)]
+        assert overview[-1] == ENTRIES[-1]
+
+    def test_pipelined_with_a_body(self):
+        article = read_plain_yenc_file("test_regular.yenc")
+        wire = xover_response(ENTRIES) + bytes(article)
+        responses = feed(sabctools.Decoder(len(wire)), wire)
+        assert [r.status_code for r in responses] == [224, 222]
+        check_entries(responses[0].overview, ENTRIES)
+        assert responses[1].overview is None
+        assert responses[1].bytes_decoded == 384000
+
+    def test_cannot_be_instantiated(self):
+        with pytest.raises(TypeError):
+            sabctools.Overview()
+
+
+class TestXzver:
+    @pytest.mark.parametrize("raw", [False, True], ids=["zlib", "raw-deflate"])
+    def test_inflated_and_parsed(self, raw):
+        response = feed(sabctools.Decoder(65536), xzver_response(ENTRIES * 20, raw=raw))[0]
+        assert response.status_code == 224
+        assert response.format is None, "the yEnc layer is transport, not the caller's data"
+        assert response.data is None
+        assert response.baddata is False
+        check_entries(response.overview, ENTRIES * 20)
+
+    def test_split_across_reads(self):
+        response = feed(sabctools.Decoder(65536), xzver_response(ENTRIES * 20), chunk=13)[0]
+        check_entries(response.overview, ENTRIES * 20)
+
+    def test_a_sink_is_not_written(self, tmp_path):
+        writer = sabctools.FileWriter(str(tmp_path / "target.bin"))
+        decoder = sabctools.Decoder(65536)
+        decoder.expect("overview", writer)
+        response = feed(decoder, xzver_response(ENTRIES))[0]
+        writer.close()
+        check_entries(response.overview, ENTRIES)
+        assert os.path.getsize(writer.path) == 0
+
+    def test_corrupt_block_is_reported_not_raised(self):
+        """Raising from process() would lose the response after it"""
+        encoded, crc = sabctools.yenc_encode(b"this is not deflate data at all")
+        wire = b"224 compressed\r\n=ybegin line=128 size=31 name=xzver\r\n" + encoded + b"\r\n=yend size=31\r\n.\r\n"
+        wire += xover_response(ENTRIES)
+        responses = feed(sabctools.Decoder(65536), wire)
+        assert len(responses) == 2
+        assert responses[0].overview is None
+        assert responses[0].baddata is True
+        check_entries(responses[1].overview, ENTRIES)
@@ -0,0 +1,105 @@
+import socket
+import ssl
+
+import pytest
+
+from tests.testsupport import *
+from tests.test_unlocked_ssl import EchoServer, HOST
+
+
+@pytest.fixture()
+def server():
+    server = EchoServer()
+    with server:
+        yield server
+
+
+@pytest.fixture(params=[ssl.TLSVersion.TLSv1_2, ssl.TLSVersion.TLSv1_3], ids=["TLSv1.2", "TLSv1.3"])
+def context(request):
+    context = ssl.create_default_context(ssl.Purpose.SERVER_AUTH)
+    context.check_hostname = False
+    context.verify_mode = ssl.VerifyMode.CERT_NONE
+    context.minimum_version = request.param
+    context.maximum_version = request.param
+    return context
+
+
+def connect(server, context, cache):
+    """One connection the way a caller would make it: apply before the handshake, store
+    after the first read, when a TLS 1.3 ticket has had the chance to arrive"""
+    sock = socket.create_connection((server.host, server.port))
+    ssock = context.wrap_socket(sock, server_hostname=server.host, do_handshake_on_connect=False)
+    applied = cache.apply(ssock, server.host, server.port)
+    ssock.do_handshake()
+    ssock.sendall(b"TEST")
+    assert ssock.recv(4) == b"TEST"
+    stored = cache.store(ssock, server.host, server.port)
+    reused = ssock.session_reused
+    ssock.close()
+    return applied, stored, reused
+
+
+def test_second_connection_resumes(server, context):
+    cache = sabctools.SessionCache()
+
+    assert connect(server, context, cache) == (False, True, False)
+    assert len(cache) == 1
+    assert (cache.hits, cache.misses, cache.resumed) == (0, 1, 0)
+
+    assert connect(server, context, cache) == (True, True, True)
+    assert (cache.hits, cache.misses, cache.resumed) == (1, 1, 1)
+
+
+def test_an_unclean_close_does_not_spoil_the_cache(server, context):
+    """Every connection here is closed without a close_notify, which makes OpenSSL mark
+    the session that connection used as not resumable. The cache only ever hands out
+    copies, so the next connection still resumes."""
+    cache = sabctools.SessionCache()
+    connect(server, context, cache)
+    for _ in range(3):
+        assert connect(server, context, cache) == (True, True, True)
+    assert cache.resumed == 3
+
+
+def test_servers_are_kept_apart(server, context):
+    cache = sabctools.SessionCache()
+    connect(server, context, cache)
+
+    sock = socket.create_connection((server.host, server.port))
+    with context.wrap_socket(sock, server_hostname=server.host, do_handshake_on_connect=False) as ssock:
+        assert cache.apply(ssock, server.host, server.port + 1) is False
+        assert cache.apply(ssock, "other.example", server.port) is False
+    assert cache.misses == 3
+
+
+def test_nothing_to_store_before_the_handshake(server, context):
+    cache = sabctools.SessionCache()
+    sock = socket.create_connection((server.host, server.port))
+    with context.wrap_socket(sock, server_hostname=server.host, do_handshake_on_connect=False) as ssock:
+        assert cache.store(ssock, server.host, server.port) is False
+    assert len(cache) == 0
+
+
+def test_clear(server, context):
+    cache = sabctools.SessionCache()
+    connect(server, context, cache)
+    cache.clear()
+    assert len(cache) == 0
+    assert connect(server, context, cache)[0] is False
+    assert "servers=1" in repr(cache)
+
+
+def test_sslobject_is_accepted(context):
+    cache = sabctools.SessionCache()
+    ssl_object = context.wrap_bio(ssl.MemoryBIO(), ssl.MemoryBIO(), server_hostname=HOST)
+    assert cache.apply(ssl_object, HOST, 563) is False
+    assert cache.store(ssl_object, HOST, 563) is False
+
+
+def test_needs_an_ssl_connection():
+    cache = sabctools.SessionCache()
+    with pytest.raises(TypeError):
+        cache.apply(object(), HOST, 563)
+    with socket.socket() as plain:
+        with pytest.raises(TypeError):
+            cache.store(plain, HOST, 563)
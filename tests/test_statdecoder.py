@@ -0,0 +1,127 @@
+import pytest
+
+from tests.testsupport import *
+
+
+def feed(decoder, wire: bytes, chunk: int = 1 << 20):
+    position = 0
+    while position < len(wire):
+        view = memoryview(decoder)
+        n = min(len(view), chunk, len(wire) - position)
+        view[:n] = wire[position : position + n]
+        view.release()
+        decoder.process(n)
+        position += n
+
+
+def stat_replies(codes) -> bytes:
+    return b"".join(b"%d 0 <%d@x>\r\n" % (code, n) for n, code in enumerate(codes))
+
+
+@pytest.mark.parametrize("chunk", [1, 5, 1024])
+def test_codes_in_request_order(chunk):
+    codes = [223, 430, 223, 223, 430] * 400
+    decoder = sabctools.StatDecoder(1024)
+    decoder.reset(len(codes))
+    feed(decoder, stat_replies(codes), chunk)
+
+    assert decoder.received == len(codes)
+    assert decoder.count == len(codes)
+    assert list(decoder.codes) == codes
+
+
+def test_unanswered_requests_are_zero():
+    decoder = sabctools.StatDecoder(1024)
+    decoder.reset(4)
+    feed(decoder, stat_replies([223, 430]) + b"223 0 <partial")
+    assert decoder.received == 2
+    assert list(decoder.codes) == [223, 430, 0, 0]
+
+
+def test_codes_view_is_live():
+    decoder = sabctools.StatDecoder(1024)
+    decoder.reset(2)
+    codes = decoder.codes
+    feed(decoder, stat_replies([430, 223]))
+    assert codes.format == "h"
+    assert list(codes) == [430, 223]
+
+
+def test_head_and_article_bodies_are_skipped():
+    article = bytes(read_plain_yenc_file("test_article.yenc"))
+    wire = (
+        stat_replies([223])
+        + b"221 0 <a@b>\r\nSubject: 223 looks like a code\r\n..stuffed\r\n.\r\n"
+        + article
+        + stat_replies([430])
+    )
+    decoder = sabctools.StatDecoder(1024)
+    decoder.reset(4)
+    feed(decoder, wire, 100)
+    assert list(decoder.codes) == [223, 221, 220, 430]
+
+
+def test_a_body_line_longer_than_the_buffer():
+    wire = b"222 0 <a@b>\r\n" + b"x" * 5000 + b"\r\n.\r\n" + stat_replies([223])
+    decoder = sabctools.StatDecoder(1024)
+    decoder.reset(2)
+    feed(decoder, wire)
+    assert list(decoder.codes) == [222, 223]
+
+
+def test_a_status_line_longer_than_the_buffer():
+    wire = b"430 " + b"x" * 3000 + b"\r\n" + stat_replies([223])
+    decoder = sabctools.StatDecoder(1024)
+    decoder.reset(2)
+    feed(decoder, wire)
+    assert list(decoder.codes) == [430, 223]
+
+
+def test_bare_lf_and_garbage():
+    decoder = sabctools.StatDecoder(1024)
+    decoder.reset(3)
+    feed(decoder, b"223 ok\nnonsense\r\n4\r\n")
+    assert list(decoder.codes) == [223, -1, -1]
+
+
+def test_reset_keeps_the_previous_batch():
+    decoder = sabctools.StatDecoder(1024)
+    decoder.reset(2)
+    feed(decoder, stat_replies([223, 430]))
+    first = decoder.codes
+
+    decoder.reset(1)
+    feed(decoder, stat_replies([430]))
+    assert list(first) == [223, 430]
+    assert list(decoder.codes) == [430]
+    assert decoder.received == 1
+
+
+def test_more_replies_than_requests():
+    decoder = sabctools.StatDecoder(1024)
+    decoder.reset(1)
+    with pytest.raises(ValueError):
+        feed(decoder, stat_replies([223, 223]))
+    assert decoder.received == 1
+
+    # The line that did not fit is not counted twice after the next reset
+    decoder.reset(1)
+    feed(decoder, stat_replies([430]))
+    assert list(decoder.codes) == [430]
+
+
+def test_before_reset():
+    decoder = sabctools.StatDecoder(1024)
+    assert decoder.codes is None
+    with pytest.raises(ValueError):
+        feed(decoder, stat_replies([223]))
+
+
+def test_length_checks():
+    decoder = sabctools.StatDecoder(1024)
+    with pytest.raises(ValueError):
+        decoder.process(0)
+    with pytest.raises(ValueError):
+        decoder.process(len(memoryview(decoder)) + 1)
+    with pytest.raises(ValueError):
+        decoder.reset(-1)
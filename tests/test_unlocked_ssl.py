@@ -350,3 +350,242 @@ def test_unlocked_ssl_recv_into_ref_counts_unchanged(client, buffer):
     after = [sys.getrefcount(x) for x in objects]
 
     assert after == before
+
+
+def unlocked_ssl_send_all(sock: ssl.SSLSocket, data) -> bytes:
+    """Send everything with unlocked_ssl_send while draining the echo, so neither side
+    stalls on a full socket buffer, and return what came back"""
+    view = memoryview(data)
+    sent = 0
+    echoed = bytearray()
+    buffer = bytearray(65536)
+    while sent < len(view) or len(echoed) < len(view):
+        if sent < len(view):
+            try:
+                sent += sabctools.unlocked_ssl_send(sock, view[sent:])
+            except ssl.SSLWantWriteError:
+                pass
+        try:
+            count = sabctools.unlocked_ssl_recv_into(sock, buffer)
+            echoed += buffer[:count]
+        except ssl.SSLWantReadError:
+            select.select([sock], [sock] if sent < len(view) else [], [], 1)
+    return bytes(echoed)
+
+
+def test_unlocked_ssl_send_not_a_socket_fails():
+    with pytest.raises(TypeError, match=r"argument 1 must be SSLSocket"):
+        sabctools.unlocked_ssl_send("this is not a socket", b"TEST")
+
+
+def test_unlocked_ssl_send_not_a_buffer_fails(client):
+    with pytest.raises(TypeError, match=r"bytes-like object is required"):
+        sabctools.unlocked_ssl_send(client, "TEST")
+
+
+def test_unlocked_ssl_send(client, buffer):
+    assert sabctools.unlocked_ssl_send(client, b"TEST") == 4
+    data_position = 0
+    while data_position < 4:
+        try:
+            data_position += sabctools.unlocked_ssl_recv_into(client, buffer[data_position:])
+        except ssl.SSLWantReadError:
+            select.select([client], [], [], 1)
+    assert buffer[:4].tobytes() == b"TEST"
+
+
+def test_unlocked_ssl_send_memoryview_slice(client):
+    """Any buffer is accepted, so encoder output can be sent from where it lies"""
+    data = bytearray(b"xxxxHello Worldxxxx")
+    assert unlocked_ssl_send_all(client, memoryview(data)[4:-4]) == b"Hello World"
+
+
+def test_unlocked_ssl_send_bulk(client):
+    """Far more than the socket buffers hold, so WANT_WRITE has to come up and the
+    retries have to deliver every byte exactly once and in order"""
+    data = bytes(range(256)) * 16384
+    assert unlocked_ssl_send_all(client, data) == data
+
+
+def test_unlocked_ssl_send_empty(client):
+    assert sabctools.unlocked_ssl_send(client, b"") == 0
+
+
+def test_unlocked_ssl_send_blocking_socket_fails(client):
+    client.setblocking(True)
+    with pytest.raises(ValueError, match="Only non-blocking sockets are supported"):
+        sabctools.unlocked_ssl_send(client, b"TEST")
+
+
+def test_unlocked_ssl_send_after_close(client):
+    client.close()
+    with pytest.raises(ValueError, match="Could not find _sslobj attribute"):
+        sabctools.unlocked_ssl_send(client, b"TEST")
+
+
+def test_unlocked_ssl_send_ref_counts_unchanged(client):
+    data = memoryview(bytearray(b"Hello World"))
+    objects = [client, client._sslobj, data]
+    before = [sys.getrefcount(x) for x in objects]
+    assert unlocked_ssl_send_all(client, data) == b"Hello World"
+    after = [sys.getrefcount(x) for x in objects]
+    assert after == before
+
+
+class MemoryPair:
+    """A client and server SSLObject joined only through memory, so the records the
+    client decrypts are exactly the ones the test chose to hand it"""
+
+    def __init__(self):
+        server_context = ssl.create_default_context(ssl.Purpose.CLIENT_AUTH)
+        with tempfile.TemporaryDirectory() as tmp:
+            certfile = os.path.join(tmp, "cert.pem")
+            keyfile = os.path.join(tmp, "key.pem")
+            with open(certfile, "w") as f:
+                f.write(cert)
+            with open(keyfile, "w") as f:
+                f.write(key)
+            server_context.load_cert_chain(certfile=certfile, keyfile=keyfile)
+        client_context = ssl.create_default_context(ssl.Purpose.SERVER_AUTH)
+        client_context.check_hostname = False
+        client_context.verify_mode = ssl.VerifyMode.CERT_NONE
+
+        self.client_in, self.client_out = ssl.MemoryBIO(), ssl.MemoryBIO()
+        self.server_in, self.server_out = ssl.MemoryBIO(), ssl.MemoryBIO()
+        self.client = client_context.wrap_bio(self.client_in, self.client_out, server_hostname=HOST)
+        self.server = server_context.wrap_bio(self.server_in, self.server_out, server_side=True)
+        self.handshake()
+
+    def handshake(self):
+        done = set()
+        while len(done) < 2:
+            for name, side in (("client", self.client), ("server", self.server)):
+                try:
+                    side.do_handshake()
+                    done.add(name)
+                except ssl.SSLWantReadError:
+                    pass
+                self.server_in.write(self.client_out.read())
+                self.client_in.write(self.server_out.read())
+
+    def send_to_client(self, data: bytes) -> bytes:
+        """What the server puts on the wire for data, as the client's socket would receive it"""
+        view = memoryview(data)
+        while view:
+            view = view[self.server.write(view) :]
+        return self.server_out.read()
+
+
+def test_unlocked_ssl_decrypt_into():
+    pair = MemoryPair()
+    ciphertext = pair.send_to_client(b"Hello World")
+    buffer = bytearray(100)
+    count = sabctools.unlocked_ssl_decrypt_into(pair.client, ciphertext, buffer)
+    assert buffer[:count] == b"Hello World"
+
+
+def test_unlocked_ssl_decrypt_into_needs_more_ciphertext():
+    pair = MemoryPair()
+    ciphertext = pair.send_to_client(b"Hello World")
+    buffer = bytearray(100)
+    with pytest.raises(ssl.SSLWantReadError):
+        sabctools.unlocked_ssl_decrypt_into(pair.client, ciphertext[:10], buffer)
+    count = sabctools.unlocked_ssl_decrypt_into(pair.client, ciphertext[10:], buffer)
+    assert buffer[:count] == b"Hello World"
+
+
+def test_unlocked_ssl_decrypt_into_leftover_plaintext():
+    """Plaintext that did not fit is kept by OpenSSL and collected by a later call"""
+    pair = MemoryPair()
+    data = os.urandom(100000)
+    ciphertext = pair.send_to_client(data)
+    received = bytearray()
+    buffer = bytearray(7000)
+    count = sabctools.unlocked_ssl_decrypt_into(pair.client, ciphertext, buffer)
+    while count:
+        received += buffer[:count]
+        try:
+            count = sabctools.unlocked_ssl_decrypt_into(pair.client, b"", buffer)
+        except ssl.SSLWantReadError:
+            break
+    assert received == data
+
+
+def test_unlocked_ssl_decrypt_into_decoder():
+    """Decrypted straight into the decoder's ring, with no bytes object in between"""
+    pair = MemoryPair()
+    article = bytes(read_plain_yenc_file("test_regular.yenc"))
+    ciphertext = pair.send_to_client(article)
+
+    decoder = sabctools.Decoder(len(article))
+    # Arbitrary slices of the wire, as recv() would deliver them
+    for start in range(0, len(ciphertext), 5000):
+        step = ciphertext[start : start + 5000]
+        while True:
+            try:
+                count = sabctools.unlocked_ssl_decrypt_into(pair.client, step, decoder)
+            except ssl.SSLWantReadError:
+                break
+            decoder.process(count)
+            step = b""
+    response = next(decoder)
+    assert response.bytes_decoded == 384000
+    assert response.crc == response.crc_expected
+
+
+def test_unlocked_ssl_decrypt_into_from_many_threads():
+    """Each connection is decrypted on whichever pool thread picks it up"""
+    from concurrent.futures import ThreadPoolExecutor
+
+    pairs = [MemoryPair() for _ in range(8)]
+    payloads = [os.urandom(300000) for _ in pairs]
+    wires = [pair.send_to_client(payload) for pair, payload in zip(pairs, payloads)]
+
+    def drain(index):
+        buffer = bytearray(len(payloads[index]))
+        count = sabctools.unlocked_ssl_decrypt_into(pairs[index].client, wires[index], buffer)
+        while count < len(buffer):
+            count += sabctools.unlocked_ssl_decrypt_into(pairs[index].client, b"", memoryview(buffer)[count:])
+        return bytes(buffer)
+
+    with ThreadPoolExecutor(4) as pool:
+        assert list(pool.map(drain, range(len(pairs)))) == payloads
+
+
+def test_unlocked_ssl_decrypt_into_one_thread_at_a_time():
+    """A second thread on the same SSLObject would corrupt the stream, so it is refused"""
+    pair = MemoryPair()
+    wire = pair.send_to_client(os.urandom(20_000_000))
+    buffer = bytearray(20_000_000)
+    worker = threading.Thread(target=sabctools.unlocked_ssl_decrypt_into, args=(pair.client, wire, buffer))
+    refused = 0
+    worker.start()
+    while worker.is_alive():
+        try:
+            sabctools.unlocked_ssl_decrypt_into(pair.client, b"", bytearray(10))
+        except RuntimeError:
+            refused += 1
+        except ssl.SSLError:
+            pass
+    worker.join()
+    assert refused
+
+
+def test_unlocked_ssl_decrypt_into_after_close_notify():
+    pair = MemoryPair()
+    try:
+        pair.server.unwrap()
+    except ssl.SSLWantReadError:
+        pass
+    assert sabctools.unlocked_ssl_decrypt_into(pair.client, pair.server_out.read(), bytearray(10)) == 0
+
+
+def test_unlocked_ssl_decrypt_into_needs_an_sslobject(client):
+    with pytest.raises(TypeError, match=r"argument 1 must be SSLObject"):
+        sabctools.unlocked_ssl_decrypt_into(client, b"", bytearray(10))
+
+
+def test_unlocked_ssl_decrypt_into_full_buffer_fails():
+    pair = MemoryPair()
+    with pytest.raises(ValueError, match="No space left in buffer"):
+        sabctools.unlocked_ssl_decrypt_into(pair.client, b"", bytearray())
@@ -47,12 +47,188 @@ COPY_FILES = ("CMakeLists.txt", "rapidyenc.h", "rapidyenc.cc", "README.md")
 
 
 def apply_patches():
-    """No local patches.
+    """Local fixes to upstream, each described in VENDOR.md.
 
     Upstream leaves CMAKE_MSVC_RUNTIME_LIBRARY alone, so its default of /MD already suits
-    a CPython extension and there is nothing to patch for that. Kept as the place to add
-    one, and vendor_common.patch() fails loudly once a patch stops matching.
+    a CPython extension and there is nothing to patch for that. vendor_common.patch()
+    fails loudly once a patch stops matching.
     """
+    # Incremental encoding: a chunk ending on the last character of a line left the
+    # column one short, so the next call wrote a second "last" character instead of the
+    # line break. Both scalar paths, the generic encoder and the tail of the SIMD ones,
+    # now count that character, and a column of line_size means a line break is due -
+    # which is how the SIMD kernels already read it on entry.
+    vendor_common.patch(
+        DEST,
+        os.path.join("src", "encoder.cc"),
+        """			if (RapidYenc::escapedLUT[c] && c != '.'-42) {
+				memcpy(p, &RapidYenc::escapedLUT[c], sizeof(uint16_t));
+				p += 2;
+			} else {
+				*(p++) = c + 42;
+			}
+		}
+""",
+        """			if (RapidYenc::escapedLUT[c] && c != '.'-42) {
+				memcpy(p, &RapidYenc::escapedLUT[c], sizeof(uint16_t));
+				p += 2;
+				col += 2;
+			} else {
+				*(p++) = c + 42;
+				col++;
+			}
+		}
+""",
+        "count the last character of a line in the generic encoder's column",
+    )
+    vendor_common.patch(
+        DEST,
+        os.path.join("src", "encoder_common.h"),
+        """				if (RapidYenc::escapedLUT[c] && c != '.'-42) {
+					memcpy(p, RapidYenc::escapedLUT + c, 2);
+					p += 2;
+				} else {
+					*(p++) = c + 42;
+				}
+				if(i == 0) break;
+""",
+        """				if (RapidYenc::escapedLUT[c] && c != '.'-42) {
+					memcpy(p, RapidYenc::escapedLUT + c, 2);
+					p += 2;
+					(*colOffset) += 2;
+				} else {
+					*(p++) = c + 42;
+					(*colOffset)++;
+				}
+				if(i == 0) break;
+""",
+        "count the last character of a line in the SIMD encoders' scalar tail",
+    )
+
+    # Decode and CRC in one pass over the data. The output of each block is hashed
+    # while it is still in L1, rather than streamed back in from L2 or memory once the
+    # whole chunk has been decoded.
+    vendor_common.patch(
+        DEST,
+        "rapidyenc.h",
+        """RAPIDYENC_API RapidYencDecoderEnd rapidyenc_decode_incremental(const void** src, void** dest, size_t src_length, RapidYencDecoderState* state);
+""",
+        """RAPIDYENC_API RapidYencDecoderEnd rapidyenc_decode_incremental(const void** src, void** dest, size_t src_length, RapidYencDecoderState* state);
+
+#ifndef RAPIDYENC_DISABLE_CRC
+/**
+ * Like `rapidyenc_decode_incremental`, but also folds the decoded bytes into `*crc`
+ * The result is the same as following it with `*crc = rapidyenc_crc(dest_before, dest_after - dest_before, *crc)`, except that
+ * the input is decoded in blocks small enough to stay in L1 cache, and each block's output is hashed right after it is written
+ * `rapidyenc_crc_init` must have been called as well as `rapidyenc_decode_init`
+ */
+RAPIDYENC_API RapidYencDecoderEnd rapidyenc_decode_incremental_crc(const void** src, void** dest, size_t src_length, RapidYencDecoderState* state, uint32_t* crc);
+#endif
+""",
+        "declare rapidyenc_decode_incremental_crc",
+    )
+    vendor_common.patch(
+        DEST,
+        "rapidyenc.cc",
+        """int rapidyenc_crc_kernel() {
+	return RapidYenc::crc32_isa_level();
+}
+""",
+        """int rapidyenc_crc_kernel() {
+	return RapidYenc::crc32_isa_level();
+}
+
+#ifndef RAPIDYENC_DISABLE_DECODE
+// Input per block: with its output, at most as large again, this still fits a 32KB L1
+#define RAPIDYENC_FUSED_BLOCK 16384
+RapidYencDecoderEnd rapidyenc_decode_incremental_crc(const void** src, void** dest, size_t src_length, RapidYencDecoderState* state, uint32_t* crc) {
+	RapidYencDecoderState unusedState = RYDEC_STATE_CRLF;
+	if(!state) state = &unusedState;
+	uint32_t running = *crc;
+	RapidYenc::YencDecoderEnd ended = RapidYenc::YDEC_END_NONE;
+	while(src_length) {
+		// end blocks on a 64-byte boundary, so the SIMD kernels' alignment prologue only runs once
+		size_t block = RAPIDYENC_FUSED_BLOCK - ((uintptr_t)*src & 63);
+		if(block > src_length) block = src_length;
+		unsigned char* out = (unsigned char*)*dest;
+		ended = RapidYenc::decode_end(src, dest, block, (RapidYenc::YencDecoderState*)state);
+		running = RapidYenc::crc32(out, (unsigned char*)*dest - out, running);
+		if(ended != RapidYenc::YDEC_END_NONE) break;
+		src_length -= block;
+	}
+	*crc = running;
+	return (RapidYencDecoderEnd)ended;
+}
+#endif
+""",
+        "add rapidyenc_decode_incremental_crc",
+    )
+
+    # The same for encoding: hash each block of input while the encoder has just
+    # loaded it, rather than reading the whole input a second time afterwards.
+    vendor_common.patch(
+        DEST,
+        "rapidyenc.h",
+        """RAPIDYENC_API size_t rapidyenc_encode_ex(int line_size, int* column, const void* __restrict src, void* __restrict dest, size_t src_length, int is_end);
+""",
+        """RAPIDYENC_API size_t rapidyenc_encode_ex(int line_size, int* column, const void* __restrict src, void* __restrict dest, size_t src_length, int is_end);
+
+#ifndef RAPIDYENC_DISABLE_CRC
+/**
+ * Like `rapidyenc_encode_ex`, but also folds the source data into `*crc`
+ * The result is the same as following it with `*crc = rapidyenc_crc(src, src_length, *crc)`, except that the source is
+ * encoded in blocks small enough to stay in L1 cache, and each block is hashed right after it was encoded
+ * `rapidyenc_crc_init` must have been called as well as `rapidyenc_encode_init`
+ */
+RAPIDYENC_API size_t rapidyenc_encode_ex_crc(int line_size, int* column, const void* __restrict src, void* __restrict dest, size_t src_length, int is_end, uint32_t* crc);
+#endif
+""",
+        "declare rapidyenc_encode_ex_crc",
+    )
+    vendor_common.patch(
+        DEST,
+        "rapidyenc.cc",
+        """	*crc = running;
+	return (RapidYencDecoderEnd)ended;
+}
+#endif
+""",
+        """	*crc = running;
+	return (RapidYencDecoderEnd)ended;
+}
+#endif
+
+#ifndef RAPIDYENC_DISABLE_ENCODE
+// Input per block: typical output is barely larger, so both usually fit a 32KB L1
+#define RAPIDYENC_FUSED_ENCODE_BLOCK 16384
+size_t rapidyenc_encode_ex_crc(int line_size, int* column, const void* __restrict src, void* __restrict dest, size_t src_length, int is_end, uint32_t* crc) {
+	int unusedColumn = 0;
+	if(!column) column = &unusedColumn;
+	// nothing to interleave with a single block: the separate calls do the same work
+	if(src_length <= RAPIDYENC_FUSED_ENCODE_BLOCK) {
+		size_t written = RapidYenc::encode(line_size, column, src, dest, src_length, is_end);
+		*crc = RapidYenc::crc32(src, src_length, *crc);
+		return written;
+	}
+	const unsigned char* in = (const unsigned char*)src;
+	unsigned char* out = (unsigned char*)dest;
+	uint32_t running = *crc;
+	while(src_length) {
+		// end blocks on a 64-byte boundary, so every block's vector loads stay aligned
+		size_t block = RAPIDYENC_FUSED_ENCODE_BLOCK - ((uintptr_t)in & 63);
+		if(block > src_length) block = src_length;
+		out += RapidYenc::encode(line_size, column, in, out, block, is_end && block == src_length);
+		running = RapidYenc::crc32(in, block, running);
+		in += block;
+		src_length -= block;
+	}
+	*crc = running;
+	return out - (unsigned char*)dest;
+}
+#endif
+""",
+        "add rapidyenc_encode_ex_crc",
+    )
 
 
 def write_vendor_notes(commit: str, ref: str):
@@ -98,8 +274,23 @@ and are not part of its compatibility promise.
 
 ### Local patches
 
-None. The vendoring script fails loudly if a patch it carries stops matching, so this
-section is the one to check when adding one.
+Applied by `apply_patches()` in the vendoring script, which fails loudly if one stops
+matching - either upstream fixed it, and the patch goes, or the code moved.
+
+- `src/encoder.cc`, `src/encoder_common.h`: incremental encoding
+  (`rapidyenc_encode_ex` with a column) lost track of the column when a chunk ended on
+  the last character of a line, and the next call wrote another character onto that line
+  instead of breaking it. The generic encoder and the scalar tail of the SIMD encoders
+  now count that character, so a column of `line_size` means a line break is due next,
+  as the SIMD kernels already assumed. Output of a single call is unchanged.
+- `rapidyenc.h`, `rapidyenc.cc`: `rapidyenc_decode_incremental_crc`, which decodes and
+  folds the output into a CRC32 in one pass. The input is decoded in 16KB blocks and each
+  block's output is hashed straight after, while it is still in L1, instead of hashing a
+  whole chunk afterwards from L2 or memory. The kernels themselves are untouched.
+- `rapidyenc.h`, `rapidyenc.cc`: `rapidyenc_encode_ex_crc`, the encoding counterpart. It
+  encodes in 16KB blocks and hashes each block of source straight after, so the source is
+  read from memory once. Relies on the column patch above for blocks to join seamlessly;
+  an input of one block or less takes the plain encode-then-hash path.
 """.format(repo=REPO, ref=ref, commit=commit, date=datetime.date.today().isoformat())
         )
 